@@ -0,0 +1,434 @@
+﻿#include "LDAPBatch.h"
+#include "LDAPConverters.h"
+#include "LDAPExporter.h"
+#include "LDAPSchema.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        struct JsonValue
+        {
+            enum class Type { Null, Bool, Number, String, Array, Object };
+            Type type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::wstring str;
+            std::vector<JsonValue> items;
+            std::vector<std::pair<std::wstring, JsonValue>> members;
+        };
+
+        // Small recursive-descent reader, enough for query lists
+        class JsonReader
+        {
+        private:
+            const std::wstring& text;
+            size_t pos = 0;
+
+            void SkipSpace()
+            {
+                while (pos < text.size() && iswspace(text[pos])) ++pos;
+            }
+
+            bool ParseString(std::wstring& out)
+            {
+                if (text[pos] != L'"') return false;
+                ++pos;
+                while (pos < text.size() && text[pos] != L'"')
+                {
+                    wchar_t c = text[pos++];
+                    if (c != L'\\')
+                    {
+                        out += c;
+                        continue;
+                    }
+                    if (pos >= text.size()) return false;
+                    c = text[pos++];
+                    switch (c)
+                    {
+                    case L'n': out += L'\n'; break;
+                    case L'r': out += L'\r'; break;
+                    case L't': out += L'\t'; break;
+                    case L'b': out += L'\b'; break;
+                    case L'f': out += L'\f'; break;
+                    case L'u':
+                        if (pos + 4 > text.size()) return false;
+                        out += static_cast<wchar_t>(wcstoul(text.substr(pos, 4).c_str(), nullptr, 16));
+                        pos += 4;
+                        break;
+                    default: out += c; break;
+                    }
+                }
+                if (pos >= text.size()) return false;
+                ++pos;
+                return true;
+            }
+
+        public:
+            explicit JsonReader(const std::wstring& text) : text(text) {}
+
+            bool Parse(JsonValue& out)
+            {
+                SkipSpace();
+                if (pos >= text.size()) return false;
+
+                wchar_t c = text[pos];
+                if (c == L'"')
+                {
+                    out.type = JsonValue::Type::String;
+                    return ParseString(out.str);
+                }
+                if (c == L'[' || c == L'{')
+                {
+                    bool isArray = (c == L'[');
+                    out.type = isArray ? JsonValue::Type::Array : JsonValue::Type::Object;
+                    ++pos;
+                    SkipSpace();
+                    if (pos < text.size() && text[pos] == (isArray ? L']' : L'}'))
+                    {
+                        ++pos;
+                        return true;
+                    }
+                    while (true)
+                    {
+                        JsonValue item;
+                        if (isArray)
+                        {
+                            if (!Parse(item)) return false;
+                            out.items.push_back(std::move(item));
+                        }
+                        else
+                        {
+                            std::wstring key;
+                            SkipSpace();
+                            if (pos >= text.size() || !ParseString(key)) return false;
+                            SkipSpace();
+                            if (pos >= text.size() || text[pos++] != L':') return false;
+                            if (!Parse(item)) return false;
+                            out.members.emplace_back(key, std::move(item));
+                        }
+                        SkipSpace();
+                        if (pos >= text.size()) return false;
+                        wchar_t sep = text[pos++];
+                        if (sep == (isArray ? L']' : L'}')) return true;
+                        if (sep != L',') return false;
+                    }
+                }
+                if (text.compare(pos, 4, L"true") == 0 || text.compare(pos, 5, L"false") == 0)
+                {
+                    out.type = JsonValue::Type::Bool;
+                    out.boolean = (c == L't');
+                    pos += out.boolean ? 4 : 5;
+                    return true;
+                }
+                if (text.compare(pos, 4, L"null") == 0)
+                {
+                    pos += 4;
+                    return true;
+                }
+
+                wchar_t* end = nullptr;
+                out.type = JsonValue::Type::Number;
+                out.number = wcstod(text.c_str() + pos, &end);
+                if (end == text.c_str() + pos) return false;
+                pos = end - text.c_str();
+                return true;
+            }
+
+            bool AtEnd()
+            {
+                SkipSpace();
+                return pos >= text.size();
+            }
+        };
+
+        bool ParseScope(const std::wstring& scope, unsigned long& outScope)
+        {
+            if (scope == L"base" || scope == L"0") outScope = 0;
+            else if (scope == L"one" || scope == L"1") outScope = 1;
+            else if (scope == L"sub" || scope == L"2") outScope = 2;
+            else return false;
+            return true;
+        }
+
+        std::vector<std::wstring> TokenizeLine(const std::wstring& line)
+        {
+            std::vector<std::wstring> tokens;
+            std::wstring current;
+            bool inQuotes = false;
+            bool hasToken = false;
+            for (size_t i = 0; i < line.size(); ++i)
+            {
+                wchar_t c = line[i];
+                if (c == L'\\' && inQuotes && i + 1 < line.size() && line[i + 1] == L'"')
+                {
+                    current += L'"';
+                    ++i;
+                }
+                else if (c == L'"')
+                {
+                    inQuotes = !inQuotes;
+                    hasToken = true;
+                }
+                else if (!inQuotes && iswspace(c))
+                {
+                    if (hasToken) tokens.push_back(current);
+                    current.clear();
+                    hasToken = false;
+                }
+                else
+                {
+                    current += c;
+                    hasToken = true;
+                }
+            }
+            if (hasToken) tokens.push_back(current);
+            return tokens;
+        }
+
+        bool ApplyOption(const std::wstring& name, const std::wstring& value, SearchConfig& query)
+        {
+            if (name == L"-b" || name == L"--basedn" || name == L"base") query.baseDN = value;
+            else if (name == L"-f" || name == L"--filter" || name == L"filter") query.filter = value;
+            else if (name == L"-a" || name == L"--attributes" || name == L"attributes") query.attributesStr = value;
+            else if (name == L"-o" || name == L"--output" || name == L"output") query.outputFile = value;
+            else if (name == L"--scope" || name == L"scope") return ParseScope(value, query.scope);
+            else if (name == L"--limit" || name == L"limit") query.sizeLimit = wcstoul(value.c_str(), nullptr, 10);
+            else if (name == L"--sort" || name == L"sort") query.sortKeys = value;
+            else if (name == L"--window" || name == L"window") return LDAPConnection::ParseWindow(value, query);
+            else if (name == L"-t" || name == L"--type" || name == L"format") return Exporter::ParseFormat(value, query.format);
+            else return false;
+            return true;
+        }
+
+        std::wstring JsonScalarToString(const JsonValue& value)
+        {
+            if (value.type == JsonValue::Type::String) return value.str;
+            if (value.type == JsonValue::Type::Number)
+            {
+                std::wstringstream ss;
+                ss << static_cast<long long>(value.number);
+                return ss.str();
+            }
+            if (value.type == JsonValue::Type::Array)
+            {
+                // "attributes": ["cn", "mail"]
+                std::wstring joined;
+                for (const auto& item : value.items)
+                {
+                    if (!joined.empty()) joined += L",";
+                    joined += JsonScalarToString(item);
+                }
+                return joined;
+            }
+            return L"";
+        }
+
+        SearchConfig QueryBase(const SearchConfig& defaults)
+        {
+            SearchConfig query = defaults;
+            query.outputFile.clear();
+            query.searchMode = SearchMode::STANDARD;
+            query.quiet = true;
+            return query;
+        }
+    }
+
+    bool BatchRunner::LoadQueries(const std::wstring& filename, const SearchConfig& defaults,
+        std::vector<SearchConfig>& outQueries)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::wcerr << L"Failed to open batch file: " << filename << std::endl;
+            return false;
+        }
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        std::string content = buffer.str();
+        if (content.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            content.erase(0, 3);
+        std::wstring text = Converters::StringToWString(content);
+
+        std::vector<SearchConfig> queries;
+        size_t first = text.find_first_not_of(L" \t\r\n");
+        if (first != std::wstring::npos && text[first] == L'[')
+        {
+            JsonValue root;
+            JsonReader reader(text);
+            if (!reader.Parse(root) || !reader.AtEnd() || root.type != JsonValue::Type::Array)
+            {
+                std::wcerr << L"Invalid JSON batch file: " << filename << std::endl;
+                return false;
+            }
+
+            for (size_t i = 0; i < root.items.size(); ++i)
+            {
+                const JsonValue& item = root.items[i];
+                if (item.type != JsonValue::Type::Object)
+                {
+                    std::wcerr << L"Batch query " << (i + 1) << L" is not an object" << std::endl;
+                    return false;
+                }
+
+                SearchConfig query = QueryBase(defaults);
+                for (const auto& member : item.members)
+                {
+                    if (!ApplyOption(member.first, JsonScalarToString(member.second), query))
+                    {
+                        std::wcerr << L"Batch query " << (i + 1) << L": invalid \"" << member.first << L"\"" << std::endl;
+                        return false;
+                    }
+                }
+                queries.push_back(std::move(query));
+            }
+        }
+        else
+        {
+            std::wstringstream lines(text);
+            std::wstring line;
+            int lineNumber = 0;
+            while (std::getline(lines, line))
+            {
+                ++lineNumber;
+                std::vector<std::wstring> tokens = TokenizeLine(line);
+                if (tokens.empty() || tokens[0][0] == L'#')
+                    continue;
+
+                SearchConfig query = QueryBase(defaults);
+                for (size_t t = 0; t < tokens.size(); t += 2)
+                {
+                    if (t + 1 >= tokens.size() || !ApplyOption(tokens[t], tokens[t + 1], query))
+                    {
+                        std::wcerr << L"Invalid batch line " << lineNumber << L" near: " << tokens[t] << std::endl;
+                        return false;
+                    }
+                }
+                queries.push_back(std::move(query));
+            }
+        }
+
+        // Give every exporting query its own file
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            if (queries[i].format != OutputFormat::CONSOLE_ONLY && queries[i].outputFile.empty())
+                queries[i].outputFile = L"batch_" + std::to_wstring(i + 1) + L"_" + Exporter::DefaultFileName(queries[i].format);
+        }
+
+        outQueries = std::move(queries);
+        return true;
+    }
+
+    int BatchRunner::Run(const SearchConfig& defaults, const std::vector<SearchConfig>& queries,
+        unsigned int maxParallel)
+    {
+        if (queries.empty())
+        {
+            std::wcout << L"No queries to run." << std::endl;
+            return 0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        size_t poolSize = std::min<size_t>(std::max(1u, maxParallel), queries.size());
+        LDAPConnectionPool pool;
+        if (!pool.Open(defaults, poolSize))
+        {
+            std::wcerr << L"✗ Failed to connect to LDAP server." << std::endl;
+            return static_cast<int>(queries.size());
+        }
+        double connectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::wcout << L"✓ " << pool.Size() << L" pooled connection(s) bound in "
+            << std::fixed << std::setprecision(1) << connectMs << L" ms" << std::endl;
+
+        LDAPConnection* schemaConnection = pool.Acquire();
+        Schema::Activate(schemaConnection, defaults, true);
+        pool.Release(schemaConnection);
+
+        std::vector<BatchResult> results(queries.size());
+        std::atomic<size_t> next(0);
+        std::mutex outputMutex;
+
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < queries.size(); i = next++)
+            {
+                BatchResult& result = results[i];
+                result.config = queries[i];
+
+                LDAPConnection* connection = pool.Acquire();
+                auto queryStart = std::chrono::steady_clock::now();
+                std::vector<Entry> entries;
+                Statistics stats;
+                result.success = connection->Search(queries[i], entries, stats);
+                result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - queryStart).count();
+                pool.Release(connection);
+                result.entryCount = static_cast<size_t>(stats.totalEntries);
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::wcout << (result.success ? L"  ✓ " : L"  ✗ ") << L"[" << (i + 1) << L"/" << queries.size() << L"] "
+                    << queries[i].filter << L" — " << result.entryCount << L" entries, "
+                    << std::fixed << std::setprecision(1) << result.elapsedMs << L" ms" << std::endl;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < pool.Size(); ++w)
+            workers.emplace_back(worker);
+        for (auto& w : workers)
+            w.join();
+
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        PrintReport(results, connectMs, totalMs);
+
+        return static_cast<int>(std::count_if(results.begin(), results.end(),
+            [](const BatchResult& r) { return !r.success; }));
+    }
+
+    void BatchRunner::PrintReport(const std::vector<BatchResult>& results, double connectMs, double totalMs)
+    {
+        std::wcout << L"\n╔═══════════════════════════════════════════════════════════════╗" << std::endl;
+        std::wcout << L"║                      BATCH TIMING REPORT                      ║" << std::endl;
+        std::wcout << L"╚═══════════════════════════════════════════════════════════════╝" << std::endl;
+
+        size_t succeeded = 0;
+        size_t totalEntries = 0;
+        double queryMs = 0.0;
+        double slowestMs = 0.0;
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BatchResult& r = results[i];
+            if (r.success) ++succeeded;
+            totalEntries += r.entryCount;
+            queryMs += r.elapsedMs;
+            slowestMs = std::max(slowestMs, r.elapsedMs);
+
+            std::wcout << L"  " << std::setw(3) << std::right << (i + 1) << L". "
+                << std::setw(8) << std::fixed << std::setprecision(1) << r.elapsedMs << L" ms  "
+                << std::setw(7) << r.entryCount << L" entries  "
+                << (r.success ? L"OK    " : L"FAILED") << L"  " << r.config.filter;
+            if (!r.config.outputFile.empty())
+                std::wcout << L" → " << r.config.outputFile;
+            std::wcout << std::endl;
+        }
+
+        std::wcout << L"\n  Queries:            " << results.size() << L" (" << succeeded << L" succeeded, "
+            << (results.size() - succeeded) << L" failed)" << std::endl;
+        std::wcout << L"  Total entries:      " << totalEntries << std::endl;
+        std::wcout << std::fixed << std::setprecision(1);
+        std::wcout << L"  Connect + bind:     " << connectMs << L" ms (once for the whole batch)" << std::endl;
+        std::wcout << L"  Sum of query time:  " << queryMs << L" ms" << std::endl;
+        std::wcout << L"  Average / slowest:  " << (queryMs / results.size()) << L" / " << slowestMs << L" ms" << std::endl;
+        std::wcout << L"  Wall clock:         " << totalMs << L" ms" << std::endl;
+        std::wcout << L"\n" << std::wstring(67, L'═') << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include "LDAPTypes.h"
+#include "LDAPConnection.h"
+
+namespace LDAPUtils
+{
+    struct BatchResult
+    {
+        SearchConfig config;
+        bool success = false;
+        size_t entryCount = 0;
+        double elapsedMs = 0.0;
+    };
+
+    class BatchRunner
+    {
+    public:
+        // Query file is either one query per line using the CLI search options
+        // (-b, -f, -a, --scope, --limit, -o, -t), or a JSON array of objects with
+        // "base", "filter", "attributes", "scope", "limit", "output", "format".
+        // Anything not given per query is taken from defaults.
+        static bool LoadQueries(const std::wstring& filename, const SearchConfig& defaults,
+            std::vector<SearchConfig>& outQueries);
+
+        // Runs the queries over a pool of maxParallel bound connections and prints
+        // an aggregate timing report. Returns the number of failed queries.
+        static int Run(const SearchConfig& defaults, const std::vector<SearchConfig>& queries,
+            unsigned int maxParallel);
+
+    private:
+        static void PrintReport(const std::vector<BatchResult>& results, double connectMs, double totalMs);
+    };
+}
\ No newline at end of file
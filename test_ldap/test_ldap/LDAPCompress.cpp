@@ -0,0 +1,688 @@
+﻿#include "LDAPCompress.h"
+#include <algorithm>
+#include <cwchar>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        const unsigned short kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        const unsigned char kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        const unsigned short kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        const unsigned char kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        const unsigned char kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        const int kMinMatch = 3;
+        const int kMaxMatch = 258;
+        const int kMaxChain = 32;           // Candidates tried per position
+        const int kNiceMatch = 128;         // Long enough to stop searching
+        const int kLazyMatch = 32;          // Shorter matches are retried one byte later
+        const int kHashBits = 15;
+        const size_t kBlockTokens = 32768;  // Symbols per DEFLATE block (one set of Huffman tables)
+
+        // Length code (0-28, symbol 257 + code) of each match length
+        struct LengthCodes
+        {
+            unsigned char code[kMaxMatch + 1] = {};
+
+            LengthCodes()
+            {
+                for (int k = 0; k < 29; ++k)
+                {
+                    for (int length = kLengthBase[k]; length < kLengthBase[k] + (1 << kLengthExtra[k]) && length <= kMaxMatch; ++length)
+                        code[length] = static_cast<unsigned char>(k);
+                }
+            }
+        };
+        const LengthCodes kLengthCodes;
+
+        int DistanceCode(unsigned int distance)
+        {
+            if (distance <= 4)
+                return distance - 1;
+            unsigned int d = distance - 1;
+            int bit = 14;
+            while (!(d >> bit))
+                --bit;
+            return 2 * bit + ((d >> (bit - 1)) & 1);
+        }
+
+        struct CrcTable
+        {
+            unsigned int entries[4][256];
+
+            CrcTable()
+            {
+                for (unsigned int n = 0; n < 256; ++n)
+                {
+                    unsigned int c = n;
+                    for (int k = 0; k < 8; ++k)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    entries[0][n] = c;
+                }
+                for (unsigned int n = 0; n < 256; ++n)
+                {
+                    for (int k = 1; k < 4; ++k)
+                        entries[k][n] = (entries[k - 1][n] >> 8) ^ entries[0][entries[k - 1][n] & 0xFF];
+                }
+            }
+        };
+        const CrcTable kCrcTable;
+
+        // Bits are packed least significant first, as DEFLATE requires
+        class BitWriter
+        {
+        private:
+            std::string& out;
+            unsigned long long bits = 0;
+            int count = 0;
+
+        public:
+            explicit BitWriter(std::string& out) : out(out) {}
+
+            void Put(unsigned int value, int length)
+            {
+                bits |= static_cast<unsigned long long>(value) << count;
+                count += length;
+                if (count >= 32)
+                {
+                    char bytes[4] = { static_cast<char>(bits), static_cast<char>(bits >> 8),
+                        static_cast<char>(bits >> 16), static_cast<char>(bits >> 24) };
+                    out.append(bytes, 4);
+                    bits >>= 32;
+                    count -= 32;
+                }
+            }
+
+            void Align()
+            {
+                while (count > 0)
+                {
+                    out.push_back(static_cast<char>(bits));
+                    bits >>= 8;
+                    count -= 8;
+                }
+                bits = 0;
+                count = 0;
+            }
+
+            // Only after Align
+            void Bytes(const unsigned char* data, size_t size)
+            {
+                out.append(reinterpret_cast<const char*>(data), size);
+            }
+        };
+
+        struct Token
+        {
+            unsigned short length;      // Literal byte when distance is 0
+            unsigned short distance;
+        };
+
+        // Huffman code lengths for freq[0, n), at most maxBits long; unused symbols
+        // get 0. Too deep a tree is rebuilt from flattened frequencies.
+        void BuildLengths(const unsigned int* freq, int n, int maxBits, unsigned char* lengths)
+        {
+            std::vector<unsigned int> weight(freq, freq + n);
+            for (;;)
+            {
+                std::fill(lengths, lengths + n, 0);
+                std::vector<int> leaves;
+                for (int s = 0; s < n; ++s)
+                {
+                    if (weight[s])
+                        leaves.push_back(s);
+                }
+                if (leaves.empty())
+                    return;
+                if (leaves.size() == 1)
+                {
+                    lengths[leaves[0]] = 1;
+                    return;
+                }
+                std::sort(leaves.begin(), leaves.end(), [&](int a, int b)
+                {
+                    return weight[a] != weight[b] ? weight[a] < weight[b] : a < b;
+                });
+
+                // Two queues: leaves in weight order, then merged nodes in the order
+                // they are made (which is also weight order)
+                const size_t m = leaves.size();
+                std::vector<unsigned long long> nodeWeight(2 * m - 1);
+                std::vector<size_t> parent(2 * m - 1, 0);
+                for (size_t k = 0; k < m; ++k)
+                    nodeWeight[k] = weight[leaves[k]];
+                size_t nextLeaf = 0, nextNode = m;
+                for (size_t node = m; node < 2 * m - 1; ++node)
+                {
+                    size_t pick[2];
+                    for (size_t& p : pick)
+                    {
+                        if (nextLeaf < m && (nextNode == node || nodeWeight[nextLeaf] <= nodeWeight[nextNode]))
+                            p = nextLeaf++;
+                        else
+                            p = nextNode++;
+                    }
+                    nodeWeight[node] = nodeWeight[pick[0]] + nodeWeight[pick[1]];
+                    parent[pick[0]] = parent[pick[1]] = node;
+                }
+
+                // Parents come after their children; the root is last
+                std::vector<int> depth(2 * m - 1, 0);
+                for (size_t node = 2 * m - 2; node-- > 0;)
+                    depth[node] = depth[parent[node]] + 1;
+                int maxDepth = 0;
+                for (size_t k = 0; k < m; ++k)
+                {
+                    lengths[leaves[k]] = static_cast<unsigned char>(std::min(depth[k], 255));
+                    maxDepth = std::max(maxDepth, depth[k]);
+                }
+                if (maxDepth <= maxBits)
+                    return;
+                for (auto& w : weight)
+                {
+                    if (w)
+                        w = (w >> 1) | 1;
+                }
+            }
+        }
+
+        // Canonical codes, bit-reversed for the LSB-first stream
+        void BuildCodes(const unsigned char* lengths, int n, unsigned short* codes)
+        {
+            int count[16] = { 0 };
+            for (int s = 0; s < n; ++s)
+                count[lengths[s]]++;
+            count[0] = 0;
+            int next[16] = { 0 };
+            int code = 0;
+            for (int bits = 1; bits < 16; ++bits)
+            {
+                code = (code + count[bits - 1]) << 1;
+                next[bits] = code;
+            }
+            for (int s = 0; s < n; ++s)
+            {
+                int length = lengths[s];
+                if (!length)
+                    continue;
+                int value = next[length]++;
+                int reversed = 0;
+                for (int k = 0; k < length; ++k)
+                    reversed |= ((value >> k) & 1) << (length - 1 - k);
+                codes[s] = static_cast<unsigned short>(reversed);
+            }
+        }
+
+        // zlib always sends at least two codes per tree; some decoders reject less
+        void EnsureTwoCodes(unsigned int* freq, int n)
+        {
+            int used = 0;
+            for (int s = 0; s < n; ++s)
+                used += freq[s] ? 1 : 0;
+            for (int s = 0; s < n && used < 2; ++s)
+            {
+                if (!freq[s])
+                {
+                    freq[s] = 1;
+                    ++used;
+                }
+            }
+        }
+
+        void WriteStored(BitWriter& writer, const unsigned char* data, size_t size, bool final)
+        {
+            size_t offset = 0;
+            do
+            {
+                size_t chunk = std::min<size_t>(size - offset, 65535);
+                writer.Put(final && offset + chunk == size ? 1 : 0, 1);
+                writer.Put(0, 2);
+                writer.Align();
+                unsigned char header[4] = { static_cast<unsigned char>(chunk), static_cast<unsigned char>(chunk >> 8),
+                    static_cast<unsigned char>(~chunk), static_cast<unsigned char>(~chunk >> 8) };
+                writer.Bytes(header, 4);
+                writer.Bytes(data + offset, chunk);
+                offset += chunk;
+            } while (offset < size);
+        }
+
+        // One block with its own dynamic Huffman tables, or stored blocks when
+        // that would be smaller (already compressed or random values)
+        void WriteBlock(BitWriter& writer, const std::vector<Token>& tokens, const unsigned char* raw, size_t rawSize, bool final)
+        {
+            unsigned int literalFreq[286] = { 0 };
+            unsigned int distanceFreq[30] = { 0 };
+            for (const auto& t : tokens)
+            {
+                if (t.distance == 0)
+                {
+                    literalFreq[t.length]++;
+                }
+                else
+                {
+                    literalFreq[257 + kLengthCodes.code[t.length]]++;
+                    distanceFreq[DistanceCode(t.distance)]++;
+                }
+            }
+            literalFreq[256] = 1;
+            EnsureTwoCodes(literalFreq, 286);
+            EnsureTwoCodes(distanceFreq, 30);
+
+            unsigned char literalLengths[286], distanceLengths[30];
+            BuildLengths(literalFreq, 286, 15, literalLengths);
+            BuildLengths(distanceFreq, 30, 15, distanceLengths);
+            int literalCount = 286;
+            while (literalCount > 257 && !literalLengths[literalCount - 1])
+                --literalCount;
+            int distanceCount = 30;
+            while (distanceCount > 1 && !distanceLengths[distanceCount - 1])
+                --distanceCount;
+
+            // Both length tables run-length coded as one sequence: 16 repeats the
+            // previous length 3-6 times, 17 and 18 are runs of 3-10 and 11-138 zeros
+            std::vector<unsigned char> lengths(literalLengths, literalLengths + literalCount);
+            lengths.insert(lengths.end(), distanceLengths, distanceLengths + distanceCount);
+            std::vector<std::pair<unsigned char, unsigned char>> runs;     // (symbol, extra bits value)
+            for (size_t i = 0; i < lengths.size();)
+            {
+                unsigned char length = lengths[i];
+                size_t run = 1;
+                while (i + run < lengths.size() && lengths[i + run] == length)
+                    ++run;
+                if (length == 0 && run >= 3)
+                {
+                    size_t count = std::min<size_t>(run, 138);
+                    runs.emplace_back(count >= 11 ? 18 : 17, static_cast<unsigned char>(count >= 11 ? count - 11 : count - 3));
+                    i += count;
+                }
+                else if (length != 0 && run >= 4)
+                {
+                    size_t count = std::min<size_t>(run - 1, 6);
+                    runs.emplace_back(length, 0);
+                    runs.emplace_back(16, static_cast<unsigned char>(count - 3));
+                    i += 1 + count;
+                }
+                else
+                {
+                    runs.emplace_back(length, 0);
+                    ++i;
+                }
+            }
+            unsigned int codeLengthFreq[19] = { 0 };
+            for (const auto& run : runs)
+                codeLengthFreq[run.first]++;
+            unsigned char codeLengthLengths[19];
+            BuildLengths(codeLengthFreq, 19, 7, codeLengthLengths);
+            int codeLengthCount = 19;
+            while (codeLengthCount > 4 && !codeLengthLengths[kCodeLengthOrder[codeLengthCount - 1]])
+                --codeLengthCount;
+
+            auto runExtra = [](unsigned char symbol) { return symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0; };
+            unsigned long long bits = 3 + 5 + 5 + 4 + 3 * codeLengthCount;
+            for (const auto& run : runs)
+                bits += codeLengthLengths[run.first] + runExtra(run.first);
+            for (int s = 0; s < 286; ++s)
+                bits += static_cast<unsigned long long>(literalFreq[s]) * (literalLengths[s] + (s > 256 ? kLengthExtra[s - 257] : 0));
+            for (int s = 0; s < 30; ++s)
+                bits += static_cast<unsigned long long>(distanceFreq[s]) * (distanceLengths[s] + kDistanceExtra[s]);
+            unsigned long long storedBits = (rawSize / 65535 + 1) * 40 + rawSize * 8 + 7;
+            if (bits >= storedBits)
+            {
+                WriteStored(writer, raw, rawSize, final);
+                return;
+            }
+
+            unsigned short literalCodes[286] = { 0 }, distanceCodes[30] = { 0 }, codeLengthCodes[19] = { 0 };
+            BuildCodes(literalLengths, 286, literalCodes);
+            BuildCodes(distanceLengths, 30, distanceCodes);
+            BuildCodes(codeLengthLengths, 19, codeLengthCodes);
+
+            writer.Put(final ? 1 : 0, 1);
+            writer.Put(2, 2);
+            writer.Put(literalCount - 257, 5);
+            writer.Put(distanceCount - 1, 5);
+            writer.Put(codeLengthCount - 4, 4);
+            for (int k = 0; k < codeLengthCount; ++k)
+                writer.Put(codeLengthLengths[kCodeLengthOrder[k]], 3);
+            for (const auto& run : runs)
+            {
+                writer.Put(codeLengthCodes[run.first], codeLengthLengths[run.first]);
+                if (runExtra(run.first))
+                    writer.Put(run.second, runExtra(run.first));
+            }
+
+            for (const auto& t : tokens)
+            {
+                if (t.distance == 0)
+                {
+                    writer.Put(literalCodes[t.length], literalLengths[t.length]);
+                    continue;
+                }
+                int lengthCode = kLengthCodes.code[t.length];
+                writer.Put(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+                if (kLengthExtra[lengthCode])
+                    writer.Put(t.length - kLengthBase[lengthCode], kLengthExtra[lengthCode]);
+                int distanceCode = DistanceCode(t.distance);
+                writer.Put(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+                if (kDistanceExtra[distanceCode])
+                    writer.Put(t.distance - kDistanceBase[distanceCode], kDistanceExtra[distanceCode]);
+            }
+            writer.Put(literalCodes[256], literalLengths[256]);
+        }
+    }
+
+    void Deflate::Compress(const char* data, size_t size, size_t dictionarySize, bool last, std::string& out)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        BitWriter writer(out);
+
+        // Hash chains over 3-byte prefixes; positions are offsets into data, which
+        // is at most a block plus its dictionary, so the window never slides
+        std::vector<int> head(1 << kHashBits, -1);
+        std::vector<int> prev(size);
+        auto hash = [&](size_t pos)
+        {
+            unsigned int v = bytes[pos] | (bytes[pos + 1] << 8) | (bytes[pos + 2] << 16);
+            return (v * 2654435761u) >> (32 - kHashBits);
+        };
+        auto insert = [&](size_t pos)
+        {
+            unsigned int h = hash(pos);
+            prev[pos] = head[h];
+            head[h] = static_cast<int>(pos);
+        };
+        auto findMatch = [&](size_t pos, int& bestLength, unsigned int& bestDistance)
+        {
+            bestLength = kMinMatch - 1;
+            const int limit = static_cast<int>(std::min<size_t>(kMaxMatch, size - pos));
+            const unsigned char* current = bytes + pos;
+            int chain = kMaxChain;
+            for (int candidate = head[hash(pos)]; candidate >= 0 && pos - candidate <= kWindow && chain-- > 0; candidate = prev[candidate])
+            {
+                const unsigned char* earlier = bytes + candidate;
+                if (earlier[bestLength] != current[bestLength] || earlier[0] != current[0])
+                    continue;
+                int length = 0;
+                while (length < limit && earlier[length] == current[length])
+                    ++length;
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = static_cast<unsigned int>(pos - candidate);
+                    if (length >= kNiceMatch || length == limit)
+                        break;
+                }
+            }
+        };
+
+        for (size_t pos = 0; pos < dictionarySize && pos + kMinMatch <= size; ++pos)
+            insert(pos);
+
+        std::vector<Token> tokens;
+        tokens.reserve(kBlockTokens);
+        size_t blockStart = dictionarySize;
+        auto flush = [&](size_t end, bool final)
+        {
+            WriteBlock(writer, tokens, bytes + blockStart, end - blockStart, final);
+            tokens.clear();
+            blockStart = end;
+        };
+
+        // Lazy matching: the match found at pos - 1 is kept pending and only
+        // emitted if the one starting at pos is not longer
+        bool pending = false;
+        int pendingLength = 0;
+        unsigned int pendingDistance = 0;
+        size_t pos = dictionarySize;
+        while (pos < size)
+        {
+            int length = 0;
+            unsigned int distance = 0;
+            if (pos + kMinMatch <= size)
+            {
+                if (!pending || pendingLength < kLazyMatch)
+                    findMatch(pos, length, distance);
+                insert(pos);
+            }
+            if (pending)
+            {
+                if (pendingLength >= kMinMatch && length <= pendingLength)
+                {
+                    tokens.push_back({ static_cast<unsigned short>(pendingLength), static_cast<unsigned short>(pendingDistance) });
+                    size_t end = pos - 1 + pendingLength;
+                    for (size_t p = pos + 1; p < end && p + kMinMatch <= size; ++p)
+                        insert(p);
+                    pos = end;
+                    pending = false;
+                    if (tokens.size() >= kBlockTokens)
+                        flush(pos, false);
+                    continue;
+                }
+                tokens.push_back({ bytes[pos - 1], 0 });
+                if (tokens.size() >= kBlockTokens)
+                    flush(pos, false);
+            }
+            pending = true;
+            pendingLength = length;
+            pendingDistance = distance;
+            ++pos;
+        }
+        if (pending)
+        {
+            if (pendingLength >= kMinMatch)
+                tokens.push_back({ static_cast<unsigned short>(pendingLength), static_cast<unsigned short>(pendingDistance) });
+            else
+                tokens.push_back({ bytes[size - 1], 0 });
+        }
+
+        if (last)
+        {
+            flush(size, true);
+            writer.Align();
+            return;
+        }
+        if (!tokens.empty())
+            flush(size, false);
+
+        // Sync flush: empty stored block, leaving the stream byte-aligned
+        writer.Put(0, 3);
+        writer.Align();
+        const unsigned char marker[4] = { 0x00, 0x00, 0xFF, 0xFF };
+        writer.Bytes(marker, 4);
+    }
+
+    unsigned int Deflate::Crc32(unsigned int crc, const char* data, size_t size)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        const auto& t = kCrcTable.entries;
+        crc = ~crc;
+        for (; size >= 4; size -= 4, p += 4)
+        {
+            crc ^= p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+            crc = t[3][crc & 0xFF] ^ t[2][(crc >> 8) & 0xFF] ^ t[1][(crc >> 16) & 0xFF] ^ t[0][crc >> 24];
+        }
+        for (; size > 0; --size, ++p)
+            crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    GzipStreamBuf::GzipStreamBuf(const std::wstring& filename, unsigned int threadCount)
+        : file(filename, std::ios::binary), buffer(kBlockSize)
+    {
+        setp(buffer.data(), buffer.data() + buffer.size());
+        if (!file.is_open())
+        {
+            closed = true;
+            failed = true;
+            return;
+        }
+
+        // Deflate, no name or timestamp, NTFS
+        const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 11 };
+        file.write(header, sizeof(header));
+
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        maxInFlight = 2 * threadCount;
+        for (unsigned int t = 0; t < threadCount; ++t)
+            workers.emplace_back(&GzipStreamBuf::CompressLoop, this);
+        writer = std::thread(&GzipStreamBuf::WriteLoop, this);
+    }
+
+    GzipStreamBuf::~GzipStreamBuf()
+    {
+        close();
+    }
+
+    void GzipStreamBuf::Submit(bool last)
+    {
+        auto block = std::make_shared<Block>();
+        size_t used = pptr() - pbase();
+        block->input.reserve(window.size() + used);
+        block->input.assign(window);
+        block->input.append(pbase(), used);
+        block->dictionarySize = window.size();
+        block->last = last;
+        size_t keep = std::min(block->input.size(), static_cast<size_t>(Deflate::kWindow));
+        window.assign(block->input, block->input.size() - keep, std::string::npos);
+        setp(buffer.data(), buffer.data() + buffer.size());
+
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return ordered.size() < maxInFlight; });
+        queued.push_back(block);
+        ordered.push_back(block);
+        changed.notify_all();
+    }
+
+    void GzipStreamBuf::CompressLoop()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Block> block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return stopping || !queued.empty(); });
+                if (queued.empty())
+                    return;
+                block = queued.front();
+                queued.pop_front();
+            }
+            Deflate::Compress(block->input.data(), block->input.size(), block->dictionarySize, block->last, block->output);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                block->done = true;
+            }
+            changed.notify_all();
+        }
+    }
+
+    void GzipStreamBuf::WriteLoop()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Block> block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return (!ordered.empty() && ordered.front()->done) || (stopping && ordered.empty()); });
+                if (ordered.empty())
+                    return;
+                block = ordered.front();
+                ordered.pop_front();
+            }
+            changed.notify_all();
+
+            size_t size = block->input.size() - block->dictionarySize;
+            crc = Deflate::Crc32(crc, block->input.data() + block->dictionarySize, size);
+            totalSize += size;
+            file.write(block->output.data(), block->output.size());
+            if (block->last)
+            {
+                // CRC-32 and size modulo 2^32, little-endian
+                unsigned int trailer[2] = { crc, static_cast<unsigned int>(totalSize) };
+                for (unsigned int value : trailer)
+                {
+                    char bytes[4] = { static_cast<char>(value), static_cast<char>(value >> 8),
+                        static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+                    file.write(bytes, 4);
+                }
+            }
+            if (!file)
+                failed = true;
+        }
+    }
+
+    GzipStreamBuf::int_type GzipStreamBuf::overflow(int_type ch)
+    {
+        if (closed)
+            return traits_type::eof();
+        Submit(false);
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    bool GzipStreamBuf::close()
+    {
+        if (closed)
+            return !failed;
+        closed = true;
+
+        Submit(true);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+        writer.join();
+        workers.clear();
+
+        file.close();
+        if (file.fail())
+            failed = true;
+        return !failed;
+    }
+
+    OutputFile::OutputFile(const std::wstring& filename, unsigned int threadCount)
+        : std::ostream(nullptr)
+    {
+        if (IsCompressed(filename))
+        {
+            gzip.reset(new GzipStreamBuf(filename, threadCount));
+            rdbuf(gzip.get());
+        }
+        else
+        {
+            plain.open(filename, std::ios::out | std::ios::binary);
+            rdbuf(&plain);
+        }
+        if (!is_open())
+            setstate(std::ios::badbit);
+    }
+
+    bool OutputFile::is_open() const
+    {
+        return gzip ? gzip->is_open() : plain.is_open();
+    }
+
+    bool OutputFile::close()
+    {
+        if (gzip ? !gzip->close() : !plain.close())
+            setstate(std::ios::failbit);
+        return !fail();
+    }
+
+    bool OutputFile::IsCompressed(const std::wstring& filename)
+    {
+        return filename.size() > 3 && _wcsicmp(filename.c_str() + filename.size() - 3, L".gz") == 0;
+    }
+}
\ No newline at end of file
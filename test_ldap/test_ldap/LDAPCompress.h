@@ -0,0 +1,101 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace LDAPUtils
+{
+    // DEFLATE (RFC 1951) encoder and the gzip CRC, kept in the tree so exports
+    // can be compressed without an external codec library
+    class Deflate
+    {
+    public:
+        static const size_t kWindow = 32768;
+
+        // Appends data[dictionarySize, size) as raw DEFLATE blocks to out; the first
+        // dictionarySize bytes (at most kWindow) are the preceding input and are only
+        // matched against. Output ends on a byte boundary: with the final block when
+        // last, otherwise with an empty stored block so independently compressed
+        // pieces concatenate into one stream
+        static void Compress(const char* data, size_t size, size_t dictionarySize, bool last, std::string& out);
+
+        static unsigned int Crc32(unsigned int crc, const char* data, size_t size);
+    };
+
+    // Stream buffer writing a gzip file. Input is cut into kBlockSize blocks that
+    // worker threads compress in parallel (each primed with the previous block's
+    // last 32 KB) while the caller keeps formatting; a writer thread appends them
+    // to the file in order. At most two blocks per worker are in flight.
+    class GzipStreamBuf : public std::streambuf
+    {
+    private:
+        struct Block
+        {
+            std::string input;          // Dictionary followed by the block's data
+            size_t dictionarySize = 0;
+            bool last = false;
+            bool done = false;
+            std::string output;
+        };
+
+        std::ofstream file;
+        std::vector<char> buffer;
+        std::string window;             // Last kWindow bytes submitted
+        std::deque<std::shared_ptr<Block>> queued;      // Waiting for a worker
+        std::deque<std::shared_ptr<Block>> ordered;     // Waiting to be written, in stream order
+        std::vector<std::thread> workers;
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t maxInFlight = 2;
+        bool stopping = false;
+        bool closed = false;
+        bool failed = false;
+        unsigned int crc = 0;
+        unsigned long long totalSize = 0;
+
+        void Submit(bool last);
+        void CompressLoop();
+        void WriteLoop();
+
+    protected:
+        int_type overflow(int_type ch) override;
+
+    public:
+        static const size_t kBlockSize = 1 << 20;
+
+        // threadCount compressing threads (0 = all cores)
+        explicit GzipStreamBuf(const std::wstring& filename, unsigned int threadCount = 0);
+        ~GzipStreamBuf();
+        GzipStreamBuf(const GzipStreamBuf&) = delete;
+        GzipStreamBuf& operator=(const GzipStreamBuf&) = delete;
+
+        bool is_open() const { return file.is_open(); }
+        // Compresses what is left, writes the gzip trailer and closes the file;
+        // false when the file never opened or a write failed
+        bool close();
+    };
+
+    // File the exporters write to: gzip-compressed when the name ends in .gz,
+    // plain otherwise
+    class OutputFile : public std::ostream
+    {
+    private:
+        std::filebuf plain;
+        std::unique_ptr<GzipStreamBuf> gzip;
+
+    public:
+        explicit OutputFile(const std::wstring& filename, unsigned int threadCount = 0);
+
+        bool is_open() const;
+        // Flushes and closes the file; false when it never opened or a write failed
+        bool close();
+
+        static bool IsCompressed(const std::wstring& filename);
+    };
+}
\ No newline at end of file
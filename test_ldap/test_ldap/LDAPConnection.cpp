@@ -2,11 +2,216 @@
 #include "LDAPConverters.h"
 #include "LDAPStatistics.h"
 #include "LDAPExporter.h"
+#include "LDAPSchema.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <deque>
+#include <chrono>
 #include <winber.h>
 
 namespace LDAPUtils
 {
+    namespace
+    {
+        const wchar_t* const kDirSyncOid = L"1.2.840.113556.1.4.841";
+        const int kDirSyncAncestorsFirstOrder = 0x00000800;
+        const int kDirSyncMaxBytes = 0x100000;
+        const wchar_t* const kShowDeletedOid = L"1.2.840.113556.1.4.417";
+        const size_t kRangeWindow = 16;   // base searches kept in flight during ranged retrieval
+
+        // DirSync request value: SEQUENCE { flags INTEGER, maxBytes INTEGER, cookie OCTET STRING }
+        berval* EncodeDirSyncRequest(const std::string& cookie)
+        {
+            BerElement* ber = ber_alloc_t(LBER_USE_DER);
+            if (!ber) return NULL;
+
+            berval* value = NULL;
+            if (ber_printf(ber, const_cast<char*>("{iio}"), kDirSyncAncestorsFirstOrder, kDirSyncMaxBytes,
+                    cookie.data(), static_cast<int>(cookie.size())) == -1 ||
+                ber_flatten(ber, &value) != 0)
+            {
+                value = NULL;
+            }
+            ber_free(ber, 1);
+            return value;
+        }
+
+        // DirSync response value: SEQUENCE { moreData INTEGER, unused INTEGER, cookie OCTET STRING }
+        bool DecodeDirSyncResponse(const berval& value, bool& outMoreData, std::string& outCookie)
+        {
+            berval copy = value;
+            BerElement* ber = ber_init(&copy);
+            if (!ber) return false;
+
+            ber_int_t moreData = 0, unused = 0;
+            berval* cookie = NULL;
+            bool ok = ber_scanf(ber, const_cast<char*>("{iiO}"), &moreData, &unused, &cookie) != -1;
+            if (ok && cookie)
+                outCookie.assign(cookie->bv_val, cookie->bv_len);
+            if (cookie) ber_bvfree(cookie);
+            ber_free(ber, 1);
+
+            outMoreData = ok && moreData != 0;
+            return ok;
+        }
+
+        // "sn,-whenCreated": ascending sn, then descending whenCreated
+        LDAPControlW* CreateSortControl(LDAP* connection, const std::wstring& keys, bool critical)
+        {
+            std::vector<std::wstring> names;
+            std::wstringstream ss(keys);
+            std::wstring key;
+            while (std::getline(ss, key, L','))
+            {
+                key.erase(0, key.find_first_not_of(L" \t"));
+                key.erase(key.find_last_not_of(L" \t") + 1);
+                if (!key.empty() && key != L"-")
+                    names.push_back(key);
+            }
+            if (names.empty())
+                return NULL;
+
+            std::vector<LDAPSortKeyW> sortKeys(names.size());
+            std::vector<LDAPSortKeyW*> keyList;
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                bool reverse = names[i][0] == L'-';
+                if (reverse)
+                    names[i].erase(0, 1);
+                sortKeys[i].sk_attrtype = &names[i][0];
+                sortKeys[i].sk_matchruleoid = NULL;
+                sortKeys[i].sk_reverseorder = reverse ? TRUE : FALSE;
+                keyList.push_back(&sortKeys[i]);
+            }
+            keyList.push_back(NULL);
+
+            LDAPControlW* control = NULL;
+            if (ldap_create_sort_controlW(connection, keyList.data(), critical ? TRUE : FALSE, &control) != 0)
+                return NULL;
+            return control;
+        }
+
+        // Rows [offset, offset + size) of the sorted result, or size rows starting at
+        // the first entry whose first sort key is >= windowValue
+        LDAPControlW* CreateWindowControl(LDAP* connection, const SearchConfig& config)
+        {
+            LDAPVLVInfo info = {};
+            info.ldvlv_version = LDAP_VLVINFO_VERSION;
+            info.ldvlv_before_count = 0;
+            info.ldvlv_after_count = config.windowSize > 0 ? config.windowSize - 1 : 0;
+
+            std::string value;
+            berval valueBerval = { 0, NULL };
+            if (!config.windowValue.empty())
+            {
+                value = Converters::WStringToUtf8(config.windowValue);
+                valueBerval.bv_len = static_cast<unsigned long>(value.size());
+                valueBerval.bv_val = &value[0];
+                info.ldvlv_attrvalue = &valueBerval;
+            }
+            else
+            {
+                info.ldvlv_offset = config.windowOffset;
+                info.ldvlv_count = 0;   // Let the server use its own content count
+            }
+
+            LDAPControlW* control = NULL;
+            if (ldap_create_vlv_controlW(connection, &info, TRUE, &control) != 0)
+                return NULL;
+            return control;
+        }
+
+        // Values past the server's MaxValRange (1500 on AD) arrive as "member;range=0-1499",
+        // and the final chunk as "member;range=3000-*"
+        bool ParseRange(const wchar_t* attribute, std::wstring& outName, unsigned long& outHigh, bool& outLast)
+        {
+            std::wstring text = attribute;
+            size_t at = Converters::ToLower(text).find(L";range=");
+            if (at == std::wstring::npos)
+                return false;
+            size_t dash = text.find(L'-', at + 7);
+            if (dash == std::wstring::npos)
+                return false;
+
+            outName = text.substr(0, at);
+            outLast = text.compare(dash + 1, std::wstring::npos, L"*") == 0;
+            outHigh = outLast ? 0 : wcstoul(text.c_str() + dash + 1, nullptr, 10);
+            return true;
+        }
+    }
+
+    bool LDAPConnection::LoadDirSyncCookie(const std::wstring& filename, std::string& outCookie)
+    {
+        outCookie.clear();
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        outCookie.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool LDAPConnection::SaveDirSyncCookie(const std::wstring& filename, const std::string& cookie)
+    {
+        std::wstring tempFile = filename + L".tmp";
+        {
+            std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+            if (!file.is_open() || !file.write(cookie.data(), cookie.size()))
+            {
+                std::wcerr << L"Failed to write DirSync cookie: " << tempFile << std::endl;
+                return false;
+            }
+        }
+        if (!MoveFileExW(tempFile.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            std::wcerr << L"Failed to replace DirSync cookie: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool LDAPConnection::ParseWindow(const std::wstring& range, SearchConfig& config)
+    {
+        wchar_t* end = nullptr;
+        unsigned long first = wcstoul(range.c_str(), &end, 10);
+        if (first == 0 || *end != L'-')
+            return false;
+        unsigned long last = wcstoul(end + 1, &end, 10);
+        if (*end != L'\0' || last < first)
+            return false;
+
+        config.windowOffset = first;
+        config.windowSize = last - first + 1;
+        config.windowValue.clear();
+        return true;
+    }
+
+    unsigned long LDAPConnection::ServerMaxPageSize()
+    {
+        if (maxPageSize > 0)
+            return maxPageSize;
+
+        maxPageSize = PageSizeTuner::kDefaultMaxPageSize;
+        Entry rootDse, policy;
+        if (!SearchByDN(L"", rootDse))
+            return maxPageSize;
+        auto configuration = rootDse.attrs.find(L"configurationNamingContext");
+        if (configuration == rootDse.attrs.end() || configuration->second.empty())
+            return maxPageSize;
+
+        std::wstring policyDn = L"CN=Default Query Policy,CN=Query-Policies,CN=Directory Service,CN=Windows NT,CN=Services," +
+            configuration->second[0].str();
+        if (SearchByDN(policyDn, policy))
+        {
+            auto limits = policy.attrs.find(L"lDAPAdminLimits");
+            unsigned long limit = limits != policy.attrs.end() ? PageSizeTuner::ParseMaxPageSize(limits->second) : 0;
+            if (limit > 0)
+                maxPageSize = limit;
+        }
+        return maxPageSize;
+    }
+
     LDAPConnection::LDAPConnection(const std::wstring& serverAddress, unsigned long port)
         : ldapConnection(ldap_initW(const_cast<wchar_t*>(serverAddress.c_str()), port))
     {
@@ -61,6 +266,72 @@ namespace LDAPUtils
         }
     }
 
+    bool LDAPConnectionPool::Open(const SearchConfig& config, size_t size)
+    {
+        if (size == 0) size = 1;
+        this->config = config;
+
+        // Bind all connections concurrently; each Negotiate bind is a few round trips
+        std::vector<std::unique_ptr<LDAPConnection>> opened(size);
+        std::vector<char> bound(size, 0);
+        std::vector<std::thread> binders;
+        for (size_t i = 0; i < size; ++i)
+        {
+            binders.emplace_back([&, i]()
+            {
+                opened[i].reset(new LDAPConnection(config.serverAddress));
+                bound[i] = opened[i]->Connect(config.username, config.password, config.serverAddress) ? 1 : 0;
+            });
+        }
+        for (auto& binder : binders)
+            binder.join();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (!bound[i]) continue;
+            idle.push_back(opened[i].get());
+            connections.push_back(std::move(opened[i]));
+        }
+        return !connections.empty();
+    }
+
+    LDAPConnection* LDAPConnectionPool::Acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this]() { return !idle.empty(); });
+        LDAPConnection* connection = idle.back();
+        idle.pop_back();
+        return connection;
+    }
+
+    void LDAPConnectionPool::Release(LDAPConnection* connection)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.push_back(connection);
+        }
+        available.notify_one();
+    }
+
+    LDAPConnection* LDAPConnectionPool::Reconnect(LDAPConnection* connection)
+    {
+        std::unique_ptr<LDAPConnection> fresh(new LDAPConnection(config.serverAddress));
+        if (!fresh->Connect(config.username, config.password, config.serverAddress))
+            return connection;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& slot : connections)
+        {
+            if (slot.get() == connection)
+            {
+                slot = std::move(fresh);
+                return slot.get();
+            }
+        }
+        return connection;
+    }
+
     bool LDAPConnection::SearchByDN(const std::wstring& dn, Entry& outEntry)
     {
         if (ldapConnection == NULL) return false;
@@ -98,25 +369,32 @@ namespace LDAPUtils
         outEntry.dn = dnResult ? dnResult : L"";
         if (dnResult) ldap_memfree(dnResult);
 
+        std::vector<RangedAttribute> pending;
         BerElement* pBer = NULL;
         wchar_t* attribute = ldap_first_attributeW(ldapConnection, pEntry, &pBer);
         while (attribute != NULL)
         {
+            std::wstring name = attribute;
+            unsigned long rangeHigh = 0;
+            bool rangeLast = false;
+            if (ParseRange(attribute, name, rangeHigh, rangeLast) && !rangeLast)
+                pending.push_back({ 0, name, rangeHigh + 1 });
+
             wchar_t** vals = ldap_get_valuesW(ldapConnection, pEntry, attribute);
             struct berval** bvals = ldap_get_values_lenW(ldapConnection, pEntry, attribute);
             int valCount = vals ? ldap_count_valuesW(vals) : 0;
 
-            std::vector<std::wstring> fvals;
+            ValueKind kind = Schema::Active().KindOf(name);
+            std::vector<Value> fvals;
             for (int i = 0; i < valCount; ++i)
             {
-                std::wstring fval = Converters::FormatAttributeValue(
-                    std::wstring(attribute), vals[i], bvals && bvals[i] ? bvals[i] : nullptr);
-                fvals.push_back(fval);
+                fvals.push_back(Converters::DecodeAttributeValue(
+                    kind, vals[i], bvals && bvals[i] ? bvals[i] : nullptr));
             }
 
             if (!fvals.empty())
             {
-                outEntry.attrs[attribute] = std::move(fvals);
+                outEntry.attrs[name] = std::move(fvals);
             }
 
             if (vals) ldap_value_freeW(vals);
@@ -127,7 +405,133 @@ namespace LDAPUtils
         if (pBer) ber_free(pBer, 0);
 
         ldap_msgfree(pSearchResult);
-        return true;
+
+        if (pending.empty())
+            return true;
+        std::vector<Entry> entries(1);
+        entries[0] = std::move(outEntry);
+        bool complete = RetrieveRanges(entries, std::move(pending), false, false);
+        outEntry = std::move(entries[0]);
+        return complete;
+    }
+
+    bool LDAPConnection::RetrieveRanges(std::vector<Entry>& entries, std::vector<RangedAttribute> pending,
+        bool showDeleted, bool verbose)
+    {
+        struct Request
+        {
+            unsigned long messageId;
+            RangedAttribute range;
+        };
+
+        LDAPControlW showDeletedControl{ const_cast<wchar_t*>(kShowDeletedOid), {0}, FALSE };
+        LDAPControlW* serverControls[] = { showDeleted ? &showDeletedControl : NULL, NULL };
+        auto start = std::chrono::steady_clock::now();
+        size_t attributeCount = pending.size();
+        size_t requests = 0;
+        size_t values = 0;
+
+        // Each attribute's chunks follow one another, but chunks of different
+        // entries are pipelined on the connection instead of waiting in turn
+        std::deque<Request> inFlight;
+        size_t nextPending = 0;
+        bool ok = true;
+        while (ok && (nextPending < pending.size() || !inFlight.empty()))
+        {
+            while (nextPending < pending.size() && inFlight.size() < kRangeWindow)
+            {
+                Request request{ 0, pending[nextPending++] };
+                std::wstring attribute = request.range.name + L";range=" + std::to_wstring(request.range.next) + L"-*";
+                wchar_t* attrList[] = { const_cast<wchar_t*>(attribute.c_str()), NULL };
+                unsigned long returnCode = ldap_search_extW(
+                    ldapConnection,
+                    const_cast<wchar_t*>(entries[request.range.entry].dn.c_str()),
+                    0, // LDAP_SCOPE_BASE
+                    const_cast<wchar_t*>(L"(objectClass=*)"),
+                    attrList,
+                    0,
+                    serverControls,
+                    NULL,
+                    1000,
+                    0,
+                    &request.messageId);
+                if (returnCode != 0)
+                {
+                    std::wcerr << L"Ranged retrieval of " << attribute << L" failed for "
+                        << entries[request.range.entry].dn << L". Code: " << returnCode << std::endl;
+                    ok = false;
+                    break;
+                }
+                inFlight.push_back(std::move(request));
+                ++requests;
+            }
+            if (!ok || inFlight.empty())
+                break;
+
+            Request request = std::move(inFlight.front());
+            inFlight.pop_front();
+            Entry& entry = entries[request.range.entry];
+
+            LDAPMessage* pResult = NULL;
+            struct l_timeval timeout { 1000, 0 };
+            unsigned long type = ldap_result(ldapConnection, request.messageId, 1 /*LDAP_MSG_ALL*/, &timeout, &pResult);
+            if (type == 0 || type == static_cast<unsigned long>(-1) || !pResult)
+            {
+                std::wcerr << L"Ranged retrieval of " << request.range.name << L" timed out for " << entry.dn << std::endl;
+                if (pResult) ldap_msgfree(pResult);
+                ok = false;
+                break;
+            }
+
+            LDAPMessage* pEntry = ldap_first_entry(ldapConnection, pResult);
+            BerElement* pBer = NULL;
+            wchar_t* attribute = pEntry ? ldap_first_attributeW(ldapConnection, pEntry, &pBer) : NULL;
+            while (attribute != NULL)
+            {
+                std::wstring name = attribute;
+                unsigned long rangeHigh = 0;
+                bool rangeLast = true;
+                bool ranged = ParseRange(attribute, name, rangeHigh, rangeLast);
+                if (_wcsicmp(name.c_str(), request.range.name.c_str()) == 0)
+                {
+                    wchar_t** vals = ldap_get_valuesW(ldapConnection, pEntry, attribute);
+                    struct berval** bvals = ldap_get_values_lenW(ldapConnection, pEntry, attribute);
+                    int valCount = vals ? ldap_count_valuesW(vals) : 0;
+
+                    ValueKind kind = Schema::Active().KindOf(request.range.name);
+                    std::vector<Value>& target = entry.attrs[request.range.name];
+                    target.reserve(target.size() + valCount);
+                    for (int i = 0; i < valCount; ++i)
+                    {
+                        target.push_back(Converters::DecodeAttributeValue(
+                            kind, vals[i], bvals && bvals[i] ? bvals[i] : nullptr));
+                    }
+                    values += valCount;
+
+                    if (ranged && !rangeLast && valCount > 0)
+                        pending.push_back({ request.range.entry, request.range.name, rangeHigh + 1 });
+
+                    if (vals) ldap_value_freeW(vals);
+                    if (bvals) ldap_value_free_len(bvals);
+                }
+                ldap_memfree(attribute);
+                attribute = ldap_next_attributeW(ldapConnection, pEntry, pBer);
+            }
+            if (pBer) ber_free(pBer, 0);
+            ldap_msgfree(pResult);
+        }
+
+        for (const auto& request : inFlight)
+            ldap_abandon(ldapConnection, request.messageId);
+
+        if (verbose)
+        {
+            std::wcout << L"Ranged retrieval: " << values << L" more values for " << attributeCount << L" attributes in "
+                << requests << L" requests ("
+                << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                << L" ms)" << std::endl;
+        }
+        return ok;
     }
 
     void LDAPConnection::SearchByAttribute(const std::wstring& attrName, const std::wstring& attrValue,
@@ -145,16 +549,20 @@ namespace LDAPUtils
         Search(modifiedConfig, outEntries, tempStats);
     }
 
-    void LDAPConnection::Search(const SearchConfig& config, std::vector<Entry>& outEntries, Statistics& outStats)
+    bool LDAPConnection::Search(const SearchConfig& config, std::vector<Entry>& outEntries, Statistics& outStats,
+        DnTree* outTree)
     {
         if (ldapConnection == NULL)
         {
             std::cerr << "Not connected to LDAP." << std::endl;
-            return;
+            return false;
         }
 
         bool collectForExport = (config.format != OutputFormat::CONSOLE_ONLY && !config.outputFile.empty());
+        bool collectEntries = collectForExport || config.collectEntries;
         bool isWildcard = !config.attributesStr.empty() && config.attributesStr == L"*";
+        bool verbose = !config.quiet;
+        bool dirSync = !config.dirSyncCookieFile.empty();
 
         std::vector<Entry> entries;
         std::set<std::wstring> allAttributes;
@@ -188,32 +596,141 @@ namespace LDAPUtils
         }
 
         struct l_timeval timeout { 1000, 0 };
-        unsigned long pageSize = 1000;
-        LDAPControlW pageControl{ const_cast<wchar_t*>(L"1.2.840.113556.1.4.319"), {0}, FALSE };
-        LDAPControlW* serverControls[] = { &pageControl, NULL };
+        LDAPControlW* pageControl = NULL;
+        berval* pageCookie = NULL;
+        LDAPControlW showDeletedControl{ const_cast<wchar_t*>(kShowDeletedOid), {0}, FALSE };
+
+        // DirSync replaces paging: each round returns up to maxBytes of changes and
+        // a cookie that is persisted before the next round, so runs can resume
+        LDAPControlW dirSyncControl{ const_cast<wchar_t*>(kDirSyncOid), {0}, TRUE };
+        berval* dirSyncValue = NULL;
+        std::string dirSyncCookie;
+        bool resumed = dirSync && LoadDirSyncCookie(config.dirSyncCookieFile, dirSyncCookie) && !dirSyncCookie.empty();
+
+        // Server-side sort rides along with paging; a VLV window replaces paging and
+        // returns only the requested rows of the sorted result in one round trip
+        bool windowed = config.windowOffset > 0 || !config.windowValue.empty();
+        if (dirSync && (windowed || !config.sortKeys.empty()))
+        {
+            std::wcerr << L"Sorting and windows cannot be combined with DirSync" << std::endl;
+            return false;
+        }
+        if (windowed && config.sortKeys.empty())
+        {
+            std::wcerr << L"A VLV window needs sort keys (--sort)" << std::endl;
+            return false;
+        }
+
+        LDAPControlW* sortControl = NULL;
+        LDAPControlW* windowControl = NULL;
+        auto freeSortControls = [&]()
+        {
+            if (sortControl) ldap_control_freeW(sortControl);
+            if (windowControl) ldap_control_freeW(windowControl);
+            sortControl = windowControl = NULL;
+        };
+        if (!config.sortKeys.empty())
+        {
+            // Outside a window the sort is not critical: a result too large for the
+            // DC's sort table still comes back, unsorted, with a warning
+            sortControl = CreateSortControl(ldapConnection, config.sortKeys, windowed);
+            windowControl = windowed ? CreateWindowControl(ldapConnection, config) : NULL;
+            if (!sortControl || (windowed && !windowControl))
+            {
+                std::wcerr << L"Failed to create " << (sortControl ? L"VLV" : L"sort") << L" control" << std::endl;
+                freeSortControls();
+                return false;
+            }
+        }
+        lastWindow = WindowPosition();
+        bool sortWarned = false;
+
+        // The page control is rebuilt for every page with the current size and cookie
+        bool paged = !dirSync && !windowed;
+        PageSizeTuner tuner(config.pageSize, config.adaptivePaging && paged ? ServerMaxPageSize() : 0,
+            config.adaptivePaging);
+
+        std::vector<LDAPControlW*> serverControls;
+        if (dirSync)
+            serverControls.push_back(&dirSyncControl);
+        else if (paged)
+            serverControls.push_back(NULL);
+        if (sortControl)
+            serverControls.push_back(sortControl);
+        if (windowControl)
+            serverControls.push_back(windowControl);
+        if (config.showDeleted)
+            serverControls.push_back(&showDeletedControl);
+        serverControls.push_back(NULL);
         LDAPControlW* clientControls[] = { NULL };
-        struct berval cookie = { 0, NULL };
         bool morePages = true;
         int totalEntries = 0;
+        StatisticsAccumulator accumulator(StatisticsProfile::Active());
+
+        // Attributes returned in ranges are completed after the search, and only
+        // then reach the statistics; entries that are not collected are kept aside
+        // until then when the statistics profile needs the values
+        std::vector<RangedAttribute> ranged;
+        std::vector<Entry> rangedOnly;
 
-        std::wcout << L"***Searching..." << std::endl;
-        std::wcout << L"Base DN: \"" << config.baseDN << L"\"" << std::endl;
-        std::wcout << L"Filter: \"" << config.filter << L"\"" << std::endl;
-        std::wcout << L"Scope: " << config.scope << std::endl << std::endl;
+        if (verbose)
+        {
+            std::wcout << L"***Searching..." << std::endl;
+            std::wcout << L"Base DN: \"" << config.baseDN << L"\"" << std::endl;
+            std::wcout << L"Filter: \"" << config.filter << L"\"" << std::endl;
+            std::wcout << L"Scope: " << config.scope << std::endl;
+            if (dirSync)
+                std::wcout << L"DirSync: " << (resumed ? L"resuming from " : L"starting new cookie in ")
+                    << config.dirSyncCookieFile << std::endl;
+            if (sortControl)
+                std::wcout << L"Sort: " << config.sortKeys << std::endl;
+            if (windowed && config.windowValue.empty())
+                std::wcout << L"Window: rows " << config.windowOffset << L"-"
+                    << (config.windowOffset + (config.windowSize > 0 ? config.windowSize - 1 : 0)) << std::endl;
+            else if (windowed)
+                std::wcout << L"Window: " << config.windowSize << L" rows from \"" << config.windowValue << L"\"" << std::endl;
+            std::wcout << std::endl;
+        }
 
         while (morePages)
         {
-            struct berval pageSizeBerval { static_cast<int>(sizeof(unsigned long)), reinterpret_cast<char*>(&pageSize) };
-            pageControl.ldctl_value = pageSizeBerval;
+            if (dirSync)
+            {
+                if (dirSyncValue) ber_bvfree(dirSyncValue);
+                dirSyncValue = EncodeDirSyncRequest(dirSyncCookie);
+                if (!dirSyncValue)
+                {
+                    std::wcerr << L"Failed to encode DirSync control" << std::endl;
+                    return false;
+                }
+                dirSyncControl.ldctl_value = *dirSyncValue;
+            }
+            else if (paged)
+            {
+                if (pageControl) ldap_control_freeW(pageControl);
+                pageControl = NULL;
+                if (ldap_create_page_controlW(ldapConnection, tuner.Next(), pageCookie, FALSE, &pageControl) != 0 ||
+                    !pageControl)
+                {
+                    std::wcerr << L"Failed to create paged results control" << std::endl;
+                    if (pageCookie) ber_bvfree(pageCookie);
+                    freeSortControls();
+                    return false;
+                }
+                serverControls[0] = pageControl;
+            }
 
+            PageSizeTuner::Page page;
+            page.requested = paged ? tuner.Next() : 0;
+            auto pageStart = std::chrono::steady_clock::now();
             unsigned long returnCode = ldap_search_ext_sW(
                 ldapConnection,
                 const_cast<wchar_t*>(config.baseDN.c_str()),
-                config.scope,
+                dirSync ? 2 : config.scope,     // DirSync only accepts subtree searches of a partition root
                 const_cast<wchar_t*>(config.filter.c_str()),
                 isWildcard ? NULL : attrList.data(),
                 0,
-                serverControls,
+                serverControls.data(),
                 clientControls,
                 &timeout,
                 config.sizeLimit,
@@ -223,18 +740,24 @@ namespace LDAPUtils
             {
                 std::wcerr << L"LDAP search error. Code: " << returnCode << std::endl;
                 if (pSearchResult) ldap_msgfree(pSearchResult);
-                if (cookie.bv_val) free(cookie.bv_val);
-                return;
+                if (pageControl) ldap_control_freeW(pageControl);
+                if (pageCookie) ber_bvfree(pageCookie);
+                if (dirSyncValue) ber_bvfree(dirSyncValue);
+                freeSortControls();
+                return false;
             }
+            auto decodeStart = std::chrono::steady_clock::now();
+            page.serverMs = std::chrono::duration<double, std::milli>(decodeStart - pageStart).count();
 
             int entryCount = ldap_count_entries(ldapConnection, pSearchResult);
             totalEntries += entryCount;
-            std::wcout << L"Found " << entryCount << L" entries in this page (Total: " << totalEntries << L")" << std::endl;
+            if (verbose)
+                std::wcout << L"Found " << entryCount << L" entries in this page (Total: " << totalEntries << L")" << std::endl;
 
-            if (entryCount == 0)
+            // An empty DirSync round still carries a newer cookie
+            if (entryCount == 0 && !dirSync)
             {
                 ldap_msgfree(pSearchResult);
-                if (cookie.bv_val) free(cookie.bv_val);
                 break;
             }
 
@@ -246,48 +769,75 @@ namespace LDAPUtils
                 std::wstring dn_str = dn ? dn : L"";
                 ldap_memfree(dn);
 
-                std::wcout << L"\nEntry " << currentEntry << L"/" << totalEntries << L":" << std::endl;
-                std::wcout << L"DN: " << dn_str << std::endl;
+                if (verbose)
+                {
+                    std::wcout << L"\nEntry " << currentEntry << L"/" << totalEntries << L":" << std::endl;
+                    std::wcout << L"DN: " << dn_str << std::endl;
+                }
 
                 Entry e;
                 e.dn = dn_str;
+                accumulator.BeginEntry();
+                if (outTree)
+                    outTree->Insert(dn_str, currentEntry - 1);
 
+                bool entryRanged = false;
                 BerElement* pBer = NULL;
                 wchar_t* attribute = ldap_first_attributeW(ldapConnection, pEntry, &pBer);
                 while (attribute != NULL)
                 {
-                    if (collectForExport)
+                    std::wstring name = attribute;
+                    unsigned long rangeHigh = 0;
+                    bool rangeLast = false;
+                    bool retrieve = ParseRange(attribute, name, rangeHigh, rangeLast) && !rangeLast &&
+                        (collectEntries || StatisticsProfile::Active().IndexOf(name) != StatisticsProfile::npos);
+                    if (retrieve)
                     {
-                        allAttributes.insert(attribute);
+                        ranged.push_back({ collectEntries ? entries.size() : rangedOnly.size(), name, rangeHigh + 1 });
+                        entryRanged = true;
+                    }
+
+                    if (collectEntries)
+                    {
+                        allAttributes.insert(name);
                     }
 
                     wchar_t** vals = ldap_get_valuesW(ldapConnection, pEntry, attribute);
                     struct berval** bvals = ldap_get_values_lenW(ldapConnection, pEntry, attribute);
                     int valCount = vals ? ldap_count_valuesW(vals) : 0;
 
-                    std::vector<std::wstring> fvals;
+                    ValueKind kind = Schema::Active().KindOf(name);
+                    std::vector<Value> fvals;
                     for (int i = 0; i < valCount; ++i)
                     {
-                        std::wstring fval = Converters::FormatAttributeValue(
-                            std::wstring(attribute), vals[i], bvals && bvals[i] ? bvals[i] : nullptr);
-                        fvals.push_back(fval);
+                        fvals.push_back(Converters::DecodeAttributeValue(
+                            kind, vals[i], bvals && bvals[i] ? bvals[i] : nullptr));
                     }
 
                     if (!fvals.empty())
                     {
-                        e.attrs[attribute] = std::move(fvals);
+                        if (!retrieve)
+                            accumulator.AddAttribute(name, fvals);
+                        e.attrs[name] = std::move(fvals);
+                    }
+                    else if (dirSync)
+                    {
+                        e.attrs[name];     // DirSync reports a cleared attribute with no values
                     }
 
-                    std::wcout << L"  " << attribute;
-                    if (valCount > 1)
-                        std::wcout << L" (" << valCount << L")";
-                    std::wcout << L": ";
-                    for (int i = 0; i < valCount; ++i)
+                    if (verbose)
                     {
-                        if (i > 0) std::wcout << L"; ";
-                        std::wcout << e.attrs[attribute][i];
+                        std::wcout << L"  " << name;
+                        if (valCount > 1)
+                            std::wcout << L" (" << valCount << L")";
+                        std::wcout << L": ";
+                        for (int i = 0; i < valCount; ++i)
+                        {
+                            if (i > 0) std::wcout << L"; ";
+                            std::wcout << Converters::DisplayValue(name, e.attrs[name][i]);
+                        }
+                        std::wcout << L";" << std::endl;
                     }
-                    std::wcout << L";" << std::endl;
 
                     if (vals) ldap_value_freeW(vals);
                     if (bvals) ldap_value_free_len(bvals);
@@ -296,37 +846,68 @@ namespace LDAPUtils
                 }
                 if (pBer) ber_free(pBer, 0);
 
-                if (collectForExport)
+                if (collectEntries)
                 {
                     entries.push_back(std::move(e));
                 }
+                else if (entryRanged)
+                {
+                    rangedOnly.push_back(std::move(e));
+                }
 
-                std::wcout << L"\n" << std::wstring(70, L'=') << std::endl;
+                if (verbose)
+                    std::wcout << L"\n" << std::wstring(70, L'=') << std::endl;
 
                 pEntry = ldap_next_entry(ldapConnection, pEntry);
                 ++currentEntry;
             }
 
+            page.returned = static_cast<unsigned long>(entryCount);
+            page.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
+
             LDAPControlW** returnedControls = NULL;
+            bool dirSyncResponded = false;
+            berval* nextCookie = NULL;
             if (ldap_parse_resultW(ldapConnection, pSearchResult, NULL, NULL, NULL, NULL, &returnedControls, FALSE) == 0)
             {
-                for (unsigned long i = 0; returnedControls && returnedControls[i]; ++i)
+                if (sortControl && returnedControls)
                 {
-                    if (wcscmp(returnedControls[i]->ldctl_oid, L"1.2.840.113556.1.4.319") == 0)
+                    unsigned long sortResult = 0;
+                    wchar_t* sortAttribute = NULL;
+                    if (ldap_parse_sort_controlW(ldapConnection, returnedControls, &sortResult, &sortAttribute) == 0 &&
+                        sortResult != 0 && !sortWarned)
                     {
-                        cookie.bv_len = returnedControls[i]->ldctl_value.bv_len;
-                        if (cookie.bv_len > 0)
-                        {
-                            cookie.bv_val = (char*)malloc(cookie.bv_len);
-                            if (cookie.bv_val)
-                                memcpy(cookie.bv_val, returnedControls[i]->ldctl_value.bv_val, cookie.bv_len);
-                            else
-                                morePages = false;
-                        }
-                        else
-                        {
-                            morePages = false;
-                        }
+                        std::wcerr << L"Warning: server did not sort the result (code " << sortResult
+                            << (sortAttribute ? L", attribute " + std::wstring(sortAttribute) : L"") << L")" << std::endl;
+                        sortWarned = true;
+                    }
+                    if (sortAttribute) ldap_memfree(sortAttribute);
+                }
+                if (windowControl && returnedControls)
+                {
+                    berval* context = NULL;
+                    int windowResult = 0;
+                    if (ldap_parse_vlv_controlW(ldapConnection, returnedControls, &lastWindow.target,
+                            &lastWindow.contentCount, &context, &windowResult) == 0 && windowResult != 0)
+                    {
+                        std::wcerr << L"Warning: VLV window failed (code " << windowResult << L")" << std::endl;
+                    }
+                    if (context) ber_bvfree(context);
+                }
+                if (paged && returnedControls)
+                {
+                    unsigned long estimate = 0;
+                    if (ldap_parse_page_controlW(ldapConnection, returnedControls, &estimate, &nextCookie) != 0)
+                        nextCookie = NULL;
+                }
+                for (unsigned long i = 0; dirSync && returnedControls && returnedControls[i]; ++i)
+                {
+                    if (wcscmp(returnedControls[i]->ldctl_oid, kDirSyncOid) == 0)
+                    {
+                        bool moreData = false;
+                        dirSyncResponded = DecodeDirSyncResponse(returnedControls[i]->ldctl_value, moreData, dirSyncCookie) &&
+                            SaveDirSyncCookie(config.dirSyncCookieFile, dirSyncCookie);
+                        morePages = dirSyncResponded && moreData;
                         break;
                     }
                 }
@@ -336,23 +917,71 @@ namespace LDAPUtils
             ldap_msgfree(pSearchResult);
             pSearchResult = NULL;
 
-            if (cookie.bv_val)
+            if (dirSync)
             {
-                pageControl.ldctl_value = cookie;
+                if (!dirSyncResponded)
+                {
+                    std::wcerr << L"Server did not return a usable DirSync cookie" << std::endl;
+                    if (dirSyncValue) ber_bvfree(dirSyncValue);
+                    return false;
+                }
             }
             else
             {
-                morePages = false;
+                // An empty cookie marks the last page
+                if (pageCookie) ber_bvfree(pageCookie);
+                pageCookie = NULL;
+                if (nextCookie && nextCookie->bv_len > 0)
+                    pageCookie = nextCookie;
+                else if (nextCookie)
+                    ber_bvfree(nextCookie);
+                morePages = pageCookie != NULL;
+            }
+
+            if (paged)
+            {
+                tuner.Record(page, morePages);
+                if (verbose)
+                    tuner.PrintPage(tuner.Pages().size() - 1);
             }
         }
 
-        if (cookie.bv_val) free(cookie.bv_val);
+        if (pageControl) ldap_control_freeW(pageControl);
+        if (pageCookie) ber_bvfree(pageCookie);
+        if (dirSyncValue) ber_bvfree(dirSyncValue);
+        freeSortControls();
+
+        if (verbose && paged)
+            tuner.PrintSummary();
+        if (verbose && windowed)
+            std::wcout << L"\nWindow: target position " << lastWindow.target << L" of about "
+                << lastWindow.contentCount << L" entries" << std::endl;
+
+        if (!ranged.empty())
+        {
+            std::vector<Entry>& rangedEntries = collectEntries ? entries : rangedOnly;
+            std::vector<RangedAttribute> completed = ranged;
+            if (!RetrieveRanges(rangedEntries, std::move(ranged), config.showDeleted, verbose))
+            {
+                std::wcerr << L"Ranged attribute values are incomplete" << std::endl;
+                return false;
+            }
+            for (const auto& range : completed)
+            {
+                auto it = rangedEntries[range.entry].attrs.find(range.name);
+                if (it != rangedEntries[range.entry].attrs.end() && !it->second.empty())
+                    accumulator.AddAttribute(range.name, it->second);
+            }
+            rangedOnly.clear();
+        }
 
-        std::wcout << L"\nTotal entries found: " << totalEntries << std::endl;
+        if (verbose)
+            std::wcout << L"\nTotal entries found: " << totalEntries << std::endl;
 
-        // Calculate statistics
-        outStats = StatisticsCalculator::Calculate(entries);
-        StatisticsCalculator::PrintStatistics(outStats);
+        // Statistics were accumulated while decoding, so they also cover console-only runs
+        outStats = accumulator.Finish();
+        if (verbose && config.showStats)
+            StatisticsCalculator::PrintStatistics(outStats);
 
         // Export if needed
         if (collectForExport && !entries.empty())
@@ -360,40 +989,22 @@ namespace LDAPUtils
             std::vector<std::wstring> exportAttributes = isWildcard ?
                 std::vector<std::wstring>(allAttributes.begin(), allAttributes.end()) : attributes;
 
-            std::wcout << L"\n*** Exporting results..." << std::endl;
-            std::wcout << L"Format: ";
+            if (verbose)
+                std::wcout << L"\n*** Exporting results..." << std::endl
+                    << L"Format: " << Exporter::FormatName(config.format) << std::endl;
 
-            switch (config.format)
+            if (!Exporter::Export(config, exportAttributes, entries, outStats))
+                return false;
+
+            if (verbose)
             {
-            case OutputFormat::CSV:
-                std::wcout << L"CSV" << std::endl;
-                Exporter::ExportCsv(config.outputFile, exportAttributes, entries);
-                break;
-            case OutputFormat::TXT:
-                std::wcout << L"TXT" << std::endl;
-                Exporter::ExportTxt(config.outputFile, entries);
-                break;
-            case OutputFormat::JSON:
-                std::wcout << L"JSON" << std::endl;
-                Exporter::ExportJson(config.outputFile, entries);
-                break;
-            case OutputFormat::XML:
-                std::wcout << L"XML" << std::endl;
-                Exporter::ExportXml(config.outputFile, entries);
-                break;
-            case OutputFormat::HTML:
-                std::wcout << L"HTML (Interactive UI)" << std::endl;
-                Exporter::ExportHtml(config.outputFile, exportAttributes, entries, outStats);
-                break;
-            default:
-                break;
+                std::wcout << L"✓ Export successful: " << config.outputFile << std::endl;
+                std::wcout << L"  Total entries: " << entries.size() << std::endl;
+                std::wcout << L"  Total attributes: " << exportAttributes.size() << std::endl;
             }
-
-            std::wcout << L"✓ Export successful: " << config.outputFile << std::endl;
-            std::wcout << L"  Total entries: " << entries.size() << std::endl;
-            std::wcout << L"  Total attributes: " << exportAttributes.size() << std::endl;
         }
 
         outEntries = std::move(entries);
+        return true;
     }
 }
\ No newline at end of file
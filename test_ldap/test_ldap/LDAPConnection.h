@@ -1,7 +1,12 @@
 #pragma once
 #include "LDAPTypes.h"
+#include "LDAPDnTree.h"
+#include "LDAPPaging.h"
 #include <windows.h>
 #include <winldap.h>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 #pragma comment(lib, "wldap32.lib")
 
@@ -9,8 +14,31 @@ namespace LDAPUtils
 {
     class LDAPConnection
     {
+    public:
+        // Where the last windowed (VLV) search landed in the sorted result
+        struct WindowPosition
+        {
+            unsigned long target = 0;
+            unsigned long contentCount = 0;
+        };
+
     private:
         LDAP* ldapConnection;
+        WindowPosition lastWindow;
+        unsigned long maxPageSize = 0;  // From the DC's query policy; 0 = not read yet
+
+        // An attribute the server returned as "name;range=low-high" with more values to fetch
+        struct RangedAttribute
+        {
+            size_t entry;
+            std::wstring name;
+            unsigned long next;
+        };
+
+        // Fetches the remaining values with pipelined base searches and appends them
+        // to entries[entry].attrs[name]
+        bool RetrieveRanges(std::vector<Entry>& entries, std::vector<RangedAttribute> pending, bool showDeleted,
+            bool verbose);
 
     public:
         LDAPConnection(const std::wstring& serverAddress, unsigned long port = 389);
@@ -19,9 +47,45 @@ namespace LDAPUtils
         bool Connect(const std::wstring& username, const std::wstring& password, const std::wstring& domain);
         void Disconnect();
 
-        void Search(const SearchConfig& config, std::vector<Entry>& outEntries, Statistics& outStats);
+        // outTree, when given, receives every DN as it arrives (entry numbers in arrival order).
+        // False when the search fails or the export config asks for cannot be written
+        bool Search(const SearchConfig& config, std::vector<Entry>& outEntries, Statistics& outStats,
+            DnTree* outTree = nullptr);
         bool SearchByDN(const std::wstring& dn, Entry& outEntry);
+        const WindowPosition& LastWindow() const { return lastWindow; }
+        // MaxPageSize of the DC's default query policy, read once per connection
+        unsigned long ServerMaxPageSize();
         void SearchByAttribute(const std::wstring& attrName, const std::wstring& attrValue,
             const SearchConfig& config, std::vector<Entry>& outEntries);
+
+        // Opaque DirSync cookie kept between runs; a missing file means start from scratch
+        static bool LoadDirSyncCookie(const std::wstring& filename, std::string& outCookie);
+        static bool SaveDirSyncCookie(const std::wstring& filename, const std::string& cookie);
+
+        // "10000-10100" (1-based, inclusive) into SearchConfig::windowOffset/windowSize
+        static bool ParseWindow(const std::wstring& range, SearchConfig& config);
+    };
+
+    // Fixed set of bound connections shared by concurrent searches; Acquire blocks
+    // until one is idle, so the pool size is also the concurrency limit.
+    class LDAPConnectionPool
+    {
+    private:
+        SearchConfig config;            // Server and credentials, to bind replacements
+        std::vector<std::unique_ptr<LDAPConnection>> connections;
+        std::vector<LDAPConnection*> idle;
+        std::mutex mutex;
+        std::condition_variable available;
+
+    public:
+        bool Open(const SearchConfig& config, size_t size);
+        size_t Size() const { return connections.size(); }
+
+        LDAPConnection* Acquire();
+        void Release(LDAPConnection* connection);
+        // Replaces an acquired connection the server may have dropped (idle timeout,
+        // DC restart) with a newly bound one, which the caller then uses and
+        // releases. Keeps and returns the old one when the new bind fails
+        LDAPConnection* Reconnect(LDAPConnection* connection);
     };
 }
\ No newline at end of file
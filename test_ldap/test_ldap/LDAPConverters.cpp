@@ -41,26 +41,30 @@ namespace LDAPUtils
 
     std::wstring Converters::ConvertLDAPTimeToLocal(const std::wstring& ldapTime)
     {
-        if (ldapTime.empty()) return L"";
+        // YYYYMMDDHHMMSS, then fraction and zone; anything else is shown as sent
+        if (ldapTime.size() < 14 || !std::all_of(ldapTime.begin(), ldapTime.begin() + 14, [](wchar_t c) { return c >= L'0' && c <= L'9'; }))
+            return ldapTime;
+        auto digits = [&](size_t pos, size_t count)
+        {
+            WORD value = 0;
+            for (size_t i = pos; i < pos + count; ++i)
+                value = static_cast<WORD>(value * 10 + (ldapTime[i] - L'0'));
+            return value;
+        };
+
         SYSTEMTIME utcSystemTime = { 0 };
-        utcSystemTime.wYear = std::stoi(ldapTime.substr(0, 4));
-        utcSystemTime.wMonth = std::stoi(ldapTime.substr(4, 2));
-        utcSystemTime.wDay = std::stoi(ldapTime.substr(6, 2));
-        utcSystemTime.wHour = std::stoi(ldapTime.substr(8, 2));
-        utcSystemTime.wMinute = std::stoi(ldapTime.substr(10, 2));
-        utcSystemTime.wSecond = std::stoi(ldapTime.substr(12, 2));
-
-        SYSTEMTIME localTime;
-        TIME_ZONE_INFORMATION tzInfo;
-        GetTimeZoneInformation(&tzInfo);
-        SystemTimeToTzSpecificLocalTime(&tzInfo, &utcSystemTime, &localTime);
+        utcSystemTime.wYear = digits(0, 4);
+        utcSystemTime.wMonth = digits(4, 2);
+        utcSystemTime.wDay = digits(6, 2);
+        utcSystemTime.wHour = digits(8, 2);
+        utcSystemTime.wMinute = digits(10, 2);
+        utcSystemTime.wSecond = digits(12, 2);
 
-        std::wstringstream ss;
-        ss << std::setfill(L'0') << std::setw(2) << localTime.wMonth << L"/"
-            << std::setw(2) << localTime.wDay << L"/" << localTime.wYear << L" "
-            << std::setw(2) << localTime.wHour << L":" << std::setw(2) << localTime.wMinute << L":"
-            << std::setw(2) << localTime.wSecond;
-        return ss.str();
+        // Rejects fields out of range, such as month 13
+        FILETIME fileTime;
+        if (!SystemTimeToFileTime(&utcSystemTime, &fileTime))
+            return ldapTime;
+        return ConvertFileTimeToLocal((static_cast<unsigned long long>(fileTime.dwHighDateTime) << 32) | fileTime.dwLowDateTime);
     }
 
     std::wstring Converters::ConvertTicksToDuration(long long ticks)
@@ -189,79 +193,220 @@ namespace LDAPUtils
         }
     }
 
-    std::wstring LDAPUtils::Converters::FormatAttributeValue(const std::wstring& attrName, wchar_t* val, struct berval* bval)
+    std::wstring Converters::GetFlagName(const std::wstring& attrName, unsigned int bit)
     {
-        if (!val) return L"";
+        static const wchar_t* userAccountControlFlags[32] = {
+            L"SCRIPT", L"ACCOUNTDISABLE", nullptr, L"HOMEDIR_REQUIRED",
+            L"LOCKOUT", L"PASSWD_NOTREQD", L"PASSWD_CANT_CHANGE", L"ENCRYPTED_TEXT_PWD_ALLOWED",
+            L"TEMP_DUPLICATE_ACCOUNT", L"NORMAL_ACCOUNT", nullptr, L"INTERDOMAIN_TRUST_ACCOUNT",
+            L"WORKSTATION_TRUST_ACCOUNT", L"SERVER_TRUST_ACCOUNT", nullptr, nullptr,
+            L"DONT_EXPIRE_PASSWORD", L"MNS_LOGON_ACCOUNT", L"SMARTCARD_REQUIRED", L"TRUSTED_FOR_DELEGATION",
+            L"NOT_DELEGATED", L"USE_DES_KEY_ONLY", L"DONT_REQ_PREAUTH", L"PASSWORD_EXPIRED",
+            L"TRUSTED_TO_AUTH_FOR_DELEGATION", nullptr, L"PARTIAL_SECRETS_ACCOUNT", nullptr,
+            nullptr, nullptr, nullptr, nullptr };
+        static const wchar_t* groupTypeFlags[32] = {
+            L"BUILTIN_LOCAL_GROUP", L"ACCOUNT_GROUP", L"RESOURCE_GROUP", L"UNIVERSAL_GROUP",
+            L"APP_BASIC_GROUP", L"APP_QUERY_GROUP", nullptr, nullptr,
+            nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+            nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+            nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, L"SECURITY_ENABLED" };
 
-        std::wstringstream output;
-        bool isBinary = (bval && bval->bv_len > 0 && val[0] == L'\0');
+        const wchar_t* name = nullptr;
+        if (bit < 32)
+        {
+            if (_wcsicmp(attrName.c_str(), L"userAccountControl") == 0) name = userAccountControlFlags[bit];
+            else if (_wcsicmp(attrName.c_str(), L"groupType") == 0) name = groupTypeFlags[bit];
+            else if (_wcsicmp(attrName.c_str(), L"instanceType") == 0 && bit == 0) name = L"IS_NC_HEAD";
+            else if (_wcsicmp(attrName.c_str(), L"instanceType") == 0 && bit == 2) name = L"WRITE";
+            else if (_wcsicmp(attrName.c_str(), L"systemFlags") == 0 && bit == 26) name = L"DOMAIN_DISALLOW_RENAME";
+            else if (_wcsicmp(attrName.c_str(), L"systemFlags") == 0 && bit == 27) name = L"DOMAIN_DISALLOW_MOVE";
+            else if (_wcsicmp(attrName.c_str(), L"systemFlags") == 0 && bit == 31) name = L"DISALLOW_DELETE";
+        }
+        if (name) return name;
 
-        if (attrName == L"dSASignature" && bval)
+        std::wstringstream ss;
+        ss << L"0x" << std::hex << std::setw(8) << std::setfill(L'0') << (1u << (bit & 31));
+        return ss.str();
+    }
+
+    unsigned long long Converters::ParseTimestampTicks(const std::wstring& value)
+    {
+        if (value.empty()) return 0;
+
+        SYSTEMTIME st = { 0 };
+        if (value.find(L'/') != std::wstring::npos)
         {
-            output << ConvertDSASignature((unsigned char*)bval->bv_val, bval->bv_len, false);
+            // MM/DD/YYYY HH:MM:SS as produced by ConvertFileTimeToLocal
+            if (swscanf(value.c_str(), L"%hu/%hu/%hu %hu:%hu:%hu",
+                &st.wMonth, &st.wDay, &st.wYear, &st.wHour, &st.wMinute, &st.wSecond) < 3)
+                return 0;
         }
-        else if (isBinary)
+        else if (value.size() >= 14 && (value.find(L'Z') != std::wstring::npos || value.find(L'.') != std::wstring::npos))
         {
-            output << L"<Binary " << bval->bv_len << L" bytes>";
+            // Generalized time: YYYYMMDDHHMMSS.0Z
+            if (swscanf(value.c_str(), L"%4hu%2hu%2hu%2hu%2hu%2hu",
+                &st.wYear, &st.wMonth, &st.wDay, &st.wHour, &st.wMinute, &st.wSecond) != 6)
+                return 0;
         }
         else
         {
-            output << val;
+            // Integer FILETIME ticks; 0 and 0x7FFFFFFFFFFFFFFF both mean "never"
+            long long ticks = _wtoi64(value.c_str());
+            return (ticks <= 0 || ticks == 0x7FFFFFFFFFFFFFFFLL) ? 0 : static_cast<unsigned long long>(ticks);
         }
 
-        if (attrName == L"whenCreated" || attrName == L"whenChanged")
+        FILETIME ft;
+        if (!SystemTimeToFileTime(&st, &ft)) return 0;
+        return (static_cast<unsigned long long>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    }
+
+    unsigned long long Converters::TimestampTicks(const Value& value)
+    {
+        switch (value.kind())
         {
-            output.str(L"");
-            output << ConvertLDAPTimeToLocal(val);
+        case ValueKind::TIME:
+            return value.Number() > 0 ? static_cast<unsigned long long>(value.Number()) : 0;
+        case ValueKind::FILETIME:
+            // 0 and 0x7FFFFFFFFFFFFFFF both mean "never"
+            return (value.Number() <= 0 || value.Number() == 0x7FFFFFFFFFFFFFFFLL) ? 0 :
+                static_cast<unsigned long long>(value.Number());
+        default:
+            return ParseTimestampTicks(value);
         }
-        else if (attrName == L"lastLogonTimestamp" || attrName == L"lastLogon")
+    }
+
+    Value Converters::DecodeAttributeValue(ValueKind kind, const wchar_t* val, struct berval* bval)
+    {
+        if (!val) return Value();
+
+        const unsigned char* bytes = bval ? reinterpret_cast<const unsigned char*>(bval->bv_val) : nullptr;
+        switch (kind)
         {
-            output.str(L"");
-            unsigned long long ticks = _wtoi64(val);
-            output << (ticks == 0 ? L"0" : ConvertFileTimeToLocal(ticks));
+        case ValueKind::INTEGER:
+        case ValueKind::TIME:
+        case ValueKind::FILETIME:
+            return Value(val, kind);
+
+        case ValueKind::GUID:
+            return bval ? Value(ConvertGUIDToString(bytes, bval->bv_len), ValueKind::GUID) : Value(val);
+
+        case ValueKind::SID:
+            return bval ? Value(ConvertSIDToString(bytes, bval->bv_len), ValueKind::SID) : Value(val);
+
+        case ValueKind::BINARY:
+            if (!bval)
+            {
+                // LDIF values written as plain text
+                std::string text = WStringToUtf8(val);
+                return Value(EncodeBase64(reinterpret_cast<const unsigned char*>(text.data()),
+                    static_cast<unsigned long>(text.size())), ValueKind::BINARY);
+            }
+            return Value(EncodeBase64(bytes, bval->bv_len), ValueKind::BINARY);
+
+        default:
+            // Text attributes holding bytes that are not UTF-8
+            if (bval && bval->bv_len > 0 && val[0] == L'\0')
+                return Value(EncodeBase64(bytes, bval->bv_len), ValueKind::BINARY);
+            return Value(val);
         }
-        else if (ToLower(attrName).find(L"guid") != std::wstring::npos && bval)
+    }
+
+    std::wstring Converters::DisplayValue(const std::wstring& attrName, const Value& value)
+    {
+        // Names come from profiles and command lines as well as the server
+        auto is = [&](const wchar_t* name) { return _wcsicmp(attrName.c_str(), name) == 0; };
+
+        std::wstringstream output;
+        switch (value.kind())
         {
-            output.str(L"");
-            output << ConvertGUIDToString((unsigned char*)bval->bv_val, bval->bv_len);
-        }
-        else if (ToLower(attrName).find(L"sid") != std::wstring::npos && bval)
+        case ValueKind::TIME:
+            return ConvertLDAPTimeToLocal(value);
+
+        case ValueKind::FILETIME:
         {
-            output.str(L"");
-            output << ConvertSIDToString((unsigned char*)bval->bv_val, bval->bv_len);
+            long long ticks = value.Number();
+            if (ticks == 0x7FFFFFFFFFFFFFFFLL)
+                return L"never";
+            return ticks <= 0 ? value.str() : ConvertFileTimeToLocal(static_cast<unsigned long long>(ticks));
         }
-        else if (attrName == L"instanceType")
+
+        case ValueKind::INTEGER:
         {
-            output.str(L"");
-            int value = static_cast<int>(_wtol(val));
-            output << L"0x" << std::hex << value << L" " << GetInstanceTypeDescription(value);
+            int number = static_cast<int>(value.Number());
+            if (is(L"instanceType"))
+                output << L"0x" << std::hex << number << L" " << GetInstanceTypeDescription(number);
+            else if (is(L"systemFlags"))
+                output << L"0x" << std::hex << number << L" " << GetSystemFlagsDescription(number);
+            else if (is(L"userAccountControl"))
+                output << L"0x" << std::hex << number << GetUserAccountControlDescription(number);
+            else if (is(L"groupType"))
+                output << L"0x" << std::hex << number << GetGroupTypeDescription(number);
+            else if (is(L"sAMAccountType"))
+                output << number << L" " << GetSAMAccountTypeDescription(number);
+            else
+                return value;
+            return output.str();
         }
-        else if (attrName == L"systemFlags")
+
+        case ValueKind::BINARY:
         {
-            output.str(L"");
-            int value = static_cast<int>(_wtol(val));
-            output << L"0x" << std::hex << value << L" " << GetSystemFlagsDescription(value);
+            std::string bytes;
+            DecodeBase64(WStringToUtf8(value), bytes);
+            if (is(L"dSASignature"))
+                return ConvertDSASignature(reinterpret_cast<const unsigned char*>(bytes.data()),
+                    static_cast<unsigned long>(bytes.size()), false);
+            output << L"<Binary " << bytes.size() << L" bytes>";
+            return output.str();
         }
-        else if (attrName == L"userAccountControl")
-        {
-            output.str(L"");
-            int value = static_cast<int>(_wtol(val));
-            output << L"0x" << std::hex << value << GetUserAccountControlDescription(value);
+
+        default:
+            return value;
         }
-        else if (attrName == L"groupType")
+    }
+
+    std::wstring Converters::EncodeBase64(const unsigned char* data, unsigned long length)
+    {
+        static const wchar_t digits[] = L"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::wstring out;
+        out.reserve((length + 2) / 3 * 4);
+        for (unsigned long i = 0; i < length; i += 3)
         {
-            output.str(L"");
-            int value = static_cast<int>(_wtol(val));
-            output << L"0x" << std::hex << value << GetGroupTypeDescription(value);
+            unsigned int group = static_cast<unsigned int>(data[i]) << 16;
+            if (i + 1 < length) group |= static_cast<unsigned int>(data[i + 1]) << 8;
+            if (i + 2 < length) group |= data[i + 2];
+            out += digits[(group >> 18) & 63];
+            out += digits[(group >> 12) & 63];
+            out += i + 1 < length ? digits[(group >> 6) & 63] : L'=';
+            out += i + 2 < length ? digits[group & 63] : L'=';
         }
-        else if (attrName == L"sAMAccountType")
+        return out;
+    }
+
+    bool Converters::DecodeBase64(const std::string& text, std::string& out)
+    {
+        out.clear();
+        unsigned int buffer = 0;
+        int bits = 0;
+        for (char c : text)
         {
-            output.str(L"");
-            int value = static_cast<int>(_wtol(val));
-            output << value << L" " << GetSAMAccountTypeDescription(value);
-        }
+            int value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '+') value = 62;
+            else if (c == '/') value = 63;
+            else if (c == '=' || c == ' ') continue;
+            else return false;
 
-        return output.str();
+            buffer = (buffer << 6) | value;
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                out += static_cast<char>((buffer >> bits) & 0xFF);
+            }
+        }
+        return true;
     }
 
     std::string Converters::WStringToUtf8(const std::wstring& ws)
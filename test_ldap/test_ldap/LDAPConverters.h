@@ -1,4 +1,5 @@
 #pragma once
+#include "LDAPValue.h"
 #include <string>
 #include <sstream>
 #include <windows.h>
@@ -25,9 +26,26 @@ namespace LDAPUtils
         static std::wstring GetUserAccountControlDescription(int value);
         static std::wstring GetGroupTypeDescription(int value);
         static std::wstring GetSAMAccountTypeDescription(int value);
+        static std::wstring GetFlagName(const std::wstring& attrName, unsigned int bit);
 
-        // Format attribute value
-        static std::wstring FormatAttributeValue(const std::wstring& attrName, wchar_t* val, struct berval* bval);
+        // Parse a raw or formatted timestamp (FILETIME ticks, generalized time or
+        // MM/DD/YYYY HH:MM:SS) into FILETIME ticks, 0 when never set or unparseable
+        static unsigned long long ParseTimestampTicks(const std::wstring& value);
+
+        // FILETIME ticks of a stored value: native for TIME and FILETIME values,
+        // parsed from the text otherwise; 0 when never set or not a timestamp
+        static unsigned long long TimestampTicks(const Value& value);
+
+        // Server value as stored in an Entry, for an attribute of the given kind
+        // (Schema::KindOf): text, integers and timestamps as sent, GUIDs and SIDs
+        // in string form, other binary values as base64
+        static Value DecodeAttributeValue(ValueKind kind, const wchar_t* val, struct berval* bval);
+        // Human-readable form of a stored value: flags and codes with their
+        // names, timestamps in local time, binary values by size
+        static std::wstring DisplayValue(const std::wstring& attrName, const Value& value);
+
+        static std::wstring EncodeBase64(const unsigned char* data, unsigned long length);
+        static bool DecodeBase64(const std::string& text, std::string& out);
 
         // String conversions
         static std::string WStringToUtf8(const std::wstring& ws);
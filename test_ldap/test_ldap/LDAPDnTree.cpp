@@ -0,0 +1,431 @@
+﻿#include "LDAPDnTree.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cwctype>
+#include <cwchar>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        // towlower is a locale call; directory data is overwhelmingly ASCII
+        inline wchar_t FoldCase(wchar_t c)
+        {
+            if (c < 0x80)
+                return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + 32) : c;
+            return static_cast<wchar_t>(towlower(c));
+        }
+
+        int HexDigit(wchar_t c)
+        {
+            if (c >= L'0' && c <= L'9') return c - L'0';
+            if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+            if (c >= L'A' && c <= L'F') return c - L'A' + 10;
+            return -1;
+        }
+
+        // Leading spaces and unescaped trailing spaces are not part of an RDN
+        std::wstring Trim(const std::wstring& text)
+        {
+            size_t begin = text.find_first_not_of(L' ');
+            if (begin == std::wstring::npos)
+                return L"";
+            size_t end = text.size();
+            while (end > begin + 1 && text[end - 1] == L' ' && text[end - 2] != L'\\')
+                --end;
+            return text.substr(begin, end - begin);
+        }
+
+        // [begin, end) of each RDN of dn as written, leaf first, spaces trimmed
+        void RdnSpans(const std::wstring& dn, std::vector<std::pair<size_t, size_t>>& spans)
+        {
+            spans.clear();
+            size_t start = 0;
+            bool quoted = false;
+            for (size_t i = 0; i <= dn.size(); ++i)
+            {
+                if (i < dn.size())
+                {
+                    wchar_t c = dn[i];
+                    if (c == L'\\')
+                    {
+                        ++i;
+                        continue;
+                    }
+                    if (c == L'"')
+                        quoted = !quoted;
+                    if (quoted || (c != L',' && c != L';'))
+                        continue;
+                }
+
+                size_t begin = start, end = std::min(i, dn.size());
+                while (begin < end && dn[begin] == L' ')
+                    ++begin;
+                while (end > begin + 1 && dn[end - 1] == L' ' && dn[end - 2] != L'\\')
+                    --end;
+                spans.emplace_back(begin, end);
+                start = i + 1;
+            }
+            if (spans.size() == 1 && spans[0].first == spans[0].second)
+                spans.clear();
+        }
+
+        // Splits on separator outside escapes and quotes
+        std::vector<std::wstring> SplitUnescaped(const std::wstring& text, const wchar_t* separators)
+        {
+            std::vector<std::wstring> parts;
+            std::wstring current;
+            bool quoted = false;
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                wchar_t c = text[i];
+                if (c == L'\\' && i + 1 < text.size())
+                {
+                    current += c;
+                    current += text[++i];
+                    continue;
+                }
+                if (c == L'"')
+                    quoted = !quoted;
+                if (!quoted && wcschr(separators, c))
+                {
+                    parts.push_back(current);
+                    current.clear();
+                    continue;
+                }
+                current += c;
+            }
+            parts.push_back(current);
+            return parts;
+        }
+
+        // Case-folded value with one spelling per character: "\2C", "\," and a
+        // quoted "," all become "\,"
+        std::wstring NormalizeValue(const std::wstring& raw)
+        {
+            std::wstring value = raw;
+            bool quoted = value.size() >= 2 && value.front() == L'"' && value.back() == L'"';
+            if (quoted)
+                value = value.substr(1, value.size() - 2);
+
+            std::wstring decoded;
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                wchar_t c = value[i];
+                if (c == L'\\' && !quoted && i + 1 < value.size())
+                {
+                    int high = HexDigit(value[i + 1]);
+                    int low = i + 2 < value.size() ? HexDigit(value[i + 2]) : -1;
+                    if (high >= 0 && low >= 0 && high < 8)
+                    {
+                        c = static_cast<wchar_t>(high * 16 + low);
+                        i += 2;
+                    }
+                    else if (high >= 0 && low >= 0)
+                    {
+                        // Non-ASCII UTF-8 byte: keep the escape, lower-cased
+                        decoded += L'\\';
+                        decoded += static_cast<wchar_t>(towlower(value[i + 1]));
+                        decoded += static_cast<wchar_t>(towlower(value[i + 2]));
+                        i += 2;
+                        continue;
+                    }
+                    else
+                    {
+                        c = value[++i];
+                    }
+                }
+
+                if (wcschr(L",+\"\\<>;=", c) || (decoded.empty() && (c == L' ' || c == L'#')))
+                    decoded += L'\\';
+                decoded += FoldCase(c);
+            }
+            if (!decoded.empty() && decoded.back() == L' ')
+                decoded.insert(decoded.size() - 1, 1, L'\\');
+            return decoded;
+        }
+    }
+
+    DnTree::DnTree()
+    {
+        nodes.emplace_back();
+    }
+
+    std::vector<std::wstring> DnTree::Split(const std::wstring& dn, bool normalize)
+    {
+        std::vector<std::pair<size_t, size_t>> spans;
+        RdnSpans(dn, spans);
+
+        std::vector<std::wstring> rdns;
+        rdns.reserve(spans.size());
+        for (auto span = spans.rbegin(); span != spans.rend(); ++span)
+        {
+            std::wstring rdn = dn.substr(span->first, span->second - span->first);
+            rdns.push_back(normalize ? NormalizeRdn(rdn) : rdn);
+        }
+        return rdns;
+    }
+
+    std::wstring DnTree::NormalizeRdn(const std::wstring& rdn)
+    {
+        // Plain "type=value" RDNs, the vast majority, only need case folding
+        size_t equals = rdn.find(L'=');
+        bool plain = equals != std::wstring::npos && equals > 0 && equals + 1 < rdn.size() &&
+            rdn.front() != L' ' && rdn.back() != L' ' && rdn[equals - 1] != L' ' &&
+            rdn[equals + 1] != L' ' && rdn[equals + 1] != L'#';
+        for (size_t i = 0; plain && i < rdn.size(); ++i)
+        {
+            wchar_t c = rdn[i];
+            plain = c != L'\\' && c != L'"' && c != L'+' && c != L'<' && c != L'>' && c != L'\0' &&
+                (c != L'=' || i == equals);
+        }
+        if (plain)
+        {
+            std::wstring folded(rdn.size(), L'\0');
+            for (size_t i = 0; i < rdn.size(); ++i)
+                folded[i] = FoldCase(rdn[i]);
+            return folded;
+        }
+
+        std::vector<std::wstring> values;
+        for (const auto& ava : SplitUnescaped(rdn, L"+"))
+        {
+            std::vector<std::wstring> sides = SplitUnescaped(ava, L"=");
+            std::wstring type = Trim(sides[0]);
+            std::transform(type.begin(), type.end(), type.begin(), FoldCase);
+
+            // Everything after the first '=' is the value, even further '='
+            std::wstring value = sides.size() > 1 ? Trim(ava.substr(ava.find(L'=') + 1)) : L"";
+            values.push_back(type + L"=" + NormalizeValue(value));
+        }
+        std::sort(values.begin(), values.end());
+
+        std::wstring normalized;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (i > 0) normalized += L'+';
+            normalized += values[i];
+        }
+        return normalized;
+    }
+
+    std::wstring DnTree::ChildKey(unsigned int parent, const std::wstring& normalizedRdn)
+    {
+        // Parent number in two fixed code units ahead of the RDN keeps keys unambiguous
+        std::wstring key;
+        key.reserve(normalizedRdn.size() + 2);
+        key += static_cast<wchar_t>(parent & 0xFFFF);
+        key += static_cast<wchar_t>(parent >> 16);
+        key += normalizedRdn;
+        return key;
+    }
+
+    void DnTree::Insert(const std::wstring& dn, size_t entryIndex)
+    {
+        std::vector<std::pair<size_t, size_t>> spans;
+        RdnSpans(dn, spans);
+
+        unsigned int node = 0;
+        std::wstring label;
+        for (auto span = spans.rbegin(); span != spans.rend(); ++span)
+        {
+            label.assign(dn, span->first, span->second - span->first);
+            std::wstring key = ChildKey(node, NormalizeRdn(label));
+            auto it = links.find(key);
+            if (it != links.end())
+            {
+                node = it->second;
+                continue;
+            }
+
+            unsigned int child = static_cast<unsigned int>(nodes.size());
+            links.emplace(std::move(key), child);
+            nodes.emplace_back();
+            Node& created = nodes.back();
+            created.label = label;
+            created.parent = node;
+            created.nextSibling = nodes[node].firstChild;
+            nodes[node].firstChild = child;
+            node = child;
+        }
+
+        bool added = nodes[node].entry == npos;
+        nodes[node].entry = entryIndex;
+        if (!added)
+            return;
+        for (unsigned int n = node;; n = nodes[n].parent)
+        {
+            ++nodes[n].subtreeEntries;
+            if (n == 0) break;
+        }
+    }
+
+    void DnTree::Clear()
+    {
+        nodes.clear();
+        nodes.emplace_back();
+        links.clear();
+    }
+
+    size_t DnTree::FindNode(const std::wstring& dn) const
+    {
+        unsigned int node = 0;
+        for (const auto& rdn : Split(dn, true))
+        {
+            auto it = links.find(ChildKey(node, rdn));
+            if (it == links.end())
+                return npos;
+            node = it->second;
+        }
+        return node;
+    }
+
+    bool DnTree::Contains(const std::wstring& dn) const
+    {
+        size_t node = FindNode(dn);
+        return node != npos && nodes[node].entry != npos;
+    }
+
+    void DnTree::Collect(unsigned int node, std::vector<size_t>& out) const
+    {
+        std::vector<unsigned int> pending = { node };
+        while (!pending.empty())
+        {
+            const Node& current = nodes[pending.back()];
+            pending.pop_back();
+            if (current.entry != npos)
+                out.push_back(current.entry);
+            for (unsigned int child = current.firstChild; child != 0; child = nodes[child].nextSibling)
+            {
+                if (nodes[child].subtreeEntries > 0)
+                    pending.push_back(child);
+            }
+        }
+    }
+
+    std::vector<size_t> DnTree::Select(const std::wstring& baseDN, unsigned long scope) const
+    {
+        std::vector<size_t> selected;
+        size_t node = (baseDN.empty() && scope != 0) ? 0 : FindNode(baseDN);
+        if (node == npos)
+            return selected;
+
+        if (scope == 0)
+        {
+            if (nodes[node].entry != npos)
+                selected.push_back(nodes[node].entry);
+        }
+        else if (scope == 1 && !baseDN.empty())
+        {
+            for (unsigned int child = nodes[node].firstChild; child != 0; child = nodes[child].nextSibling)
+            {
+                if (nodes[child].entry != npos)
+                    selected.push_back(nodes[child].entry);
+            }
+        }
+        else
+        {
+            selected.reserve(nodes[node].subtreeEntries);
+            Collect(static_cast<unsigned int>(node), selected);
+        }
+
+        // Large selections are usually most of the entries: a presence map orders
+        // them in linear time
+        size_t highest = selected.empty() ? 0 : *std::max_element(selected.begin(), selected.end());
+        if (selected.size() > 4096 && highest < 4 * selected.size())
+        {
+            std::vector<char> present(highest + 1, 0);
+            for (auto entry : selected)
+                present[entry] = 1;
+            selected.clear();
+            for (size_t entry = 0; entry <= highest; ++entry)
+            {
+                if (present[entry]) selected.push_back(entry);
+            }
+        }
+        else
+        {
+            std::sort(selected.begin(), selected.end());
+        }
+        return selected;
+    }
+
+    std::wstring DnTree::DnOf(unsigned int node) const
+    {
+        std::wstring dn;
+        for (unsigned int n = node; n != 0; n = nodes[n].parent)
+        {
+            if (!dn.empty()) dn += L',';
+            dn += nodes[n].label;
+        }
+        return dn;
+    }
+
+    std::vector<DnTree::ContainerCount> DnTree::Counts(const std::wstring& baseDN) const
+    {
+        std::vector<ContainerCount> counts;
+        size_t base = FindNode(baseDN);
+        if (base == npos)
+            return counts;
+
+        // Depth first with children in name order; the root itself is not a container
+        std::vector<std::pair<unsigned int, size_t>> pending;
+        if (base == 0)
+        {
+            for (unsigned int child = nodes[0].firstChild; child != 0; child = nodes[child].nextSibling)
+                pending.emplace_back(child, 0);
+        }
+        else
+        {
+            pending.emplace_back(static_cast<unsigned int>(base), 0);
+        }
+        auto byLabel = [&](const std::pair<unsigned int, size_t>& a, const std::pair<unsigned int, size_t>& b)
+        {
+            return _wcsicmp(nodes[a.first].label.c_str(), nodes[b.first].label.c_str()) > 0;
+        };
+        std::sort(pending.begin(), pending.end(), byLabel);
+
+        while (!pending.empty())
+        {
+            unsigned int node = pending.back().first;
+            size_t depth = pending.back().second;
+            pending.pop_back();
+
+            const Node& current = nodes[node];
+            size_t below = current.subtreeEntries - (current.entry != npos ? 1 : 0);
+            if (below == 0)
+                continue;
+
+            ContainerCount count;
+            count.dn = DnOf(node);
+            count.depth = depth;
+            count.subtree = below;
+            size_t firstChild = pending.size();
+            for (unsigned int child = current.firstChild; child != 0; child = nodes[child].nextSibling)
+            {
+                if (nodes[child].entry != npos)
+                    ++count.children;
+                pending.emplace_back(child, depth + 1);
+            }
+            std::sort(pending.begin() + firstChild, pending.end(), byLabel);
+            counts.push_back(std::move(count));
+        }
+        return counts;
+    }
+
+    void DnTree::PrintCounts(const std::vector<ContainerCount>& counts)
+    {
+        std::wcout << L"\n🗂️  Objects per container:" << std::endl;
+        for (const auto& count : counts)
+        {
+            // Nested containers show only their own RDN under the parent
+            std::wstring name = count.depth == 0 ? count.dn : Split(count.dn, false).back();
+            std::wcout << L"  " << std::wstring(2 * count.depth, L' ') << std::setw(40 - static_cast<int>(std::min<size_t>(2 * count.depth, 30)))
+                << std::left << name << L" " << std::setw(8) << std::right << count.subtree << L" (" << count.children
+                << L" direct)" << std::endl;
+        }
+        if (counts.empty())
+            std::wcout << L"  (no entries below the base)" << std::endl;
+    }
+}
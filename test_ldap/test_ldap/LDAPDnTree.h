@@ -0,0 +1,66 @@
+#pragma once
+#include "LDAPTypes.h"
+#include <unordered_map>
+
+namespace LDAPUtils
+{
+    // Directory hierarchy over a set of entries: one node per RDN, keyed by the
+    // normalized RDN (case-folded, spaces around separators dropped, escapes made
+    // canonical, multi-valued RDNs sorted). Containers that were not themselves
+    // returned still get a node so their descendants hang off the right place.
+    class DnTree
+    {
+    public:
+        static const size_t npos = static_cast<size_t>(-1);
+
+        struct ContainerCount
+        {
+            std::wstring dn;
+            size_t depth = 0;       // Below the base the counts were taken for
+            size_t children = 0;    // Entries directly below
+            size_t subtree = 0;     // Entries anywhere below, the container itself excluded
+        };
+
+    private:
+        struct Node
+        {
+            std::wstring label;     // RDN as first seen, for display
+            unsigned int parent = 0;
+            unsigned int firstChild = 0;    // 0 = none; the root is never a child
+            unsigned int nextSibling = 0;
+            size_t entry = npos;
+            size_t subtreeEntries = 0;
+        };
+
+        std::vector<Node> nodes;    // nodes[0] is the root above every naming context
+        std::unordered_map<std::wstring, unsigned int> links;  // ChildKey(parent, rdn) -> node
+
+        static std::wstring ChildKey(unsigned int parent, const std::wstring& normalizedRdn);
+        size_t FindNode(const std::wstring& dn) const;
+        void Collect(unsigned int node, std::vector<size_t>& out) const;
+        std::wstring DnOf(unsigned int node) const;
+
+    public:
+        DnTree();
+
+        // Splits a DN into RDNs, root first; normalized or as written
+        static std::vector<std::wstring> Split(const std::wstring& dn, bool normalize);
+        static std::wstring NormalizeRdn(const std::wstring& rdn);
+
+        // Adds (or re-points) dn at entry number entryIndex; cost grows with DN depth only
+        void Insert(const std::wstring& dn, size_t entryIndex);
+        void Clear();
+
+        size_t NodeCount() const { return nodes.size() - 1; }
+        size_t EntryCount() const { return nodes[0].subtreeEntries; }
+        bool Contains(const std::wstring& dn) const;
+
+        // Entry numbers (ascending) for 0 = base, 1 = one level, 2 = subtree.
+        // An empty base matches everything, as Filter::InScope does.
+        std::vector<size_t> Select(const std::wstring& baseDN, unsigned long scope) const;
+
+        // Every container below (and including) baseDN that has entries under it, depth first
+        std::vector<ContainerCount> Counts(const std::wstring& baseDN) const;
+        static void PrintCounts(const std::vector<ContainerCount>& counts);
+    };
+}
\ No newline at end of file
@@ -1,13 +1,649 @@
 ﻿#define _CRT_SECURE_NO_WARNINGS
 #include "LDAPExporter.h"
+#include "LDAPDnTree.h"
+#include "LDAPCompress.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <unordered_map>
+#include <limits>
 
 namespace LDAPUtils
 {
+    namespace
+    {
+        const char* const kEntryTypes[] = { "unknown", "user", "group", "computer" };
+
+        // Index into kEntryTypes, used by the HTML type filter buttons
+        int EntryTypeCode(const Entry& e)
+        {
+            auto ocIt = e.attrs.find(L"objectClass");
+            if (ocIt != e.attrs.end())
+            {
+                for (const auto& oc : ocIt->second)
+                {
+                    std::wstring ocLower = Converters::ToLower(oc);
+                    if (ocLower == L"user" || ocLower == L"person")
+                        return 1;
+                    else if (ocLower == L"group")
+                        return 2;
+                    else if (ocLower == L"computer")
+                        return 3;
+                }
+            }
+            return 0;
+        }
+
+        typedef std::unordered_map<uint32_t, std::vector<uint32_t>> TrigramPostings;
+
+        // Printable ASCII lower-cased the way String.toLowerCase() does it; anything
+        // else (control characters, UTF-8 sequences) is left out of the search index
+        int IndexChar(unsigned char c)
+        {
+            if (c >= 'A' && c <= 'Z')
+                return c + ('a' - 'A');
+            return c >= 0x20 && c < 0x7F ? c : -1;
+        }
+
+        void AddTrigrams(TrigramPostings& postings, const std::string& value, uint32_t row)
+        {
+            for (size_t k = 0; k + 3 <= value.size(); ++k)
+            {
+                int a = IndexChar(value[k]), b = IndexChar(value[k + 1]), c = IndexChar(value[k + 2]);
+                if (a < 0 || b < 0 || c < 0)
+                    continue;
+                auto& rows = postings[(a << 14) | (b << 7) | c];
+                if (rows.empty() || rows.back() != row)
+                    rows.push_back(row);
+            }
+        }
+
+        // Row deltas as base64url digits, 5 bits each with the low group first; 32 is
+        // set on a delta's last digit
+        std::string EncodeRows(const std::vector<uint32_t>& rows)
+        {
+            static const char kDigits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+            std::string encoded;
+            uint32_t previous = 0;
+            for (uint32_t row : rows)
+            {
+                uint32_t delta = row - previous;
+                previous = row;
+                for (; delta >= 32; delta >>= 5)
+                    encoded += kDigits[delta & 31];
+                encoded += kDigits[32 | delta];
+            }
+            return encoded;
+        }
+
+        // Numeric and timestamp columns carry sort keys so the report's worker can
+        // order them without string comparisons: the number itself, or milliseconds
+        // since 1601 for timestamps ("0" being an unset timestamp)
+        bool ParseNumber(const std::string& value, double& number)
+        {
+            size_t digits = 0, dots = 0;
+            for (size_t p = (!value.empty() && value[0] == '-') ? 1 : 0; p < value.size(); ++p)
+            {
+                if (value[p] == '.' && dots++ == 0 && digits > 0 && p + 1 < value.size())
+                    continue;
+                if (value[p] < '0' || value[p] > '9')
+                    return false;
+                ++digits;
+            }
+            if (digits == 0)
+                return false;
+            number = strtod(value.c_str(), nullptr);
+            return true;
+        }
+
+        // False when some non-empty value is neither; empty values get -infinity
+        bool ColumnKeys(const std::vector<const std::string*>& values, std::vector<double>& keys)
+        {
+            bool numbers = true, timestamps = true, anyValue = false;
+            std::vector<double> ticks(values.size());
+            keys.assign(values.size(), -std::numeric_limits<double>::infinity());
+            for (size_t k = 0; k < values.size() && (numbers || timestamps); ++k)
+            {
+                const std::string& value = *values[k];
+                if (value.empty())
+                    continue;
+                anyValue = true;
+                numbers = numbers && ParseNumber(value, keys[k]);
+                if (timestamps && value != "0")
+                {
+                    unsigned long long parsed = value.find_first_not_of("0123456789") == std::string::npos ? 0 :
+                        Converters::ParseTimestampTicks(Converters::StringToWString(value));
+                    ticks[k] = static_cast<double>(parsed / 10000);
+                    timestamps = parsed != 0;
+                }
+            }
+            if (!anyValue || (!numbers && !timestamps))
+                return false;
+            if (!numbers)
+            {
+                for (size_t k = 0; k < values.size(); ++k)
+                    keys[k] = values[k]->empty() ? keys[k] : ticks[k];
+            }
+            return true;
+        }
+
+        std::string SortKeys(const std::vector<const std::string*>& values)
+        {
+            std::vector<double> keys;
+            if (!ColumnKeys(values, keys))
+                return "null";
+
+            std::ostringstream out;
+            out << std::setprecision(17) << "[";
+            for (size_t k = 0; k < values.size(); ++k)
+            {
+                out << (k > 0 ? "," : "");
+                if (values[k]->empty())
+                    out << "null";
+                else
+                    out << keys[k];
+            }
+            out << "]";
+            return out.str();
+        }
+
+        // Stored value for machine formats, its description for people
+        std::wstring Rendered(const std::wstring& attr, const Value& value, bool raw)
+        {
+            return raw ? value.str() : Converters::DisplayValue(attr, value);
+        }
+
+        std::wstring JoinedValues(const Entry& e, const std::wstring& attr, bool raw)
+        {
+            std::wstring joined;
+            auto it = e.attrs.find(attr);
+            if (it != e.attrs.end())
+            {
+                for (size_t k = 0; k < it->second.size(); ++k)
+                {
+                    if (k > 0) joined += L" | ";
+                    joined += Rendered(attr, it->second[k], raw);
+                }
+            }
+            return joined;
+        }
+
+        // Interned handle standing for a cell's text when it has at most one value
+        // (a missing attribute and an empty value are both the empty handle)
+        bool CellHandle(const Entry& e, const std::wstring& attr, const void*& handle)
+        {
+            auto it = e.attrs.find(attr);
+            if (it == e.attrs.end() || it->second.empty())
+            {
+                handle = nullptr;
+                return true;
+            }
+            if (it->second.size() > 1)
+                return false;
+            handle = it->second[0].Handle();
+            return true;
+        }
+
+        // Virtual rows: a worker started from the first script owns the embedded data
+        // and does search, filter, sort and export; the page keeps only the rows in
+        // view (plus a small overscan) in the DOM and asks the worker for them
+        void WriteVirtualRowsScript(std::ostream& file)
+        {
+            file << "    <script type=\"text/plain\" id=\"ldapWorker\">\n"
+                << "        // Owns the dataset: search, type filter, sort and export run here and the\n"
+                << "        // page only asks for the rows it is about to draw\n"
+                << "        const DIGITS = 'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_';\n"
+                << "        const DIGIT_VALUES = new Uint8Array(128);\n"
+                << "        for (let k = 0; k < DIGITS.length; k++) DIGIT_VALUES[DIGITS.charCodeAt(k)] = k;\n"
+                << "        const typeNames = ['unknown', 'user', 'group', 'computer'];\n"
+                << "        let data = null;\n"
+                << "        let headers = null;\n"
+                << "        let columns = null;\n"
+                << "        let trigrams = null;\n"
+                << "        let view = null;\n"
+                << "        let firstRow = 0;\n"
+                << "        function cellValue(row, column) {\n"
+                << "            const c = columns[column];\n"
+                << "            return c.dict ? c.dict[c.index[row]] : c.values[row];\n"
+                << "        }\n"
+                << "        function lowered(c) {\n"
+                << "            if (!c.lower) c.lower = (c.dict || c.values).map(v => v.toLowerCase());\n"
+                << "            return c.lower;\n"
+                << "        }\n"
+                << "        function decodeRows(encoded) {\n"
+                << "            const rows = [];\n"
+                << "            let row = 0, delta = 0, shift = 0;\n"
+                << "            for (let k = 0; k < encoded.length; k++) {\n"
+                << "                const digit = DIGIT_VALUES[encoded.charCodeAt(k)];\n"
+                << "                delta += (digit & 31) << shift;\n"
+                << "                if (digit & 32) {\n"
+                << "                    row += delta;\n"
+                << "                    rows.push(row);\n"
+                << "                    delta = 0;\n"
+                << "                    shift = 0;\n"
+                << "                } else {\n"
+                << "                    shift += 5;\n"
+                << "                }\n"
+                << "            }\n"
+                << "            return rows;\n"
+                << "        }\n"
+                << "        function indexCandidates(query) {\n"
+                << "            const lists = [];\n"
+                << "            for (let k = 0; k + 3 <= query.length; k++) {\n"
+                << "                const gram = query.substr(k, 3);\n"
+                << "                if (!/^[\\x20-\\x7e]{3}$/.test(gram)) continue;\n"
+                << "                const list = trigrams.get(gram) || '';\n"
+                << "                if (list !== '*') lists.push(list);\n"
+                << "            }\n"
+                << "            if (lists.length === 0) return null;\n"
+                << "            lists.sort((a, b) => a.length - b.length);\n"
+                << "            let rows = decodeRows(lists[0]);\n"
+                << "            for (let k = 1; k < lists.length && rows.length > 0; k++) {\n"
+                << "                if (lists[k].length > rows.length * 16) break;\n"
+                << "                const other = decodeRows(lists[k]);\n"
+                << "                const both = [];\n"
+                << "                for (let i = 0, j = 0; i < rows.length && j < other.length;) {\n"
+                << "                    if (rows[i] < other[j]) i++;\n"
+                << "                    else if (rows[i] > other[j]) j++;\n"
+                << "                    else { both.push(rows[i]); i++; j++; }\n"
+                << "                }\n"
+                << "                rows = both;\n"
+                << "            }\n"
+                << "            return rows;\n"
+                << "        }\n"
+                << "        function searchHits(query) {\n"
+                << "            const hit = new Uint8Array(data.rows);\n"
+                << "            const candidates = indexCandidates(query);\n"
+                << "            columns.forEach(c => {\n"
+                << "                if (c.dict) {\n"
+                << "                    const dictHit = lowered(c).map(v => v.includes(query));\n"
+                << "                    for (let row = 0; row < data.rows; row++) if (dictHit[c.index[row]]) hit[row] = 1;\n"
+                << "                } else if (candidates) {\n"
+                << "                    for (const row of candidates) if (!hit[row] && c.values[row].toLowerCase().includes(query)) hit[row] = 1;\n"
+                << "                } else {\n"
+                << "                    const lower = lowered(c);\n"
+                << "                    for (let row = 0; row < data.rows; row++) if (!hit[row] && lower[row].includes(query)) hit[row] = 1;\n"
+                << "                }\n"
+                << "            });\n"
+                << "            return hit;\n"
+                << "        }\n"
+                << "        // Per-row sort rank of a column, equal values sharing a rank. Numeric and\n"
+                << "        // timestamp columns order by the exporter's keys, the rest by a collator\n"
+                << "        function ranks(column) {\n"
+                << "            const c = columns[column];\n"
+                << "            if (c.rank) return c.rank;\n"
+                << "            const values = c.dict || c.values;\n"
+                << "            const order = new Uint32Array(values.length);\n"
+                << "            for (let k = 0; k < order.length; k++) order[k] = k;\n"
+                << "            let compare;\n"
+                << "            if (c.keys) {\n"
+                << "                const keys = c.keys;\n"
+                << "                compare = (a, b) => keys[a] < keys[b] ? -1 : keys[a] > keys[b] ? 1 : 0;\n"
+                << "            } else {\n"
+                << "                const collator = new Intl.Collator(undefined, { numeric: true, sensitivity: 'base' });\n"
+                << "                compare = (a, b) => collator.compare(values[a], values[b]);\n"
+                << "            }\n"
+                << "            order.sort((a, b) => compare(a, b) || a - b);\n"
+                << "            const rank = new Uint32Array(values.length);\n"
+                << "            for (let k = 1; k < order.length; k++) rank[order[k]] = rank[order[k - 1]] + (compare(order[k - 1], order[k]) !== 0 ? 1 : 0);\n"
+                << "            if (c.dict) {\n"
+                << "                c.rank = new Uint32Array(data.rows);\n"
+                << "                for (let row = 0; row < data.rows; row++) c.rank[row] = rank[c.index[row]];\n"
+                << "            } else {\n"
+                << "                c.rank = rank;\n"
+                << "            }\n"
+                << "            return c.rank;\n"
+                << "        }\n"
+                << "        function query(search, filter, sort) {\n"
+                << "            const hit = search === '' ? null : searchHits(search);\n"
+                << "            const type = typeNames.indexOf(filter);\n"
+                << "            const rows = new Uint32Array(data.rows);\n"
+                << "            let count = 0;\n"
+                << "            for (let row = 0; row < data.rows; row++) {\n"
+                << "                if (type >= 0 && data.types.charCodeAt(row) - 48 !== type) continue;\n"
+                << "                if (hit && !hit[row]) continue;\n"
+                << "                rows[count++] = row;\n"
+                << "            }\n"
+                << "            view = rows.slice(0, count);\n"
+                << "            if (sort.column !== null) {\n"
+                << "                const rank = ranks(sort.column - 1);\n"
+                << "                const sign = sort.direction === 'asc' ? 1 : -1;\n"
+                << "                view.sort((a, b) => (rank[a] - rank[b]) * sign || a - b);\n"
+                << "            }\n"
+                << "        }\n"
+                << "        function rowValues(row) {\n"
+                << "            return [String(firstRow + row + 1)].concat(columns.map((c, k) => cellValue(row, k)));\n"
+                << "        }\n"
+                << "        function exportRows(format, rows) {\n"
+                << "            if (format === 'csv') {\n"
+                << "                const quote = v => '\"' + v.replace(/\"/g, '\"\"') + '\"';\n"
+                << "                const lines = [headers.map(quote).join(',')];\n"
+                << "                rows.forEach(row => lines.push(rowValues(row).map(quote).join(',')));\n"
+                << "                return new Blob(['\\uFEFF' + lines.join('\\n') + '\\n'], { type: 'text/csv;charset=utf-8;' });\n"
+                << "            }\n"
+                << "            if (format === 'json') {\n"
+                << "                const entries = Array.from(rows, row => {\n"
+                << "                    const obj = {};\n"
+                << "                    rowValues(row).forEach((v, i) => obj[headers[i]] = v);\n"
+                << "                    return obj;\n"
+                << "                });\n"
+                << "                return new Blob([JSON.stringify({ entries: entries }, null, 2)], { type: 'application/json' });\n"
+                << "            }\n"
+                << "            let text = headers.join('\\t') + '\\n';\n"
+                << "            rows.forEach(row => text += rowValues(row).join('\\t') + '\\n');\n"
+                << "            return text;\n"
+                << "        }\n"
+                << "        self.onmessage = function(e) {\n"
+                << "            const message = e.data;\n"
+                << "            if (message.type === 'init') {\n"
+                << "                data = message.data || JSON.parse(message.json);\n"
+                << "                firstRow = message.first || 0;\n"
+                << "                headers = ['#'].concat(data.columns);\n"
+                << "                columns = data.cols.map((c, k) => {\n"
+                << "                    const column = c.d ? { dict: c.d, index: Uint32Array.from(c.i) } : { values: c.v };\n"
+                << "                    const keys = data.keys[k];\n"
+                << "                    if (keys) column.keys = Float64Array.from(keys, v => v === null ? -Infinity : v);\n"
+                << "                    return column;\n"
+                << "                });\n"
+                << "                trigrams = new Map();\n"
+                << "                for (let k = 0; k < data.index.rows.length; k++) trigrams.set(data.index.grams.substr(k * 3, 3), data.index.rows[k]);\n"
+                << "                self.postMessage({ type: 'ready', rows: data.rows });\n"
+                << "            } else if (message.type === 'query') {\n"
+                << "                query(message.search, message.filter, message.sort);\n"
+                << "                self.postMessage({ type: 'view', id: message.id, length: view.length });\n"
+                << "            } else if (message.type === 'rows') {\n"
+                << "                const cells = [];\n"
+                << "                for (let k = message.start; k < message.end && k < view.length; k++) cells.push([view[k]].concat(columns.map((c, i) => cellValue(view[k], i))));\n"
+                << "                self.postMessage({ type: 'rows', id: message.id, cells: cells });\n"
+                << "            } else if (message.type === 'selectAll') {\n"
+                << "                self.postMessage({ type: 'selectAll', rows: view.slice() });\n"
+                << "            } else if (message.type === 'export') {\n"
+                << "                const rows = message.rows ? Uint32Array.from(message.rows).sort() : view;\n"
+                << "                self.postMessage({ type: 'export', format: message.format, result: exportRows(message.format, rows) });\n"
+                << "            }\n"
+                << "        };\n"
+                << "    </script>\n"
+                << "    <script>\n"
+                << "        const searchInput = document.getElementById('searchInput');\n"
+                << "        const table = document.getElementById('dataTable');\n"
+                << "        const tbody = table.querySelector('tbody');\n"
+                << "        const wrapper = document.querySelector('.table-wrapper');\n"
+                << "        const noResults = document.getElementById('noResults');\n"
+                << "        const visibleCount = document.getElementById('visibleCount');\n"
+                << "        const selectedCount = document.getElementById('selectedCount');\n"
+                << "        const filterButtons = document.querySelectorAll('.filter-btn');\n"
+                << "        const columnCount = table.querySelectorAll('thead th').length;\n"
+                << "        const workerSource = document.getElementById('ldapWorker').textContent;\n"
+                << "        const shardManifest = document.getElementById('ldapShards');\n"
+                << "        const shards = shardManifest ? JSON.parse(shardManifest.textContent) : null;\n"
+                << "        const shardItems = document.querySelectorAll('.shard-list li');\n"
+                << "        const ROW_HEIGHT = 40;\n"
+                << "        const MAX_HEIGHT = 10000000;\n"
+                << "        const OVERSCAN = 8;\n"
+                << "        let worker = null;\n"
+                << "        let ready = false;\n"
+                << "        let viewLength = 0;\n"
+                << "        let currentFilter = 'all';\n"
+                << "        let currentSearch = '';\n"
+                << "        let currentSort = { column: null, direction: 'asc' };\n"
+                << "        let selectedRows = new Set();\n"
+                << "        let queryId = 0;\n"
+                << "        let renderId = 0;\n"
+                << "        let pendingRender = null;\n"
+                << "        let renderPending = false;\n"
+                << "        let searchTimer = null;\n"
+                << "        let currentShard = -1;\n"
+                << "        let firstRow = 0;\n"
+                << "        // Pages opened from disk may not be allowed to start a worker; the same code\n"
+                << "        // then runs on this thread behind a message-passing shim\n"
+                << "        function inlineWorker() {\n"
+                << "            const page = { onmessage: null, postMessage(message) { setTimeout(() => scope.onmessage({ data: message })); } };\n"
+                << "            const scope = { onmessage: null, postMessage(message) { setTimeout(() => page.onmessage({ data: message })); } };\n"
+                << "            new Function('self', workerSource)(scope);\n"
+                << "            return page;\n"
+                << "        }\n"
+                << "        function startWorker() {\n"
+                << "            try {\n"
+                << "                worker = new Worker(URL.createObjectURL(new Blob([workerSource], { type: 'text/javascript' })));\n"
+                << "                worker.onerror = function() {\n"
+                << "                    if (!ready) startInline();\n"
+                << "                };\n"
+                << "            } catch (err) {\n"
+                << "                worker = inlineWorker();\n"
+                << "            }\n"
+                << "            worker.onmessage = onWorkerMessage;\n"
+                << "            initWorker();\n"
+                << "        }\n"
+                << "        function startInline() {\n"
+                << "            worker = inlineWorker();\n"
+                << "            worker.onmessage = onWorkerMessage;\n"
+                << "            initWorker();\n"
+                << "        }\n"
+                << "        function initWorker() {\n"
+                << "            if (shards) {\n"
+                << "                loadShard(Math.max(0, currentShard));\n"
+                << "            } else {\n"
+                << "                worker.postMessage({ type: 'init', json: document.getElementById('ldapData').textContent });\n"
+                << "            }\n"
+                << "        }\n"
+                << "        // Shards are scripts next to this page calling ldapShard(n, data); script\n"
+                << "        // elements load from disk where fetch() is not allowed. Only the shard on\n"
+                << "        // screen is kept: the worker replaces its dataset and the page drops its copy\n"
+                << "        function loadShard(k) {\n"
+                << "            ready = false;\n"
+                << "            currentShard = k;\n"
+                << "            firstRow = shards.first[k];\n"
+                << "            selectedRows.clear();\n"
+                << "            selectedCount.textContent = '0';\n"
+                << "            shardItems.forEach(item => item.classList.toggle('active', Number(item.dataset.shard) === k));\n"
+                << "            const script = document.createElement('script');\n"
+                << "            script.src = shards.files[k];\n"
+                << "            script.onload = () => script.remove();\n"
+                << "            script.onerror = () => {\n"
+                << "                script.remove();\n"
+                << "                alert('Could not load ' + shards.files[k]);\n"
+                << "            };\n"
+                << "            document.head.appendChild(script);\n"
+                << "        }\n"
+                << "        window.ldapShard = function(k, data) {\n"
+                << "            if (k === currentShard) worker.postMessage({ type: 'init', data: data, first: shards.first[k] });\n"
+                << "        };\n"
+                << "        function escapeHtml(s) {\n"
+                << "            return s.replace(/[&<>\"]/g, ch => ({ '&': '&amp;', '<': '&lt;', '>': '&gt;', '\"': '&quot;' }[ch]));\n"
+                << "        }\n"
+                << "        function updateDisplay() {\n"
+                << "            if (!ready) return;\n"
+                << "            worker.postMessage({ type: 'query', id: ++queryId, search: currentSearch, filter: currentFilter, sort: currentSort });\n"
+                << "        }\n"
+                << "        function render() {\n"
+                << "            renderPending = false;\n"
+                << "            if (!ready) return;\n"
+                << "            const total = viewLength;\n"
+                << "            const viewport = wrapper.clientHeight;\n"
+                << "            const height = Math.min(total * ROW_HEIGHT, MAX_HEIGHT);\n"
+                << "            const scaled = total * ROW_HEIGHT > MAX_HEIGHT;\n"
+                << "            const maxScroll = Math.max(1, height - viewport);\n"
+                << "            const top = Math.min(wrapper.scrollTop, maxScroll);\n"
+                << "            const first = Math.min(total, Math.floor(top / maxScroll * Math.max(0, total - viewport / ROW_HEIGHT)));\n"
+                << "            const start = Math.max(0, first - OVERSCAN);\n"
+                << "            const end = Math.min(total, first + Math.ceil(viewport / ROW_HEIGHT) + OVERSCAN);\n"
+                << "            const topPad = Math.max(0, (scaled ? top : first * ROW_HEIGHT) - (first - start) * ROW_HEIGHT);\n"
+                << "            const bottomPad = Math.max(0, height - topPad - (end - start) * ROW_HEIGHT);\n"
+                << "            pendingRender = { id: ++renderId, topPad: topPad, bottomPad: bottomPad };\n"
+                << "            worker.postMessage({ type: 'rows', id: renderId, start: start, end: end });\n"
+                << "        }\n"
+                << "        function drawRows(cells) {\n"
+                << "            let html = '<tr class=\"spacer\"><td colspan=\"' + columnCount + '\" style=\"height:' + pendingRender.topPad + 'px\"></td></tr>';\n"
+                << "            cells.forEach(cell => {\n"
+                << "                const row = cell[0];\n"
+                << "                html += '<tr data-index=\"' + row + '\"' + (selectedRows.has(row) ? ' class=\"selected\"' : '') + '><td>' + (firstRow + row + 1) + '</td>';\n"
+                << "                for (let c = 1; c < cell.length; c++) {\n"
+                << "                    const text = escapeHtml(cell[c]);\n"
+                << "                    html += '<td' + (c === 1 ? ' class=\"dn-cell\"' : '') + ' title=\"' + text + '\">' + text + '</td>';\n"
+                << "                }\n"
+                << "                html += '</tr>';\n"
+                << "            });\n"
+                << "            html += '<tr class=\"spacer\"><td colspan=\"' + columnCount + '\" style=\"height:' + pendingRender.bottomPad + 'px\"></td></tr>';\n"
+                << "            tbody.innerHTML = html;\n"
+                << "        }\n"
+                << "        function download(blob, extension) {\n"
+                << "            const link = document.createElement('a');\n"
+                << "            link.href = URL.createObjectURL(blob);\n"
+                << "            link.download = 'ldap_export_' + new Date().toISOString().split('T')[0] + '.' + extension;\n"
+                << "            link.click();\n"
+                << "        }\n"
+                << "        function onWorkerMessage(e) {\n"
+                << "            const message = e.data;\n"
+                << "            if (message.type === 'ready') {\n"
+                << "                ready = true;\n"
+                << "                console.log('Total entries:', message.rows);\n"
+                << "                updateDisplay();\n"
+                << "            } else if (message.type === 'view' && message.id === queryId) {\n"
+                << "                viewLength = message.length;\n"
+                << "                visibleCount.textContent = viewLength;\n"
+                << "                table.style.display = viewLength === 0 ? 'none' : 'table';\n"
+                << "                noResults.style.display = viewLength === 0 ? 'block' : 'none';\n"
+                << "                wrapper.scrollTop = 0;\n"
+                << "                render();\n"
+                << "            } else if (message.type === 'rows' && message.id === renderId) {\n"
+                << "                drawRows(message.cells);\n"
+                << "            } else if (message.type === 'selectAll') {\n"
+                << "                message.rows.forEach(row => selectedRows.add(row));\n"
+                << "                selectedCount.textContent = selectedRows.size;\n"
+                << "                render();\n"
+                << "            } else if (message.type === 'export') {\n"
+                << "                if (message.format === 'text') {\n"
+                << "                    navigator.clipboard.writeText(message.result).then(() => {\n"
+                << "                        alert('Selected rows copied to clipboard!');\n"
+                << "                    }).catch(err => {\n"
+                << "                        console.error('Failed to copy:', err);\n"
+                << "                        alert('Failed to copy to clipboard');\n"
+                << "                    });\n"
+                << "                } else {\n"
+                << "                    download(message.result, message.format);\n"
+                << "                }\n"
+                << "            }\n"
+                << "        }\n"
+                << "        wrapper.addEventListener('scroll', function() {\n"
+                << "            if (!renderPending) {\n"
+                << "                renderPending = true;\n"
+                << "                requestAnimationFrame(render);\n"
+                << "            }\n"
+                << "        });\n"
+                << "        window.addEventListener('resize', render);\n"
+                << "        searchInput.addEventListener('input', function() {\n"
+                << "            const value = this.value.toLowerCase();\n"
+                << "            clearTimeout(searchTimer);\n"
+                << "            searchTimer = setTimeout(() => {\n"
+                << "                currentSearch = value;\n"
+                << "                updateDisplay();\n"
+                << "            }, 150);\n"
+                << "        });\n"
+                << "        filterButtons.forEach(btn => {\n"
+                << "            btn.addEventListener('click', function() {\n"
+                << "                filterButtons.forEach(b => b.classList.remove('active'));\n"
+                << "                this.classList.add('active');\n"
+                << "                currentFilter = this.dataset.filter;\n"
+                << "                updateDisplay();\n"
+                << "            });\n"
+                << "        });\n"
+                << "        shardItems.forEach(item => {\n"
+                << "            item.addEventListener('click', function() {\n"
+                << "                const k = Number(this.dataset.shard);\n"
+                << "                if (k !== currentShard) loadShard(k);\n"
+                << "            });\n"
+                << "        });\n"
+                << "        document.querySelectorAll('th.sortable').forEach(th => {\n"
+                << "            th.addEventListener('click', function() {\n"
+                << "                const column = parseInt(this.dataset.column) || 1;\n"
+                << "                if (currentSort.column === column) {\n"
+                << "                    currentSort.direction = currentSort.direction === 'asc' ? 'desc' : 'asc';\n"
+                << "                } else {\n"
+                << "                    currentSort.column = column;\n"
+                << "                    currentSort.direction = 'asc';\n"
+                << "                }\n"
+                << "                document.querySelectorAll('th.sortable').forEach(h => {\n"
+                << "                    h.classList.remove('sort-asc', 'sort-desc');\n"
+                << "                });\n"
+                << "                this.classList.add(currentSort.direction === 'asc' ? 'sort-asc' : 'sort-desc');\n"
+                << "                updateDisplay();\n"
+                << "            });\n"
+                << "        });\n"
+                << "        tbody.addEventListener('click', function(e) {\n"
+                << "            const row = e.target.closest('tr');\n"
+                << "            if (!row || row.classList.contains('spacer')) return;\n"
+                << "            if (e.ctrlKey || e.metaKey) {\n"
+                << "                const index = Number(row.dataset.index);\n"
+                << "                if (selectedRows.has(index)) {\n"
+                << "                    selectedRows.delete(index);\n"
+                << "                } else {\n"
+                << "                    selectedRows.add(index);\n"
+                << "                }\n"
+                << "                row.classList.toggle('selected');\n"
+                << "                selectedCount.textContent = selectedRows.size;\n"
+                << "            } else if (e.target.classList.contains('dn-cell')) {\n"
+                << "                const dn = e.target.getAttribute('title');\n"
+                << "                navigator.clipboard.writeText(dn).then(() => {\n"
+                << "                    const original = e.target.textContent;\n"
+                << "                    e.target.textContent = '✓ Copied!';\n"
+                << "                    e.target.style.color = '#48bb78';\n"
+                << "                    setTimeout(() => {\n"
+                << "                        e.target.textContent = original;\n"
+                << "                        e.target.style.color = '';\n"
+                << "                    }, 1500);\n"
+                << "                }).catch(err => {\n"
+                << "                    console.error('Failed to copy:', err);\n"
+                << "                    alert('Failed to copy to clipboard');\n"
+                << "                });\n"
+                << "            }\n"
+                << "        });\n"
+                << "        function exportToCSV() {\n"
+                << "            if (viewLength === 0) {\n"
+                << "                alert('No visible rows to export');\n"
+                << "                return;\n"
+                << "            }\n"
+                << "            worker.postMessage({ type: 'export', format: 'csv' });\n"
+                << "        }\n"
+                << "        function exportToJSON() {\n"
+                << "            if (viewLength === 0) {\n"
+                << "                alert('No visible rows to export');\n"
+                << "                return;\n"
+                << "            }\n"
+                << "            worker.postMessage({ type: 'export', format: 'json' });\n"
+                << "        }\n"
+                << "        function copySelected() {\n"
+                << "            if (selectedRows.size === 0) {\n"
+                << "                alert('No rows selected. Use Ctrl+Click to select rows.');\n"
+                << "                return;\n"
+                << "            }\n"
+                << "            worker.postMessage({ type: 'export', format: 'text', rows: Array.from(selectedRows) });\n"
+                << "        }\n"
+                << "        document.addEventListener('keydown', function(e) {\n"
+                << "            if ((e.ctrlKey || e.metaKey) && e.key === 'f') {\n"
+                << "                e.preventDefault();\n"
+                << "                searchInput.focus();\n"
+                << "                searchInput.select();\n"
+                << "            }\n"
+                << "            if ((e.ctrlKey || e.metaKey) && e.key === 'a' && document.activeElement === document.body) {\n"
+                << "                e.preventDefault();\n"
+                << "                if (ready) worker.postMessage({ type: 'selectAll' });\n"
+                << "            }\n"
+                << "            if (e.key === 'Escape') {\n"
+                << "                selectedRows.clear();\n"
+                << "                selectedCount.textContent = '0';\n"
+                << "                searchInput.value = '';\n"
+                << "                currentSearch = '';\n"
+                << "                updateDisplay();\n"
+                << "            }\n"
+                << "        });\n"
+                << "        startWorker();\n"
+                << "        console.log('LDAP Query Tool initialized (virtual rows, worker)');\n"
+                << "    </script>\n";
+        }
+    }
+
     std::string Exporter::EscapeCsvField(const std::string& input)
     {
         std::string output = "\"";
@@ -35,7 +671,7 @@ namespace LDAPUtils
             case '\b': output += "\\b"; break;
             case '\f': output += "\\f"; break;
             default:
-                if (c < 32) {
+                if (static_cast<unsigned char>(c) < 32) {
                     char buf[8];
                     sprintf(buf, "\\u%04x", (unsigned char)c);
                     output += buf;
@@ -66,24 +702,102 @@ namespace LDAPUtils
         return output;
     }
 
-    void Exporter::ExportCsv(const std::wstring& filename, const std::vector<std::wstring>& attributes,
-        const std::vector<Entry>& entries)
+    bool Exporter::Export(const SearchConfig& config, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, const Statistics& stats)
     {
-        std::ofstream file(filename, std::ios::binary);
-        if (!file.is_open())
+        switch (config.format)
         {
-            std::wcerr << L"Failed to create CSV file: " << filename << std::endl;
-            return;
+        case OutputFormat::CSV:
+            if (!ExportCsv(config.outputFile, attributes, entries,
+                config.valueStyle == ValueStyle::AUTO ? ValueStyle::DISPLAY : config.valueStyle))
+                return false;
+            if (config.columnarSidecar)
+            {
+                // Next to the CSV it describes, uncompressed so the viewer can map it
+                std::wstring sidecar = config.outputFile;
+                if (OutputFile::IsCompressed(sidecar))
+                    sidecar.resize(sidecar.size() - 3);
+                return ExportColumnar(sidecar + L".ldapcol", attributes, entries,
+                    config.valueStyle == ValueStyle::AUTO ? ValueStyle::DISPLAY : config.valueStyle);
+            }
+            break;
+        case OutputFormat::TXT:
+            return ExportTxt(config.outputFile, entries);
+        case OutputFormat::JSON:
+            return ExportJson(config.outputFile, entries,
+                config.valueStyle == ValueStyle::AUTO ? ValueStyle::RAW : config.valueStyle);
+        case OutputFormat::XML:
+            return ExportXml(config.outputFile, entries,
+                config.valueStyle == ValueStyle::AUTO ? ValueStyle::RAW : config.valueStyle);
+        case OutputFormat::HTML:
+            return ExportHtml(config.outputFile, attributes, entries, stats, config.htmlLayout,
+                config.htmlShardBy, config.htmlShardRows);
+        default:
+            break;
         }
+        return true;
+    }
 
-        file << "\xEF\xBB\xBF"; // UTF-8 BOM
+    std::vector<std::wstring> Exporter::AttributeNames(const std::vector<Entry>& entries)
+    {
+        std::set<std::wstring> names;
+        for (const auto& e : entries)
+        {
+            for (const auto& attr : e.attrs)
+                names.insert(attr.first);
+        }
+        return std::vector<std::wstring>(names.begin(), names.end());
+    }
+
+    std::wstring Exporter::FormatName(OutputFormat format)
+    {
+        switch (format)
+        {
+        case OutputFormat::CSV: return L"CSV";
+        case OutputFormat::TXT: return L"TXT";
+        case OutputFormat::JSON: return L"JSON";
+        case OutputFormat::XML: return L"XML";
+        case OutputFormat::HTML: return L"HTML (Interactive UI)";
+        default: return L"Console";
+        }
+    }
+
+    std::wstring Exporter::DefaultFileName(OutputFormat format)
+    {
+        switch (format)
+        {
+        case OutputFormat::CSV: return L"ldap_results.csv";
+        case OutputFormat::TXT: return L"ldap_results.txt";
+        case OutputFormat::JSON: return L"ldap_results.json";
+        case OutputFormat::XML: return L"ldap_results.xml";
+        case OutputFormat::HTML: return L"ldap_results.html";
+        default: return L"";
+        }
+    }
+
+    bool Exporter::ParseFormat(const std::wstring& name, OutputFormat& outFormat)
+    {
+        if (name == L"csv") outFormat = OutputFormat::CSV;
+        else if (name == L"txt") outFormat = OutputFormat::TXT;
+        else if (name == L"json") outFormat = OutputFormat::JSON;
+        else if (name == L"xml") outFormat = OutputFormat::XML;
+        else if (name == L"html") outFormat = OutputFormat::HTML;
+        else if (name == L"console") outFormat = OutputFormat::CONSOLE_ONLY;
+        else return false;
+        return true;
+    }
+
+    void Exporter::WriteCsv(std::ostream& out, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, ValueStyle style)
+    {
+        bool raw = style == ValueStyle::RAW;
 
         // Header
         std::string header = EscapeCsvField("DN");
         for (const auto& attr : attributes)
             header += "," + EscapeCsvField(Converters::WStringToUtf8(attr));
         header += "\n";
-        file << header;
+        out << header;
 
         // Data rows
         for (const auto& e : entries)
@@ -98,25 +812,200 @@ namespace LDAPUtils
                     for (size_t k = 0; k < it->second.size(); ++k)
                     {
                         if (k > 0) joined += L" | ";
-                        joined += it->second[k];
+                        joined += Rendered(attr, it->second[k], raw);
                     }
                 }
                 row += "," + EscapeCsvField(Converters::WStringToUtf8(joined));
             }
             row += "\n";
-            file << row;
+            out << row;
+        }
+    }
+
+    void Exporter::WriteNdjson(std::ostream& out, const std::vector<Entry>& entries, ValueStyle style)
+    {
+        bool raw = style != ValueStyle::DISPLAY;
+        for (const auto& e : entries)
+        {
+            out << "{\"dn\":\"" << EscapeJson(Converters::WStringToUtf8(e.dn)) << "\",\"attributes\":{";
+            size_t attrCount = 0;
+            for (const auto& attr : e.attrs)
+            {
+                if (attrCount++ > 0) out << ",";
+                out << "\"" << EscapeJson(Converters::WStringToUtf8(attr.first)) << "\":[";
+                for (size_t j = 0; j < attr.second.size(); ++j)
+                {
+                    if (j > 0) out << ",";
+                    out << "\"" << EscapeJson(Converters::WStringToUtf8(Rendered(attr.first, attr.second[j], raw))) << "\"";
+                }
+                out << "]";
+            }
+            out << "}}\n";
+        }
+    }
+
+    bool Exporter::ExportCsv(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, ValueStyle style)
+    {
+        OutputFile file(filename);
+        if (!file.is_open())
+        {
+            std::wcerr << L"Failed to create CSV file: " << filename << std::endl;
+            return false;
+        }
+
+        file << "\xEF\xBB\xBF"; // UTF-8 BOM
+        WriteCsv(file, attributes, entries, style);
+        if (!file.close())
+        {
+            std::wcerr << L"Failed to write CSV file: " << filename << std::endl;
+            return false;
         }
-        file.close();
         std::wcout << L"✓ CSV exported successfully" << std::endl;
+        return true;
     }
 
-    void Exporter::ExportTxt(const std::wstring& filename, const std::vector<Entry>& entries)
+    bool Exporter::ExportColumnar(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, ValueStyle style)
     {
+        bool raw = style == ValueStyle::RAW;
         std::ofstream file(filename, std::ios::binary);
         if (!file.is_open())
+        {
+            std::wcerr << L"Failed to create columnar file: " << filename << std::endl;
+            return false;
+        }
+
+        // Little-endian throughout; every array starts on a 4-byte boundary so the
+        // viewer can map it with a typed array straight over the ArrayBuffer
+        auto writeU32 = [&](uint32_t value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+        auto pad = [&]()
+        {
+            static const char zeros[4] = { 0 };
+            std::streamoff size = file.tellp();
+            if (size % 4)
+                file.write(zeros, 4 - size % 4);
+        };
+
+        const uint32_t rows = static_cast<uint32_t>(entries.size());
+        file.write(kColumnarMagic, 8);
+        writeU32(rows);
+        writeU32(static_cast<uint32_t>(attributes.size() + 1));
+
+        for (size_t column = 0; column <= attributes.size(); ++column)
+        {
+            std::string name = column == 0 ? "DN" : Converters::WStringToUtf8(attributes[column - 1]);
+            writeU32(static_cast<uint32_t>(name.size()));
+            file.write(name.data(), name.size());
+            pad();
+
+            // Dictionary in first-seen order; a column where every value is new
+            // (DN, GUIDs) is written without ids since id == row. Single-valued
+            // cells are found by interned handle, so each distinct value is
+            // converted and hashed as text once rather than once per row.
+            std::unordered_map<std::string, uint32_t> dictionary;
+            std::unordered_map<const void*, uint32_t> byHandle;
+            std::vector<const std::string*> distinct;
+            std::vector<uint32_t> ids(rows);
+            for (uint32_t row = 0; row < rows; ++row)
+            {
+                const Entry& e = entries[row];
+                const void* handle = nullptr;
+                bool single = column > 0 && CellHandle(e, attributes[column - 1], handle);
+                if (single)
+                {
+                    auto known = byHandle.find(handle);
+                    if (known != byHandle.end())
+                    {
+                        ids[row] = known->second;
+                        continue;
+                    }
+                }
+                auto inserted = dictionary.emplace(Converters::WStringToUtf8(column == 0 ? e.dn :
+                    JoinedValues(e, attributes[column - 1], raw)), static_cast<uint32_t>(distinct.size()));
+                if (inserted.second)
+                    distinct.push_back(&inserted.first->first);
+                ids[row] = inserted.first->second;
+                if (single)
+                    byHandle.emplace(handle, ids[row]);
+            }
+
+            // Distinct values in ascending order: numbers and timestamps by value,
+            // text by the user's locale ignoring case
+            std::vector<double> keys;
+            bool keyed = ColumnKeys(distinct, keys);
+            std::vector<std::wstring> wide;
+            if (!keyed)
+            {
+                wide.reserve(distinct.size());
+                for (const auto* value : distinct)
+                    wide.push_back(Converters::StringToWString(*value));
+            }
+            std::vector<uint32_t> byValue(distinct.size());
+            for (uint32_t k = 0; k < byValue.size(); ++k)
+                byValue[k] = k;
+            std::stable_sort(byValue.begin(), byValue.end(), [&](uint32_t a, uint32_t b)
+            {
+                if (keyed)
+                    return keys[a] < keys[b];
+                return CompareStringEx(LOCALE_NAME_USER_DEFAULT, NORM_IGNORECASE | SORT_DIGITSASNUMBERS,
+                    wide[a].c_str(), static_cast<int>(wide[a].size()), wide[b].c_str(), static_cast<int>(wide[b].size()),
+                    nullptr, nullptr, 0) == CSTR_LESS_THAN;
+            });
+
+            // Rows in that order, ties by row: a counting sort over the dictionary
+            std::vector<uint32_t> start(distinct.size() + 1, 0);
+            for (uint32_t id : ids)
+                ++start[id + 1];
+            std::vector<uint32_t> first(distinct.size());
+            uint32_t position = 0;
+            for (uint32_t id : byValue)
+            {
+                first[id] = position;
+                position += start[id + 1];
+            }
+            std::vector<uint32_t> order(rows);
+            for (uint32_t row = 0; row < rows; ++row)
+                order[first[ids[row]]++] = row;
+
+            uint32_t idWidth = distinct.size() == rows ? 0 : distinct.size() <= 0x100 ? 1 : distinct.size() <= 0x10000 ? 2 : 4;
+            uint32_t flags = (idWidth == 0 ? 0 : idWidth == 1 ? 1 : idWidth == 2 ? 2 : 3) | (keyed ? kColumnarNumeric : 0);
+            writeU32(flags);
+            writeU32(static_cast<uint32_t>(distinct.size()));
+
+            uint32_t offset = 0;
+            std::vector<uint32_t> offsets(1, 0);
+            for (const auto* value : distinct)
+                offsets.push_back(offset += static_cast<uint32_t>(value->size()));
+            writeU32(offset);
+            file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+            for (const auto* value : distinct)
+                file.write(value->data(), value->size());
+            pad();
+
+            for (uint32_t row = 0; row < rows && idWidth != 0; ++row)
+                file.write(reinterpret_cast<const char*>(&ids[row]), idWidth);     // Low bytes first
+            pad();
+            file.write(reinterpret_cast<const char*>(order.data()), order.size() * sizeof(uint32_t));
+        }
+
+        file.close();
+        if (!file)
+        {
+            std::wcerr << L"Failed to write columnar file: " << filename << std::endl;
+            return false;
+        }
+        std::wcout << L"✓ Columnar sidecar written: " << filename << std::endl;
+        return true;
+    }
+
+    bool Exporter::ExportTxt(const std::wstring& filename, const std::vector<Entry>& entries)
+    {
+        OutputFile file(filename);
+        if (!file.is_open())
         {
             std::wcerr << L"Failed to create TXT file: " << filename << std::endl;
-            return;
+            return false;
         }
 
         file << "\xEF\xBB\xBF";
@@ -137,23 +1026,29 @@ namespace LDAPUtils
                 for (size_t j = 0; j < attr.second.size(); ++j)
                 {
                     if (j > 0) file << "; ";
-                    file << Converters::WStringToUtf8(attr.second[j]);
+                    file << Converters::WStringToUtf8(Converters::DisplayValue(attr.first, attr.second[j]));
                 }
                 file << "\n";
             }
             file << "\n" << std::string(70, '=') << "\n\n";
         }
-        file.close();
+        if (!file.close())
+        {
+            std::wcerr << L"Failed to write TXT file: " << filename << std::endl;
+            return false;
+        }
         std::wcout << L"✓ TXT exported successfully" << std::endl;
+        return true;
     }
 
-    void Exporter::ExportJson(const std::wstring& filename, const std::vector<Entry>& entries)
+    bool Exporter::ExportJson(const std::wstring& filename, const std::vector<Entry>& entries, ValueStyle style)
     {
-        std::ofstream file(filename, std::ios::binary);
+        bool raw = style != ValueStyle::DISPLAY;
+        OutputFile file(filename);
         if (!file.is_open())
         {
             std::wcerr << L"Failed to create JSON file: " << filename << std::endl;
-            return;
+            return false;
         }
 
         file << "\xEF\xBB\xBF";
@@ -175,7 +1070,7 @@ namespace LDAPUtils
                 for (size_t j = 0; j < attr.second.size(); ++j)
                 {
                     if (j > 0) file << ", ";
-                    file << "\"" << EscapeJson(Converters::WStringToUtf8(attr.second[j])) << "\"";
+                    file << "\"" << EscapeJson(Converters::WStringToUtf8(Rendered(attr.first, attr.second[j], raw))) << "\"";
                 }
                 file << "]";
                 attrCount++;
@@ -186,17 +1081,23 @@ namespace LDAPUtils
         }
 
         file << "  ]\n}\n";
-        file.close();
+        if (!file.close())
+        {
+            std::wcerr << L"Failed to write JSON file: " << filename << std::endl;
+            return false;
+        }
         std::wcout << L"✓ JSON exported successfully" << std::endl;
+        return true;
     }
 
-    void Exporter::ExportXml(const std::wstring& filename, const std::vector<Entry>& entries)
+    bool Exporter::ExportXml(const std::wstring& filename, const std::vector<Entry>& entries, ValueStyle style)
     {
-        std::ofstream file(filename, std::ios::binary);
+        bool raw = style != ValueStyle::DISPLAY;
+        OutputFile file(filename);
         if (!file.is_open())
         {
             std::wcerr << L"Failed to create XML file: " << filename << std::endl;
-            return;
+            return false;
         }
 
         file << "\xEF\xBB\xBF";
@@ -214,7 +1115,7 @@ namespace LDAPUtils
                 for (const auto& val : attr.second)
                 {
                     file << "      <attribute name=\"" << EscapeXml(Converters::WStringToUtf8(attr.first)) << "\">"
-                        << EscapeXml(Converters::WStringToUtf8(val)) << "</attribute>\n";
+                        << EscapeXml(Converters::WStringToUtf8(Rendered(attr.first, val, raw))) << "</attribute>\n";
                 }
             }
 
@@ -223,18 +1124,258 @@ namespace LDAPUtils
         }
 
         file << "</ldap_results>\n";
-        file.close();
+        if (!file.close())
+        {
+            std::wcerr << L"Failed to write XML file: " << filename << std::endl;
+            return false;
+        }
         std::wcout << L"✓ XML exported successfully" << std::endl;
+        return true;
     }
 
-    void Exporter::ExportHtml(const std::wstring& filename, const std::vector<std::wstring>& attributes,
-        const std::vector<Entry>& entries, const Statistics& stats)
+    void Exporter::WriteHtmlData(std::ostream& out, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, const std::vector<size_t>& rows)
     {
-        std::ofstream file(filename, std::ios::binary);
+        // '<' is escaped as well so no value can close the script element
+        auto quoted = [](const std::string& value)
+        {
+            std::string escaped = EscapeJson(value);
+            std::string result = "\"";
+            for (char c : escaped)
+            {
+                if (c == '<') result += "\\u003c";
+                else result += c;
+            }
+            return result + "\"";
+        };
+
+        out << "{\"rows\":" << rows.size() << ",\"columns\":[\"DN\"";
+        for (const auto& attr : attributes)
+            out << "," << quoted(Converters::WStringToUtf8(attr));
+        out << "],\"types\":\"";
+        for (size_t row : rows)
+            out << static_cast<char>('0' + EntryTypeCode(entries[row]));
+        out << "\",\"cols\":[";
+
+        // Trigrams of the value columns; dictionary columns are few enough distinct
+        // values for the page to match them directly
+        TrigramPostings postings;
+        std::vector<std::string> keys;
+        std::vector<std::string> values(rows.size());
+        for (size_t column = 0; column <= attributes.size(); ++column)
+        {
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                const Entry& e = entries[rows[i]];
+                values[i] = Converters::WStringToUtf8(column == 0 ? e.dn : JoinedValues(e, attributes[column - 1], false));
+            }
+
+            // Columns that mostly repeat (objectClass, flags, empty cells) are written
+            // once per distinct value plus an index per row
+            std::unordered_map<std::string, unsigned int> dictionary;
+            std::vector<const std::string*> distinct;
+            std::vector<unsigned int> indexes(rows.size());
+            bool useDictionary = true;
+            for (size_t i = 0; i < rows.size() && useDictionary; ++i)
+            {
+                auto inserted = dictionary.emplace(values[i], static_cast<unsigned int>(distinct.size()));
+                if (inserted.second)
+                    distinct.push_back(&inserted.first->first);
+                indexes[i] = inserted.first->second;
+                useDictionary = distinct.size() <= rows.size() / 2 + 1;
+            }
+
+            out << (column > 0 ? "," : "");
+            if (useDictionary)
+            {
+                out << "{\"d\":[";
+                for (size_t k = 0; k < distinct.size(); ++k)
+                    out << (k > 0 ? "," : "") << quoted(*distinct[k]);
+                out << "],\"i\":[";
+                for (size_t i = 0; i < indexes.size(); ++i)
+                    out << (i > 0 ? "," : "") << indexes[i];
+                out << "]}";
+                keys.push_back(column == 0 ? "null" : SortKeys(distinct));
+            }
+            else
+            {
+                out << "{\"v\":[";
+                for (size_t i = 0; i < values.size(); ++i)
+                    out << (i > 0 ? "," : "") << quoted(values[i]);
+                out << "]}";
+                for (size_t i = 0; i < values.size(); ++i)
+                    AddTrigrams(postings, values[i], static_cast<uint32_t>(i));
+
+                std::vector<const std::string*> cells(values.size());
+                for (size_t i = 0; i < values.size(); ++i)
+                    cells[i] = &values[i];
+                keys.push_back(column == 0 ? "null" : SortKeys(cells));
+            }
+        }
+
+        // "index": {"grams": every trigram concatenated in order, "rows": the rows holding
+        // each one, or "*" for trigrams in most rows that would not narrow a search}
+        std::vector<uint32_t> grams;
+        grams.reserve(postings.size());
+        for (const auto& posting : postings)
+            grams.push_back(posting.first);
+        std::sort(grams.begin(), grams.end());
+        std::string gramText;
+        for (uint32_t gram : grams)
+        {
+            gramText += static_cast<char>(gram >> 14);
+            gramText += static_cast<char>((gram >> 7) & 0x7F);
+            gramText += static_cast<char>(gram & 0x7F);
+        }
+        // "keys": per column, null or one sort key per value ("v") or distinct value ("d")
+        out << "],\"keys\":[";
+        for (size_t k = 0; k < keys.size(); ++k)
+            out << (k > 0 ? "," : "") << keys[k];
+        out << "],\"index\":{\"grams\":" << quoted(gramText) << ",\"rows\":[";
+        for (size_t k = 0; k < grams.size(); ++k)
+        {
+            // Rows arrive once per column, so a row can appear again out of order
+            auto& posting = postings[grams[k]];
+            std::sort(posting.begin(), posting.end());
+            posting.erase(std::unique(posting.begin(), posting.end()), posting.end());
+            out << (k > 0 ? "," : "") << "\"" << (posting.size() > rows.size() / 2 ? "*" : EncodeRows(posting)) << "\"";
+        }
+        out << "]}}";
+    }
+
+    bool Exporter::WriteHtmlShards(const std::wstring& directory, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, HtmlShardKey shardBy, size_t shardRows, std::vector<HtmlShard>& shards)
+    {
+        // Containers sort root first so sibling OUs end up in neighbouring shards
+        std::vector<std::wstring> groupKeys(entries.size()), groupLabels(entries.size());
+        for (size_t i = 0; i < entries.size() && shardBy != HtmlShardKey::NONE; ++i)
+        {
+            if (shardBy == HtmlShardKey::CONTAINER)
+            {
+                std::vector<std::wstring> rdns = DnTree::Split(entries[i].dn, false);
+                for (size_t k = 0; k + 1 < rdns.size(); ++k)
+                {
+                    groupKeys[i] += Converters::ToLower(rdns[k]) + L'\n';
+                    groupLabels[i] = rdns[k] + (k > 0 ? L"," : L"") + groupLabels[i];
+                }
+                if (groupLabels[i].empty())
+                    groupLabels[i] = L"(root)";
+            }
+            else
+            {
+                auto it = entries[i].attrs.find(L"objectClass");
+                groupLabels[i] = it != entries[i].attrs.end() && !it->second.empty() ? it->second.back() : L"(none)";
+                groupKeys[i] = Converters::ToLower(groupLabels[i]);
+            }
+        }
+
+        std::vector<size_t> order(entries.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return groupKeys[a] < groupKeys[b]; });
+
+        std::vector<size_t> rows;
+        std::vector<const std::wstring*> labels;
+        auto flush = [&]()
+        {
+            HtmlShard shard;
+            char name[32];
+            sprintf(name, "shard_%04u.js", static_cast<unsigned int>(shards.size() + 1));
+            shard.file = name;
+            shard.first = shards.empty() ? 0 : shards.back().first + shards.back().rows;
+            shard.rows = rows.size();
+            if (shardBy == HtmlShardKey::NONE)
+                shard.label = "Entries " + std::to_string(shard.first + 1) + "-" + std::to_string(shard.first + shard.rows);
+            else if (labels.size() == 1)
+                shard.label = Converters::WStringToUtf8(*labels[0]);
+            else
+                shard.label = Converters::WStringToUtf8(*labels.front()) + " ... " + Converters::WStringToUtf8(*labels.back()) +
+                    " (" + std::to_string(labels.size()) + (shardBy == HtmlShardKey::CONTAINER ? " containers)" : " classes)");
+
+            std::wstring path = directory + L"\\" + Converters::StringToWString(shard.file);
+            std::ofstream file(path, std::ios::binary);
+            if (!file.is_open())
+            {
+                std::wcerr << L"Failed to create HTML shard: " << path << std::endl;
+                return false;
+            }
+            file << "ldapShard(" << shards.size() << ",";
+            WriteHtmlData(file, attributes, entries, rows);
+            file << ");\n";
+            file.close();
+            if (!file)
+            {
+                std::wcerr << L"Failed to write HTML shard: " << path << std::endl;
+                return false;
+            }
+            shards.push_back(shard);
+            rows.clear();
+            labels.clear();
+            return true;
+        };
+
+        // Whole groups are packed into a shard while they fit; a group larger than a
+        // shard fills as many as it needs
+        for (size_t start = 0; start < order.size();)
+        {
+            size_t end = start;
+            while (end < order.size() && groupKeys[order[end]] == groupKeys[order[start]])
+                ++end;
+            if (!rows.empty() && rows.size() + (end - start) > shardRows && !flush())
+                return false;
+            for (size_t k = start; k < end; ++k)
+            {
+                if (rows.size() == shardRows && !flush())
+                    return false;
+                if (labels.empty() || *labels.back() != groupLabels[order[start]])
+                    labels.push_back(&groupLabels[order[start]]);
+                rows.push_back(order[k]);
+            }
+            start = end;
+        }
+        return rows.empty() || flush();
+    }
+
+    bool Exporter::ExportHtml(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+        const std::vector<Entry>& entries, const Statistics& stats, HtmlLayout layout,
+        HtmlShardKey shardBy, size_t shardRows)
+    {
+        bool sharded = layout == HtmlLayout::SHARDED;
+        bool virtualRows = sharded || layout == HtmlLayout::VIRTUAL ||
+            (layout == HtmlLayout::AUTO && entries.size() > kVirtualHtmlRows);
+
+        std::wstring pageFile = filename;
+        std::wstring directory;
+        std::vector<HtmlShard> shards;
+        if (sharded)
+        {
+            directory = filename;
+            std::wstring lower = Converters::ToLower(directory);
+            for (const wchar_t* extension : { L".html", L".htm" })
+            {
+                size_t length = wcslen(extension);
+                if (lower.size() > length && lower.compare(lower.size() - length, length, extension) == 0)
+                {
+                    directory.resize(directory.size() - length);
+                    break;
+                }
+            }
+            if (!CreateDirectoryW(directory.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+            {
+                std::wcerr << L"Failed to create report directory: " << directory << std::endl;
+                return false;
+            }
+            if (!WriteHtmlShards(directory, attributes, entries, shardBy, (std::max)(shardRows, static_cast<size_t>(1)), shards))
+                return false;
+            pageFile = directory + L"\\index.html";
+        }
+
+        std::ofstream file(pageFile, std::ios::binary);
         if (!file.is_open())
         {
-            std::wcerr << L"Failed to create HTML file: " << filename << std::endl;
-            return;
+            std::wcerr << L"Failed to create HTML file: " << pageFile << std::endl;
+            return false;
         }
 
         file << "\xEF\xBB\xBF";
@@ -541,6 +1682,41 @@ namespace LDAPUtils
             << "        .export-btn:hover {\n"
             << "            transform: translateY(-2px);\n"
             << "        }\n"
+            << "        table.virtual {\n"
+            << "            table-layout: fixed;\n"
+            << "        }\n"
+            << "        table.virtual th {\n"
+            << "            width: 200px;\n"
+            << "        }\n"
+            << "        table.virtual th:first-child {\n"
+            << "            width: 80px;\n"
+            << "        }\n"
+            << "        table.virtual th:nth-child(2) {\n"
+            << "            width: 360px;\n"
+            << "        }\n"
+            << "        table.virtual td {\n"
+            << "            height: 40px;\n"
+            << "            padding-top: 0;\n"
+            << "            padding-bottom: 0;\n"
+            << "        }\n"
+            << "        table.virtual tr.spacer td {\n"
+            << "            padding: 0;\n"
+            << "            border: 0;\n"
+            << "        }\n"
+            << "        table.virtual tbody tr, table.virtual tbody tr:hover {\n"
+            << "            transition: none;\n"
+            << "            transform: none;\n"
+            << "        }\n"
+            << "        tbody tr.selected {\n"
+            << "            background: #e6f7ff;\n"
+            << "        }\n"
+            << "        .shard-list li {\n"
+            << "            cursor: pointer;\n"
+            << "        }\n"
+            << "        .shard-list li.active {\n"
+            << "            color: #1890ff;\n"
+            << "            font-weight: 600;\n"
+            << "        }\n"
             << "        ::-webkit-scrollbar {\n"
             << "            width: 10px;\n"
             << "            height: 10px;\n"
@@ -636,8 +1812,60 @@ namespace LDAPUtils
                 << EscapeXml(Converters::WStringToUtf8(attr.first))
                 << "</span><span class='stat-count'>" << attr.second << "</span></li>\n";
         }
-        file << "                </ul>\n"
-            << "                <div class=\"export-buttons\">\n"
+        file << "                </ul>\n";
+
+        // Profiled value distributions
+        for (const auto& hist : stats.valueHistograms)
+        {
+            file << "                <h3>" << EscapeXml(Converters::WStringToUtf8(hist.first)) << " values</h3>\n"
+                << "                <ul class=\"stat-list\">\n";
+            for (const auto& bucket : hist.second)
+            {
+                file << "                    <li><span class='stat-name' title='" << EscapeXml(Converters::WStringToUtf8(bucket.first)) << "'>"
+                    << EscapeXml(Converters::WStringToUtf8(bucket.first))
+                    << "</span><span class='stat-count'>" << bucket.second << "</span></li>\n";
+            }
+            file << "                </ul>\n";
+        }
+
+        // Account hygiene: age histograms and bitmask flag breakdowns
+        for (const auto& hist : stats.timeHistograms)
+        {
+            file << "                <h3>" << EscapeXml(Converters::WStringToUtf8(hist.first)) << " age</h3>\n"
+                << "                <ul class=\"stat-list\">\n";
+            for (const auto& bucket : hist.second)
+            {
+                file << "                    <li><span class='stat-name'>" << EscapeXml(Converters::WStringToUtf8(bucket.first))
+                    << "</span><span class='stat-count'>" << bucket.second << "</span></li>\n";
+            }
+            file << "                </ul>\n";
+        }
+        for (const auto& flags : stats.flagCounts)
+        {
+            file << "                <h3>" << EscapeXml(Converters::WStringToUtf8(flags.first)) << " flags</h3>\n"
+                << "                <ul class=\"stat-list\">\n";
+            for (const auto& flag : flags.second)
+            {
+                file << "                    <li><span class='stat-name' title='" << EscapeXml(Converters::WStringToUtf8(flag.first)) << "'>"
+                    << EscapeXml(Converters::WStringToUtf8(flag.first))
+                    << "</span><span class='stat-count'>" << flag.second << "</span></li>\n";
+            }
+            file << "                </ul>\n";
+        }
+
+        if (sharded)
+        {
+            file << "                <h3>Shards</h3>\n"
+                << "                <ul class=\"stat-list shard-list\">\n";
+            for (size_t k = 0; k < shards.size(); ++k)
+            {
+                file << "                    <li data-shard=\"" << k << "\"><span class='stat-name' title='" << EscapeXml(shards[k].label) << "'>"
+                    << EscapeXml(shards[k].label) << "</span><span class='stat-count'>" << shards[k].rows << "</span></li>\n";
+            }
+            file << "                </ul>\n";
+        }
+
+        file << "                <div class=\"export-buttons\">\n"
             << "                    <h3>Export Visible</h3>\n"
             << "                    <button class=\"export-btn\" onclick=\"exportToCSV()\">📄 CSV</button>\n"
             << "                    <button class=\"export-btn\" onclick=\"exportToJSON()\">📋 JSON</button>\n"
@@ -658,7 +1886,7 @@ namespace LDAPUtils
             << "                    </div>\n"
             << "                </div>\n"
             << "                <div class=\"table-wrapper\">\n"
-            << "                    <table id=\"dataTable\">\n"
+            << "                    <table id=\"dataTable\"" << (virtualRows ? " class=\"virtual\"" : "") << ">\n"
             << "                        <thead>\n"
             << "                            <tr>\n"
             << "                                <th>#</th>\n"
@@ -675,49 +1903,17 @@ namespace LDAPUtils
             << "                        </thead>\n"
             << "                        <tbody>\n";
 
-        for (size_t i = 0; i < entries.size(); ++i)
+        for (size_t i = 0; i < entries.size() && !virtualRows; ++i)
         {
             const auto& e = entries[i];
-            std::string entryType = "unknown";
-            auto ocIt = e.attrs.find(L"objectClass");
-            if (ocIt != e.attrs.end())
-            {
-                for (const auto& oc : ocIt->second)
-                {
-                    std::wstring ocLower = Converters::ToLower(oc);
-                    if (ocLower == L"user" || ocLower == L"person") {
-                        entryType = "user";
-                        break;
-                    }
-                    else if (ocLower == L"group") {
-                        entryType = "group";
-                        break;
-                    }
-                    else if (ocLower == L"computer") {
-                        entryType = "computer";
-                        break;
-                    }
-                }
-            }
-
-            file << "                            <tr data-type=\"" << entryType << "\" data-index=\"" << i << "\">\n"
+            file << "                            <tr data-type=\"" << kEntryTypes[EntryTypeCode(e)] << "\" data-index=\"" << i << "\">\n"
                 << "                                <td>" << (i + 1) << "</td>\n"
                 << "                                <td class=\"dn-cell\" title=\"" << EscapeXml(Converters::WStringToUtf8(e.dn)) << "\">"
                 << EscapeXml(Converters::WStringToUtf8(e.dn)) << "</td>\n";
 
             for (const auto& attr : attributes)
             {
-                std::wstring joined;
-                auto it = e.attrs.find(attr);
-                if (it != e.attrs.end() && !it->second.empty())
-                {
-                    for (size_t k = 0; k < it->second.size(); ++k)
-                    {
-                        if (k > 0) joined += L" | ";
-                        joined += it->second[k];
-                    }
-                }
-                std::string cellContent = Converters::WStringToUtf8(joined);
+                std::string cellContent = Converters::WStringToUtf8(JoinedValues(e, attr, false));
                 file << "                                <td title=\"" << EscapeXml(cellContent) << "\">" << EscapeXml(cellContent) << "</td>\n";
             }
 
@@ -736,8 +1932,46 @@ namespace LDAPUtils
             << "                </div>\n"
             << "            </div>\n"
             << "        </div>\n"
-            << "    </div>\n"
-            << "    <script>\n"
+            << "    </div>\n";
+
+        if (virtualRows)
+        {
+            if (sharded)
+            {
+                file << "    <script type=\"application/json\" id=\"ldapShards\">{\"files\":[";
+                for (size_t k = 0; k < shards.size(); ++k)
+                    file << (k > 0 ? "," : "") << "\"" << shards[k].file << "\"";
+                file << "],\"first\":[";
+                for (size_t k = 0; k < shards.size(); ++k)
+                    file << (k > 0 ? "," : "") << shards[k].first;
+                file << "]}</script>\n";
+            }
+            else
+            {
+                std::vector<size_t> rows(entries.size());
+                for (size_t i = 0; i < rows.size(); ++i)
+                    rows[i] = i;
+                file << "    <script type=\"application/json\" id=\"ldapData\">";
+                WriteHtmlData(file, attributes, entries, rows);
+                file << "</script>\n";
+            }
+            WriteVirtualRowsScript(file);
+            file << "</body>\n"
+                << "</html>\n";
+            file.close();
+            if (!file)
+            {
+                std::wcerr << L"Failed to write HTML file: " << pageFile << std::endl;
+                return false;
+            }
+            if (sharded)
+                std::wcout << L"HTML report written to " << directory << L" (" << shards.size() << L" shards)" << std::endl;
+            else
+                std::wcout << L"HTML exported successfully with virtual rows (" << entries.size() << L" entries)" << std::endl;
+            return true;
+        }
+
+        file << "    <script>\n"
             << "        const searchInput = document.getElementById('searchInput');\n"
             << "        const table = document.getElementById('dataTable');\n"
             << "        const tbody = table.querySelector('tbody');\n"
@@ -947,6 +2181,12 @@ namespace LDAPUtils
             << "</html>\n";
 
         file.close();
+        if (!file)
+        {
+            std::wcerr << L"Failed to write HTML file: " << pageFile << std::endl;
+            return false;
+        }
         std::wcout << L"HTML exported successfully with advanced features" << std::endl;
+        return true;
     }
 }
\ No newline at end of file
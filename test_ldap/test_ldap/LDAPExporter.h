@@ -1,23 +1,84 @@
 #pragma once
 #include "LDAPTypes.h"
 #include "LDAPConverters.h"
+#include <ostream>
 
 namespace LDAPUtils
 {
     class Exporter
     {
     public:
-        static void ExportCsv(const std::wstring& filename, const std::vector<std::wstring>& attributes,
-            const std::vector<Entry>& entries);
-        static void ExportTxt(const std::wstring& filename, const std::vector<Entry>& entries);
-        static void ExportJson(const std::wstring& filename, const std::vector<Entry>& entries);
-        static void ExportXml(const std::wstring& filename, const std::vector<Entry>& entries);
-        static void ExportHtml(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+        // Exports take a resolved style (DISPLAY or RAW); TXT and HTML are for
+        // people and always describe values. False when the file could not be written
+        static bool ExportCsv(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+            const std::vector<Entry>& entries, ValueStyle style = ValueStyle::DISPLAY);
+        // Binary columnar sidecar for the CSV viewer: "LDAPCOL1", u32 rows, u32 columns, then
+        // per column: u32 name length, name, u32 flags (bits 0-1: id width 0/1/2/4 bytes,
+        // 0 = id is the row; kColumnarNumeric), u32 dictionary size n, u32 blob size,
+        // u32 offsets[n + 1], UTF-8 blob, ids[rows], u32 order[rows] (rows in ascending
+        // order of the column). Arrays are 4-byte aligned, integers little-endian
+        static bool ExportColumnar(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+            const std::vector<Entry>& entries, ValueStyle style = ValueStyle::DISPLAY);
+        static bool ExportTxt(const std::wstring& filename, const std::vector<Entry>& entries);
+        static bool ExportJson(const std::wstring& filename, const std::vector<Entry>& entries,
+            ValueStyle style = ValueStyle::RAW);
+        static bool ExportXml(const std::wstring& filename, const std::vector<Entry>& entries,
+            ValueStyle style = ValueStyle::RAW);
+        // Above this many entries the AUTO layout embeds the data once and renders
+        // only the rows in view instead of writing a <tr> per entry
+        static const size_t kVirtualHtmlRows = 2000;
+
+        // SHARDED writes a directory named after filename (without .html) holding
+        // index.html and shard_NNNN.js files of at most shardRows entries each
+        static bool ExportHtml(const std::wstring& filename, const std::vector<std::wstring>& attributes,
+            const std::vector<Entry>& entries, const Statistics& stats, HtmlLayout layout = HtmlLayout::AUTO,
+            HtmlShardKey shardBy = HtmlShardKey::CONTAINER, size_t shardRows = 25000);
+
+        // Stream writers shared by the file exporters and the query service
+        static void WriteCsv(std::ostream& out, const std::vector<std::wstring>& attributes,
+            const std::vector<Entry>& entries, ValueStyle style = ValueStyle::DISPLAY);
+        static void WriteNdjson(std::ostream& out, const std::vector<Entry>& entries,
+            ValueStyle style = ValueStyle::RAW);
+
+        // Writes entries to config.outputFile in config.format (and the columnar
+        // sidecar when asked); false when a file could not be written
+        static bool Export(const SearchConfig& config, const std::vector<std::wstring>& attributes,
             const std::vector<Entry>& entries, const Statistics& stats);
 
+        // Sorted union of the attribute names present in entries (columns for "*")
+        static std::vector<std::wstring> AttributeNames(const std::vector<Entry>& entries);
+
+        static std::wstring FormatName(OutputFormat format);
+        static std::wstring DefaultFileName(OutputFormat format);
+        static bool ParseFormat(const std::wstring& name, OutputFormat& outFormat);
+
     private:
+        static constexpr const char* kColumnarMagic = "LDAPCOL1";
+        static const uint32_t kColumnarNumeric = 4;     // Column ordered by number or timestamp
+
         static std::string EscapeCsvField(const std::string& input);
         static std::string EscapeJson(const std::string& input);
         static std::string EscapeXml(const std::string& input);
+
+        // Columnar JSON of entries[rows] for the virtual and sharded HTML layouts:
+        // {"rows", "columns", "types",
+        // "cols": [{"v": [values]} or {"d": [distinct values], "i": [indexes]}],
+        // "keys": sort keys of numeric and timestamp columns,
+        // "index": trigram postings over the "v" columns for the page's search}
+        static void WriteHtmlData(std::ostream& out, const std::vector<std::wstring>& attributes,
+            const std::vector<Entry>& entries, const std::vector<size_t>& rows);
+
+        struct HtmlShard
+        {
+            std::string file;       // Relative to the report directory
+            std::string label;      // Containers or classes it holds, for the shard list
+            size_t first = 0;       // Position of its first entry across all shards
+            size_t rows = 0;
+        };
+
+        // Groups entries by shardBy, packs small groups together and splits large
+        // ones, and writes each shard as a script calling ldapShard(n, data)
+        static bool WriteHtmlShards(const std::wstring& directory, const std::vector<std::wstring>& attributes,
+            const std::vector<Entry>& entries, HtmlShardKey shardBy, size_t shardRows, std::vector<HtmlShard>& shards);
     };
 }
\ No newline at end of file
@@ -0,0 +1,763 @@
+﻿#include "LDAPFilter.h"
+#include "LDAPConverters.h"
+#include "LDAPSnapshot.h"
+#include "LDAPDnTree.h"
+#include "LDAPSchema.h"
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <cwctype>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        const wchar_t* const kBitAndRule = L"1.2.840.113556.1.4.803";
+        const wchar_t* const kBitOrRule = L"1.2.840.113556.1.4.804";
+
+        // Whole value as an integer, decimal or 0x hex, as in "512", "-1" or "0x202"
+        bool ParseInteger(const std::wstring& text, long long& out)
+        {
+            const wchar_t* p = text.c_str();
+            bool negative = (*p == L'-');
+            if (negative) ++p;
+
+            wchar_t* end = nullptr;
+            unsigned long long value;
+            if (p[0] == L'0' && (p[1] == L'x' || p[1] == L'X') && iswxdigit(p[2]))
+                value = wcstoull(p + 2, &end, 16);
+            else if (iswdigit(*p))
+                value = wcstoull(p, &end, 10);
+            else
+                return false;
+
+            if (*end != L'\0')
+                return false;
+            out = negative ? -static_cast<long long>(value) : static_cast<long long>(value);
+            return true;
+        }
+
+        // Integers and FILETIMEs were parsed when the value was decoded
+        bool NumberOf(const Value& value, long long& out)
+        {
+            if (value.kind() == ValueKind::INTEGER || value.kind() == ValueKind::FILETIME)
+            {
+                out = value.Number();
+                return true;
+            }
+            return ParseInteger(value, out);
+        }
+
+        // Positions below count for which test holds, ascending. Large ranges are
+        // split into up to threadCount chunks tested in parallel (0 = one per core)
+        template <typename Test>
+        std::vector<size_t> ParallelSelect(size_t count, unsigned int threadCount, const Test& test)
+        {
+            if (threadCount == 0)
+                threadCount = std::max(1u, std::thread::hardware_concurrency());
+            const size_t minEntriesPerThread = 16384;
+            size_t partitions = std::min<size_t>(threadCount, std::max<size_t>(1, count / minEntriesPerThread));
+
+            std::vector<char> matched(count, 0);
+            auto scan = [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    matched[i] = test(i);
+            };
+
+            size_t chunk = (count + partitions - 1) / partitions;
+            std::vector<std::thread> workers;
+            for (size_t p = 1; p < partitions; ++p)
+                workers.emplace_back(scan, p * chunk, std::min(count, (p + 1) * chunk));
+            scan(0, std::min(count, chunk));
+            for (auto& worker : workers)
+                worker.join();
+
+            std::vector<size_t> selected;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (matched[i]) selected.push_back(i);
+            }
+            return selected;
+        }
+
+        // Flag attributes are 32-bit signed in AD but displayed as unsigned hex
+        unsigned long long Normalize32(long long value)
+        {
+            if (value >= -2147483648LL && value <= 0xFFFFFFFFLL)
+                return static_cast<unsigned int>(value);
+            return static_cast<unsigned long long>(value);
+        }
+
+        // towlower is a locale call; directory data is overwhelmingly ASCII
+        inline wchar_t FoldCase(wchar_t c)
+        {
+            if (c < 0x80)
+                return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + 32) : c;
+            return static_cast<wchar_t>(towlower(c));
+        }
+
+        bool EqualsIgnoreCase(const wchar_t* a, const wchar_t* b, size_t length)
+        {
+            for (size_t i = 0; i < length; ++i)
+            {
+                if (a[i] != b[i] && FoldCase(a[i]) != FoldCase(b[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        // needle is already lower-cased
+        bool MatchesAt(const std::wstring& haystack, const std::wstring& needle, size_t at)
+        {
+            if (at + needle.size() > haystack.size())
+                return false;
+            for (size_t k = 0; k < needle.size(); ++k)
+            {
+                if (FoldCase(haystack[at + k]) != needle[k])
+                    return false;
+            }
+            return true;
+        }
+
+        size_t FindIgnoreCase(const std::wstring& haystack, const std::wstring& needle, size_t from)
+        {
+            for (size_t i = from; i + needle.size() <= haystack.size(); ++i)
+            {
+                if (MatchesAt(haystack, needle, i))
+                    return i;
+            }
+            return std::wstring::npos;
+        }
+
+        bool MatchSubstrings(const std::wstring& value, const Filter::Node& node)
+        {
+            const auto& parts = node.substrings;
+            size_t first = 0, last = parts.size(), pos = 0;
+            if (node.anchoredStart)
+            {
+                if (!MatchesAt(value, parts[0], 0))
+                    return false;
+                pos = parts[0].size();
+                first = 1;
+            }
+            if (node.anchoredEnd)
+                --last;
+
+            for (size_t i = first; i < last; ++i)
+            {
+                size_t found = FindIgnoreCase(value, parts[i], pos);
+                if (found == std::wstring::npos)
+                    return false;
+                pos = found + parts[i].size();
+            }
+
+            if (node.anchoredEnd)
+            {
+                const std::wstring& tail = parts.back();
+                return value.size() >= pos + tail.size() && MatchesAt(value, tail, value.size() - tail.size());
+            }
+            return true;
+        }
+
+        // Remove spaces around RDN separators so "DC=corp, DC=com" compares equal to "DC=corp,DC=com"
+        std::wstring NormalizeDn(const std::wstring& dn)
+        {
+            std::wstring out;
+            out.reserve(dn.size());
+            for (size_t i = 0; i < dn.size(); ++i)
+            {
+                wchar_t c = dn[i];
+                if (c == L' ' && (out.empty() || out.back() == L',' || out.back() == L'='))
+                    continue;
+                if ((c == L',' || c == L'=') && !out.empty() && out.back() == L' ' && (out.size() < 2 || out[out.size() - 2] != L'\\'))
+                    out.pop_back();
+                out += c;
+            }
+            return out;
+        }
+
+        int HexDigit(wchar_t c)
+        {
+            if (c >= L'0' && c <= L'9') return c - L'0';
+            if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+            if (c >= L'A' && c <= L'F') return c - L'A' + 10;
+            return -1;
+        }
+
+        // RFC 4515 value unescaping to raw bytes (UTF-8 for text)
+        bool Unescape(const std::wstring& raw, std::string& bytes, bool& hadEscapes)
+        {
+            bytes.clear();
+            hadEscapes = false;
+            std::wstring plain;
+            for (size_t i = 0; i < raw.size(); ++i)
+            {
+                if (raw[i] != L'\\')
+                {
+                    plain += raw[i];
+                    continue;
+                }
+                if (i + 2 >= raw.size())
+                    return false;
+                int high = HexDigit(raw[i + 1]), low = HexDigit(raw[i + 2]);
+                if (high < 0 || low < 0)
+                    return false;
+                bytes += Converters::WStringToUtf8(plain);
+                plain.clear();
+                bytes += static_cast<char>(high * 16 + low);
+                hadEscapes = true;
+                i += 2;
+            }
+            bytes += Converters::WStringToUtf8(plain);
+            return true;
+        }
+
+        class Parser
+        {
+        private:
+            const std::wstring& text;
+            size_t pos = 0;
+            std::wstring& error;
+
+            bool Fail(const std::wstring& message)
+            {
+                error = message + L" at position " + std::to_wstring(pos);
+                return false;
+            }
+
+            void SkipSpaces()
+            {
+                while (pos < text.size() && text[pos] == L' ') ++pos;
+            }
+
+            bool DecodeValue(const std::wstring& raw, const std::wstring& attribute, std::wstring& out)
+            {
+                std::string bytes;
+                bool hadEscapes;
+                if (!Unescape(raw, bytes, hadEscapes))
+                    return Fail(L"Invalid escape in value");
+
+                // Binary GUID assertions (\01\02...) are compared with the stored GUID string
+                if (hadEscapes && bytes.size() == 16 && Converters::ToLower(attribute).find(L"guid") != std::wstring::npos)
+                    out = Converters::ConvertGUIDToString(reinterpret_cast<const unsigned char*>(bytes.data()), 16);
+                else
+                    out = Converters::StringToWString(bytes);
+                return true;
+            }
+
+            bool ParseItem(Filter::Node& node)
+            {
+                size_t start = pos;
+                while (pos < text.size() && text[pos] != L'=' && text[pos] != L'~' && text[pos] != L'>' &&
+                    text[pos] != L'<' && text[pos] != L':' && text[pos] != L'(' && text[pos] != L')')
+                    ++pos;
+                node.attribute = text.substr(start, pos - start);
+                while (!node.attribute.empty() && node.attribute.back() == L' ')
+                    node.attribute.pop_back();
+                if (pos >= text.size() || text[pos] == L'(' || text[pos] == L')')
+                    return Fail(L"Expected comparison operator");
+
+                std::wstring rule;
+                if (text[pos] == L':')
+                {
+                    // Extensible match: attr[:dn][:rule]:=value
+                    while (pos < text.size() && text[pos] == L':' && (pos + 1 >= text.size() || text[pos + 1] != L'='))
+                    {
+                        size_t segment = ++pos;
+                        while (pos < text.size() && text[pos] != L':') ++pos;
+                        std::wstring part = text.substr(segment, pos - segment);
+                        if (Converters::ToLower(part) != L"dn")
+                            rule = part;
+                    }
+                    if (pos + 1 >= text.size() || text[pos] != L':' || text[pos + 1] != L'=')
+                        return Fail(L"Expected :=");
+                    pos += 2;
+                    if (rule == kBitAndRule) node.op = Filter::Op::BitAnd;
+                    else if (rule == kBitOrRule) node.op = Filter::Op::BitOr;
+                    else node.op = Filter::Op::Equal;   // Other rules (e.g. in-chain) compare direct values
+                }
+                else if (text[pos] == L'=')
+                {
+                    node.op = Filter::Op::Equal;
+                    ++pos;
+                }
+                else if (pos + 1 < text.size() && text[pos + 1] == L'=')
+                {
+                    node.op = text[pos] == L'>' ? Filter::Op::GreaterOrEqual :
+                        text[pos] == L'<' ? Filter::Op::LessOrEqual : Filter::Op::Equal;  // ~= is equality in AD
+                    pos += 2;
+                }
+                else
+                {
+                    return Fail(L"Unknown comparison operator");
+                }
+
+                if (node.attribute.empty())
+                    return Fail(L"Missing attribute name");
+
+                start = pos;
+                while (pos < text.size() && text[pos] != L')') ++pos;
+                std::wstring raw = text.substr(start, pos - start);
+
+                if (node.op == Filter::Op::Equal && rule.empty() && raw == L"*")
+                {
+                    node.op = Filter::Op::Present;
+                    return true;
+                }
+
+                if (node.op == Filter::Op::Equal && rule.empty() && raw.find(L'*') != std::wstring::npos)
+                {
+                    node.op = Filter::Op::Substring;
+                    std::vector<std::wstring> parts;
+                    size_t from = 0;
+                    while (true)
+                    {
+                        size_t star = raw.find(L'*', from);
+                        parts.push_back(raw.substr(from, star == std::wstring::npos ? std::wstring::npos : star - from));
+                        if (star == std::wstring::npos) break;
+                        from = star + 1;
+                    }
+                    node.anchoredStart = !parts.front().empty();
+                    node.anchoredEnd = !parts.back().empty();
+                    for (const auto& part : parts)
+                    {
+                        if (part.empty()) continue;
+                        std::wstring decoded;
+                        if (!DecodeValue(part, node.attribute, decoded))
+                            return false;
+                        node.substrings.push_back(Converters::ToLower(decoded));
+                    }
+                    return true;
+                }
+
+                if (!DecodeValue(raw, node.attribute, node.value))
+                    return false;
+                node.lowerValue = Converters::ToLower(node.value);
+                // Only integer and FILETIME attributes compare as numbers; strings such
+                // as "10 Main St" never do, whatever they start with
+                bool integer = ParseInteger(node.value, node.number);
+                ValueKind kind = Schema::Active().KindOf(node.attribute);
+                node.numeric = integer && (kind == ValueKind::INTEGER || kind == ValueKind::FILETIME);
+                node.ticks = (node.op == Filter::Op::GreaterOrEqual || node.op == Filter::Op::LessOrEqual) &&
+                    (kind == ValueKind::TIME || kind == ValueKind::FILETIME) ? Converters::ParseTimestampTicks(node.value) : 0;
+                node.categoryName = Converters::ToLower(node.attribute) == L"objectcategory" &&
+                    node.value.find(L'=') == std::wstring::npos;
+
+                if ((node.op == Filter::Op::BitAnd || node.op == Filter::Op::BitOr) && !integer)
+                    return Fail(L"Bitwise matching rule needs an integer value");
+                return true;
+            }
+
+        public:
+            Parser(const std::wstring& text, std::wstring& error) : text(text), error(error) {}
+
+            bool ParseFilter(Filter::Node& node)
+            {
+                SkipSpaces();
+                if (pos >= text.size() || text[pos] != L'(')
+                    return Fail(L"Expected (");
+                ++pos;
+                SkipSpaces();
+                if (pos >= text.size())
+                    return Fail(L"Unexpected end of filter");
+
+                wchar_t c = text[pos];
+                if (c == L'&' || c == L'|' || c == L'!')
+                {
+                    node.op = c == L'&' ? Filter::Op::And : c == L'|' ? Filter::Op::Or : Filter::Op::Not;
+                    ++pos;
+                    SkipSpaces();
+                    while (pos < text.size() && text[pos] == L'(')
+                    {
+                        node.children.emplace_back();
+                        if (!ParseFilter(node.children.back()))
+                            return false;
+                        SkipSpaces();
+                    }
+                    if (node.op == Filter::Op::Not && node.children.size() != 1)
+                        return Fail(L"! takes exactly one filter");
+                }
+                else if (!ParseItem(node))
+                {
+                    return false;
+                }
+
+                if (pos >= text.size() || text[pos] != L')')
+                    return Fail(L"Expected )");
+                ++pos;
+                return true;
+            }
+
+            bool AtEnd()
+            {
+                SkipSpaces();
+                return pos == text.size();
+            }
+        };
+
+        void BindNode(Filter::Node& node, const std::vector<std::wstring>& attributeNames)
+        {
+            node.names.clear();
+            if (!node.attribute.empty())
+            {
+                for (const auto& name : attributeNames)
+                {
+                    if (name.size() == node.attribute.size() &&
+                        EqualsIgnoreCase(name.c_str(), node.attribute.c_str(), name.size()))
+                        node.names.push_back(name);
+                }
+            }
+            for (auto& child : node.children)
+                BindNode(child, attributeNames);
+        }
+    }
+
+    void FilterIndex::Build(const std::vector<Entry>& entries, const std::vector<std::wstring>& attributes)
+    {
+        // Names are looked up as spelled; pass them as the directory returns them
+        for (const auto& attribute : attributes)
+        {
+            auto& index = indexes[Converters::ToLower(attribute)];
+            index.clear();
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                auto attr = entries[i].attrs.find(attribute);
+                if (attr == entries[i].attrs.end())
+                    continue;
+                for (const auto& val : attr->second)
+                {
+                    auto& ids = index[Converters::ToLower(val)];
+                    if (ids.empty() || ids.back() != i)
+                        ids.push_back(static_cast<unsigned int>(i));
+                }
+            }
+        }
+    }
+
+    bool FilterIndex::Has(const std::wstring& attribute) const
+    {
+        return indexes.count(Converters::ToLower(attribute)) > 0;
+    }
+
+    const std::vector<unsigned int>* FilterIndex::Find(const std::wstring& attribute, const std::wstring& value) const
+    {
+        auto index = indexes.find(Converters::ToLower(attribute));
+        if (index == indexes.end())
+            return nullptr;
+        auto it = index->second.find(Converters::ToLower(value));
+        return it == index->second.end() ? nullptr : &it->second;
+    }
+
+    bool Filter::Parse(const std::wstring& filterText, Filter& outFilter, std::wstring& outError)
+    {
+        Filter parsed;
+        parsed.text = filterText;
+
+        // Bare items without parentheses are accepted, as ldap_search does
+        std::wstring text = filterText;
+        size_t first = text.find_first_not_of(L' ');
+        if (first != std::wstring::npos && text[first] != L'(')
+            text = L"(" + text + L")";
+
+        Parser parser(text, outError);
+        if (!parser.ParseFilter(parsed.root))
+            return false;
+        if (!parser.AtEnd())
+        {
+            outError = L"Unexpected text after filter";
+            return false;
+        }
+
+        outFilter = std::move(parsed);
+        return true;
+    }
+
+    void Filter::Bind(const std::vector<std::wstring>& attributeNames)
+    {
+        BindNode(root, attributeNames);
+        bound = true;
+    }
+
+    const std::vector<Value>* Filter::Lookup(const Node& node, const Entry& entry) const
+    {
+        if (bound)
+        {
+            for (const auto& name : node.names)
+            {
+                auto it = entry.attrs.find(name);
+                if (it != entry.attrs.end())
+                    return &it->second;
+            }
+            return nullptr;
+        }
+
+        auto it = entry.attrs.find(node.attribute);
+        if (it != entry.attrs.end())
+            return &it->second;
+        for (const auto& attr : entry.attrs)
+        {
+            if (attr.first.size() == node.attribute.size() &&
+                EqualsIgnoreCase(attr.first.c_str(), node.attribute.c_str(), attr.first.size()))
+                return &attr.second;
+        }
+        return nullptr;
+    }
+
+    bool Filter::Evaluate(const Node& node, const Entry& entry) const
+    {
+        switch (node.op)
+        {
+        case Op::And:
+            for (const auto& child : node.children)
+            {
+                if (!Evaluate(child, entry)) return false;
+            }
+            return true;
+
+        case Op::Or:
+            for (const auto& child : node.children)
+            {
+                if (Evaluate(child, entry)) return true;
+            }
+            return false;
+
+        case Op::Not:
+            return !Evaluate(node.children[0], entry);
+
+        default:
+            break;
+        }
+
+        const std::vector<Value>* values = Lookup(node, entry);
+        if (node.op == Op::Present)
+        {
+            // Every directory object has objectClass, even when it was not retrieved
+            if (node.attribute.size() == 11 && EqualsIgnoreCase(node.attribute.c_str(), L"objectClass", 11))
+                return true;
+            return values && !values->empty();
+        }
+        if (!values)
+            return false;
+
+        for (const auto& value : *values)
+        {
+            long long number;
+            switch (node.op)
+            {
+            case Op::Equal:
+                if (value.size() == node.value.size() && EqualsIgnoreCase(value.c_str(), node.value.c_str(), value.size()))
+                    return true;
+                if (node.numeric && NumberOf(value, number) && Normalize32(number) == Normalize32(node.number))
+                    return true;
+                if (node.categoryName && value.size() > node.value.size() + 3 && EqualsIgnoreCase(value.c_str(), L"CN=", 3) &&
+                    EqualsIgnoreCase(value.c_str() + 3, node.value.c_str(), node.value.size()) &&
+                    value[node.value.size() + 3] == L',')
+                    return true;
+                break;
+
+            case Op::Substring:
+                if (MatchSubstrings(value, node))
+                    return true;
+                break;
+
+            case Op::GreaterOrEqual:
+            case Op::LessOrEqual:
+            {
+                int order;
+                unsigned long long ticks;
+                if (node.numeric && NumberOf(value, number))
+                    order = number < node.number ? -1 : number > node.number ? 1 : 0;
+                else if (node.ticks && (ticks = Converters::TimestampTicks(value)) != 0)
+                    order = ticks < node.ticks ? -1 : ticks > node.ticks ? 1 : 0;
+                else
+                    order = _wcsicmp(value.c_str(), node.value.c_str());
+                if (node.op == Op::GreaterOrEqual ? order >= 0 : order <= 0)
+                    return true;
+                break;
+            }
+
+            case Op::BitAnd:
+            case Op::BitOr:
+                if (NumberOf(value, number))
+                {
+                    unsigned long long bits = Normalize32(number) & Normalize32(node.number);
+                    if (node.op == Op::BitAnd ? bits == Normalize32(node.number) : bits != 0)
+                        return true;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+    bool Filter::Matches(const Entry& entry) const
+    {
+        return Evaluate(root, entry);
+    }
+
+    bool Filter::Candidates(const Node& node, const std::function<bool(const Node&, std::vector<unsigned int>&)>& leaf,
+        std::vector<unsigned int>& out) const
+    {
+        if (leaf(node, out))
+            return true;
+
+        if (node.op == Op::And)
+        {
+            // Every indexed term bounds the result, so their candidates intersect
+            bool found = false;
+            std::vector<unsigned int> child, both;
+            for (const auto& c : node.children)
+            {
+                if (!Candidates(c, leaf, child))
+                    continue;
+                if (found)
+                {
+                    both.clear();
+                    std::set_intersection(out.begin(), out.end(), child.begin(), child.end(), std::back_inserter(both));
+                    out.swap(both);
+                }
+                else
+                {
+                    out.swap(child);
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        if (node.op == Op::Or && !node.children.empty())
+        {
+            std::vector<unsigned int> merged, child;
+            for (const auto& c : node.children)
+            {
+                if (!Candidates(c, leaf, child))
+                    return false;
+                merged.insert(merged.end(), child.begin(), child.end());
+            }
+            std::sort(merged.begin(), merged.end());
+            merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+            out.swap(merged);
+            return true;
+        }
+        return false;
+    }
+
+    bool Filter::IndexCandidates(const FilterIndex& index, std::vector<unsigned int>& out) const
+    {
+        auto indexed = [&](const Node& node, std::vector<unsigned int>& ids)
+        {
+            if (node.op != Op::Equal || node.numeric || node.categoryName || !index.Has(node.attribute))
+                return false;
+            const std::vector<unsigned int>* found = index.Find(node.attribute, node.value);
+            ids = found ? *found : std::vector<unsigned int>();
+            return true;
+        };
+        return Candidates(root, indexed, out);
+    }
+
+    std::vector<size_t> Filter::Select(const std::vector<Entry>& entries, const std::wstring& baseDN, unsigned long scope,
+        const FilterIndex* index, unsigned int threadCount) const
+    {
+        std::wstring base = NormalizeDn(baseDN);
+        std::vector<size_t> selected;
+
+        std::vector<unsigned int> candidates;
+        if (index && IndexCandidates(*index, candidates))
+        {
+            for (auto i : candidates)
+            {
+                if (InScope(entries[i].dn, base, scope) && Matches(entries[i]))
+                    selected.push_back(i);
+            }
+            return selected;
+        }
+
+        return ParallelSelect(entries.size(), threadCount,
+            [&](size_t i) { return InScope(entries[i].dn, base, scope) && Matches(entries[i]); });
+    }
+
+    std::vector<size_t> Filter::Select(const std::vector<Entry>& entries, const DnTree& tree, const std::wstring& baseDN,
+        unsigned long scope, const FilterIndex* index, unsigned int threadCount) const
+    {
+        std::vector<size_t> scoped = tree.Select(baseDN, scope);
+
+        std::vector<unsigned int> candidates;
+        if (index && IndexCandidates(*index, candidates))
+        {
+            std::vector<size_t> both;
+            std::set_intersection(scoped.begin(), scoped.end(), candidates.begin(), candidates.end(), std::back_inserter(both));
+            scoped.swap(both);
+        }
+
+        std::vector<size_t> selected = ParallelSelect(scoped.size(), threadCount,
+            [&](size_t i) { return scoped[i] < entries.size() && Matches(entries[scoped[i]]); });
+        for (auto& position : selected)
+            position = scoped[position];
+        return selected;
+    }
+
+    bool Filter::SelectIndexed(const SnapshotView& view, const std::wstring& baseDN, unsigned long scope,
+        std::vector<Entry>& outEntries) const
+    {
+        // Range terms qualify only when the assertion is a timestamp; the index then
+        // orders values the same way Evaluate does, and lists the rest as candidates
+        auto indexed = [&](const Node& node, std::vector<unsigned int>& out)
+        {
+            switch (node.op)
+            {
+            case Op::Equal:
+                return !node.numeric && !node.categoryName && view.FindEqual(node.attribute, node.value, out);
+            case Op::GreaterOrEqual:
+                return node.ticks != 0 && view.FindRange(node.attribute, node.ticks, ~0ULL, out);
+            case Op::LessOrEqual:
+                return node.ticks != 0 && view.FindRange(node.attribute, 0, node.ticks, out);
+            default:
+                return false;
+            }
+        };
+
+        std::vector<unsigned int> candidates;
+        if (!Candidates(root, indexed, candidates))
+            return false;
+
+        std::wstring base = NormalizeDn(baseDN);
+        outEntries.clear();
+        for (auto i : candidates)
+        {
+            Entry entry;
+            if (view.EntryAt(i, entry) && InScope(entry.dn, base, scope) && Matches(entry))
+                outEntries.push_back(std::move(entry));
+        }
+        return true;
+    }
+
+    bool Filter::InScope(const std::wstring& dn, const std::wstring& baseDN, unsigned long scope)
+    {
+        if (baseDN.empty())
+            return scope != 0 || dn.empty();
+        if (dn.size() < baseDN.size())
+            return false;
+
+        size_t tail = dn.size() - baseDN.size();
+        if (!EqualsIgnoreCase(dn.c_str() + tail, baseDN.c_str(), baseDN.size()))
+            return false;
+        if (tail == 0)
+            return scope != 1;      // The base object itself is outside a one-level search
+        if (scope == 0 || dn[tail - 1] != L',' || (tail >= 2 && dn[tail - 2] == L'\\'))
+            return false;
+        if (scope == 2)
+            return true;
+
+        // One level: the remaining RDN must not contain another unescaped separator
+        for (size_t i = 0; i + 1 < tail; ++i)
+        {
+            if (dn[i] == L'\\') ++i;
+            else if (dn[i] == L',') return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "LDAPTypes.h"
+#include <unordered_map>
+#include <functional>
+
+namespace LDAPUtils
+{
+    class SnapshotView;
+    class DnTree;
+
+    // Equality lookups over selected attributes: lower-cased value -> entry numbers
+    class FilterIndex
+    {
+    private:
+        std::unordered_map<std::wstring, std::unordered_map<std::wstring, std::vector<unsigned int>>> indexes;
+
+    public:
+        // Attribute names are matched as spelled in the entries
+        void Build(const std::vector<Entry>& entries, const std::vector<std::wstring>& attributes);
+        bool Has(const std::wstring& attribute) const;
+
+        // Entry numbers whose attribute holds value (case-insensitive); nullptr if none
+        const std::vector<unsigned int>* Find(const std::wstring& attribute, const std::wstring& value) const;
+    };
+
+    // RFC 4515 search filter evaluated locally with Active Directory semantics:
+    // case-insensitive names and values, bitwise matching rules
+    // 1.2.840.113556.1.4.803 (AND) / 804 (OR), integer and timestamp ranges,
+    // objectCategory short names, and binary GUID assertions. Values are
+    // compared as snapshots store them, raw: integers and FILETIMEs by the
+    // number parsed when they were decoded, generalized times as timestamps.
+    // Whether an attribute is one of those comes from Schema::Active (KindOf);
+    // any other attribute compares as a case-insensitive string.
+    class Filter
+    {
+    public:
+        enum class Op
+        {
+            And,
+            Or,
+            Not,
+            Equal,
+            Substring,
+            GreaterOrEqual,
+            LessOrEqual,
+            Present,
+            BitAnd,
+            BitOr
+        };
+
+        struct Node
+        {
+            Op op = Op::Present;
+            std::wstring attribute;             // As written in the filter
+            std::vector<std::wstring> names;    // Exact spellings to look up after Bind
+            std::wstring value;                 // Unescaped assertion value
+            std::wstring lowerValue;
+            bool numeric = false;               // Integer assertion on an INTEGER or FILETIME attribute
+            bool categoryName = false;          // objectCategory=person style short name
+            long long number = 0;
+            unsigned long long ticks = 0;       // Range assertion on a timestamp attribute, else 0
+            std::vector<std::wstring> substrings;   // Lower-cased initial, any..., final
+            bool anchoredStart = false;
+            bool anchoredEnd = false;
+            std::vector<Node> children;
+        };
+
+    private:
+        Node root;
+        std::wstring text;
+        bool bound = false;
+
+        bool Evaluate(const Node& node, const Entry& entry) const;
+        const std::vector<Value>* Lookup(const Node& node, const Entry& entry) const;
+        // leaf returns false for terms it cannot narrow
+        bool Candidates(const Node& node, const std::function<bool(const Node&, std::vector<unsigned int>&)>& leaf,
+            std::vector<unsigned int>& out) const;
+        // Candidates from the equality terms index covers; false when none narrows
+        bool IndexCandidates(const FilterIndex& index, std::vector<unsigned int>& out) const;
+
+    public:
+        static bool Parse(const std::wstring& filterText, Filter& outFilter, std::wstring& outError);
+
+        // Resolves attribute names to the spellings present in the data; unbound
+        // filters fall back to a case-insensitive search of each entry
+        void Bind(const std::vector<std::wstring>& attributeNames);
+
+        bool Matches(const Entry& entry) const;
+        const std::wstring& Text() const { return text; }
+
+        // Entry numbers (ascending) in scope of baseDN that match. Equality terms on
+        // attributes in index narrow the candidates before the full predicate runs.
+        std::vector<size_t> Select(const std::vector<Entry>& entries, const std::wstring& baseDN, unsigned long scope,
+            const FilterIndex* index = nullptr, unsigned int threadCount = 0) const;
+
+        // Same with the scope answered by a DN tree over entries instead of comparing
+        // every DN against the base
+        std::vector<size_t> Select(const std::vector<Entry>& entries, const DnTree& tree, const std::wstring& baseDN,
+            unsigned long scope, const FilterIndex* index = nullptr, unsigned int threadCount = 0) const;
+
+        // Same against a snapshot file, decoding only the entries its secondary
+        // indexes point at. Returns false (and decodes nothing) when no term of the
+        // filter is covered, leaving the caller to materialize and scan.
+        bool SelectIndexed(const SnapshotView& view, const std::wstring& baseDN, unsigned long scope,
+            std::vector<Entry>& outEntries) const;
+
+        // 0 = base, 1 = one level, 2 = subtree; empty base matches everything
+        static bool InScope(const std::wstring& dn, const std::wstring& baseDN, unsigned long scope);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,441 @@
+﻿#include "LDAPGroups.h"
+#include "LDAPConverters.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        // Attribute values under the usual spelling, or any spelling (LDIF sources)
+        const std::vector<Value>* Values(const Entry& entry, const wchar_t* name)
+        {
+            auto it = entry.attrs.find(name);
+            if (it != entry.attrs.end())
+                return &it->second;
+            for (const auto& attr : entry.attrs)
+            {
+                if (_wcsicmp(attr.first.c_str(), name) == 0)
+                    return &attr.second;
+            }
+            return nullptr;
+        }
+
+        // Flattens (from, to) pairs into offsets/targets; pairs must be sorted by from
+        void BuildCsr(const std::vector<std::pair<unsigned int, unsigned int>>& edges, size_t vertexCount,
+            std::vector<unsigned int>& offsets, std::vector<unsigned int>& targets)
+        {
+            offsets.assign(vertexCount + 1, 0);
+            targets.clear();
+            targets.reserve(edges.size());
+            for (const auto& edge : edges)
+            {
+                ++offsets[edge.first + 1];
+                targets.push_back(edge.second);
+            }
+            for (size_t v = 0; v < vertexCount; ++v)
+                offsets[v + 1] += offsets[v];
+        }
+    }
+
+    unsigned int MembershipGraph::VertexFor(const std::wstring& dn)
+    {
+        auto inserted = byDn.emplace(Converters::ToLower(dn), static_cast<unsigned int>(dns.size()));
+        if (inserted.second)
+        {
+            dns.push_back(dn);
+            classes.emplace_back();
+            isGroup.push_back(0);
+        }
+        return inserted.first->second;
+    }
+
+    void MembershipGraph::Build(const std::vector<Entry>& entries)
+    {
+        dns.clear();
+        classes.clear();
+        isGroup.clear();
+        byDn.clear();
+        byAccount.clear();
+        primaryEdges = 0;
+        byDn.reserve(entries.size());
+
+        // Entries first, so vertex numbers follow the result order
+        std::unordered_map<std::wstring, unsigned int> bySid;
+        std::vector<unsigned int> entryVertex;
+        entryVertex.reserve(entries.size());
+        for (const auto& e : entries)
+        {
+            unsigned int v = VertexFor(e.dn);
+            entryVertex.push_back(v);
+
+            const std::vector<Value>* objectClass = Values(e, L"objectClass");
+            if (objectClass && !objectClass->empty())
+            {
+                classes[v] = objectClass->back();
+                for (const auto& oc : *objectClass)
+                {
+                    if (_wcsicmp(oc.c_str(), L"group") == 0)
+                        isGroup[v] = 1;
+                }
+            }
+            const std::vector<Value>* account = Values(e, L"sAMAccountName");
+            if (account && !account->empty())
+                byAccount[Converters::ToLower(account->front())] = v;
+            const std::vector<Value>* sid = Values(e, L"objectSid");
+            if (sid && !sid->empty())
+                bySid[sid->front()] = v;
+        }
+
+        std::vector<std::pair<unsigned int, unsigned int>> edges;     // (group, member)
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const Entry& e = entries[i];
+            unsigned int v = entryVertex[i];
+
+            if (const std::vector<Value>* members = Values(e, L"member"))
+            {
+                isGroup[v] = 1;
+                for (const auto& member : *members)
+                    edges.emplace_back(v, VertexFor(member));
+            }
+            if (const std::vector<Value>* memberOf = Values(e, L"memberOf"))
+            {
+                for (const auto& group : *memberOf)
+                {
+                    unsigned int g = VertexFor(group);
+                    isGroup[g] = 1;
+                    edges.emplace_back(g, v);
+                }
+            }
+
+            // The primary group is never listed in member/memberOf; it is the
+            // account's domain SID with primaryGroupID as the last RID
+            const std::vector<Value>* primary = Values(e, L"primaryGroupID");
+            const std::vector<Value>* sid = Values(e, L"objectSid");
+            if (primary && !primary->empty() && sid && !sid->empty())
+            {
+                size_t dash = sid->front().str().rfind(L'-');
+                auto group = dash == std::wstring::npos ? bySid.end() :
+                    bySid.find(sid->front().str().substr(0, dash + 1) + primary->front().str());
+                if (group != bySid.end() && group->second != v)
+                {
+                    edges.emplace_back(group->second, v);
+                    ++primaryEdges;
+                }
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        BuildCsr(edges, dns.size(), memberOffsets, memberTargets);
+
+        for (auto& edge : edges)
+            std::swap(edge.first, edge.second);
+        std::sort(edges.begin(), edges.end());
+        BuildCsr(edges, dns.size(), groupOffsets, groupTargets);
+    }
+
+    size_t MembershipGraph::GroupCount() const
+    {
+        return static_cast<size_t>(std::count(isGroup.begin(), isGroup.end(), 1));
+    }
+
+    unsigned int MembershipGraph::Find(const std::wstring& nameOrDn) const
+    {
+        std::wstring key = Converters::ToLower(nameOrDn);
+        auto dn = byDn.find(key);
+        if (dn != byDn.end())
+            return dn->second;
+        auto account = byAccount.find(key);
+        return account != byAccount.end() ? account->second : npos;
+    }
+
+    void MembershipGraph::Expand(unsigned int start, const std::vector<unsigned int>& offsets,
+        const std::vector<unsigned int>& targets, std::vector<Reach>& out) const
+    {
+        out.clear();
+        if (start >= dns.size())
+            return;
+
+        std::vector<char> seen(dns.size(), 0);
+        seen[start] = 1;
+        std::vector<unsigned int> frontier = { start }, next;
+        for (unsigned int depth = 1; !frontier.empty(); ++depth)
+        {
+            next.clear();
+            for (unsigned int v : frontier)
+            {
+                for (unsigned int e = offsets[v]; e < offsets[v + 1]; ++e)
+                {
+                    unsigned int w = targets[e];
+                    if (seen[w]) continue;
+                    seen[w] = 1;
+                    out.push_back({ w, depth, v });
+                    next.push_back(w);
+                }
+            }
+            frontier.swap(next);
+        }
+    }
+
+    std::vector<MembershipGraph::Reach> MembershipGraph::EffectiveMembers(unsigned int group) const
+    {
+        std::vector<Reach> reached;
+        Expand(group, memberOffsets, memberTargets, reached);
+        return reached;
+    }
+
+    std::vector<MembershipGraph::Reach> MembershipGraph::EffectiveGroups(unsigned int account) const
+    {
+        std::vector<Reach> reached;
+        Expand(account, groupOffsets, groupTargets, reached);
+        return reached;
+    }
+
+    std::vector<std::vector<unsigned int>> MembershipGraph::Cycles() const
+    {
+        // Tarjan's strongly connected components over group -> group edges,
+        // iterative so deep nesting cannot exhaust the stack
+        size_t n = dns.size();
+        std::vector<std::vector<unsigned int>> cycles;
+        std::vector<unsigned int> index(n, static_cast<unsigned int>(npos)), low(n, 0), stack;
+        std::vector<char> onStack(n, 0);
+        unsigned int counter = 0;
+
+        struct Frame
+        {
+            unsigned int vertex;
+            unsigned int edge;
+        };
+        std::vector<Frame> calls;
+
+        for (unsigned int s = 0; s < n; ++s)
+        {
+            if (!isGroup[s] || index[s] != npos)
+                continue;
+
+            index[s] = low[s] = counter++;
+            stack.push_back(s);
+            onStack[s] = 1;
+            calls.push_back({ s, memberOffsets[s] });
+
+            while (!calls.empty())
+            {
+                Frame& frame = calls.back();
+                unsigned int v = frame.vertex;
+                if (frame.edge < memberOffsets[v + 1])
+                {
+                    unsigned int w = memberTargets[frame.edge++];
+                    if (!isGroup[w])
+                        continue;
+                    if (index[w] == npos)
+                    {
+                        index[w] = low[w] = counter++;
+                        stack.push_back(w);
+                        onStack[w] = 1;
+                        calls.push_back({ w, memberOffsets[w] });
+                    }
+                    else if (onStack[w])
+                    {
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+
+                if (low[v] == index[v])
+                {
+                    std::vector<unsigned int> component;
+                    unsigned int w;
+                    do
+                    {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = 0;
+                        component.push_back(w);
+                    } while (w != v);
+
+                    bool selfLoop = std::binary_search(memberTargets.begin() + memberOffsets[v],
+                        memberTargets.begin() + memberOffsets[v + 1], v);
+                    if (component.size() > 1 || selfLoop)
+                    {
+                        std::sort(component.begin(), component.end());
+                        cycles.push_back(std::move(component));
+                    }
+                }
+                calls.pop_back();
+                if (!calls.empty())
+                    low[calls.back().vertex] = std::min(low[calls.back().vertex], low[v]);
+            }
+        }
+        return cycles;
+    }
+
+    std::vector<MembershipGraph::GroupSummary> MembershipGraph::Summarize(unsigned int threadCount) const
+    {
+        std::vector<GroupSummary> summaries;
+        for (unsigned int v = 0; v < dns.size(); ++v)
+        {
+            if (!isGroup[v]) continue;
+            GroupSummary summary;
+            summary.vertex = v;
+            summary.directMembers = memberOffsets[v + 1] - memberOffsets[v];
+            summaries.push_back(summary);
+        }
+
+        for (const auto& cycle : Cycles())
+        {
+            for (unsigned int v : cycle)
+            {
+                auto it = std::lower_bound(summaries.begin(), summaries.end(), v,
+                    [](const GroupSummary& s, unsigned int vertex) { return s.vertex < vertex; });
+                if (it != summaries.end() && it->vertex == v)
+                    it->inCycle = true;
+            }
+        }
+
+        // Independent breadth-first searches; each worker stamps its visited
+        // array with a per-search number instead of clearing it
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, std::max<size_t>(1, summaries.size() / 64)));
+
+        std::atomic<size_t> nextGroup(0);
+        auto worker = [&]()
+        {
+            std::vector<unsigned int> stamp(dns.size(), 0);
+            std::vector<unsigned int> frontier, next;
+            unsigned int search = 0;
+            const size_t batch = 16;
+
+            for (size_t begin = nextGroup.fetch_add(batch); begin < summaries.size(); begin = nextGroup.fetch_add(batch))
+            {
+                for (size_t i = begin; i < std::min(summaries.size(), begin + batch); ++i)
+                {
+                    GroupSummary& summary = summaries[i];
+                    ++search;
+                    stamp[summary.vertex] = search;
+                    frontier.assign(1, summary.vertex);
+                    for (unsigned int depth = 1; !frontier.empty(); ++depth)
+                    {
+                        next.clear();
+                        for (unsigned int v : frontier)
+                        {
+                            for (unsigned int e = memberOffsets[v]; e < memberOffsets[v + 1]; ++e)
+                            {
+                                unsigned int w = memberTargets[e];
+                                if (stamp[w] == search) continue;
+                                stamp[w] = search;
+                                next.push_back(w);
+                                ++summary.effectiveMembers;
+                                if (!isGroup[w]) ++summary.effectiveAccounts;
+                                summary.nestingDepth = depth;
+                            }
+                        }
+                        frontier.swap(next);
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned int t = 1; t < threadCount; ++t)
+            workers.emplace_back(worker);
+        worker();
+        for (auto& w : workers)
+            w.join();
+        return summaries;
+    }
+
+    std::vector<Entry> MembershipGraph::ReachReport(const std::vector<Reach>& reached) const
+    {
+        std::vector<Entry> rows;
+        rows.reserve(reached.size());
+        for (const auto& r : reached)
+        {
+            Entry row;
+            row.dn = dns[r.vertex];
+            row.attrs[L"depth"] = { std::to_wstring(r.depth) };
+            row.attrs[L"via"] = { dns[r.via] };
+            row.attrs[L"objectClass"] = { classes[r.vertex].empty() ? L"(not in result set)" : classes[r.vertex] };
+            rows.push_back(std::move(row));
+        }
+        return rows;
+    }
+
+    std::vector<Entry> MembershipGraph::SummaryReport(const std::vector<GroupSummary>& summaries) const
+    {
+        std::vector<Entry> rows;
+        rows.reserve(summaries.size());
+        for (const auto& s : summaries)
+        {
+            Entry row;
+            row.dn = dns[s.vertex];
+            row.attrs[L"directMembers"] = { std::to_wstring(s.directMembers) };
+            row.attrs[L"effectiveMembers"] = { std::to_wstring(s.effectiveMembers) };
+            row.attrs[L"effectiveAccounts"] = { std::to_wstring(s.effectiveAccounts) };
+            row.attrs[L"nestingDepth"] = { std::to_wstring(s.nestingDepth) };
+            row.attrs[L"inCycle"] = { s.inCycle ? L"yes" : L"no" };
+            rows.push_back(std::move(row));
+        }
+        return rows;
+    }
+
+    void MembershipGraph::PrintReach(const std::wstring& title, const std::vector<Reach>& reached) const
+    {
+        size_t groups = 0;
+        unsigned int deepest = 0;
+        for (const auto& r : reached)
+        {
+            if (isGroup[r.vertex]) ++groups;
+            deepest = std::max(deepest, r.depth);
+        }
+
+        std::wcout << L"\n👥 " << title << L": " << reached.size() << L" (" << reached.size() - groups << L" accounts, "
+            << groups << L" groups, depth " << deepest << L")" << std::endl;
+        for (const auto& r : reached)
+        {
+            std::wcout << L"  " << std::setw(3) << std::right << r.depth << L"  " << std::setw(22) << std::left
+                << (classes[r.vertex].empty() ? L"?" : classes[r.vertex]) << dns[r.vertex];
+            if (r.depth > 1)
+                std::wcout << L"  (via " << dns[r.via] << L")";
+            std::wcout << std::endl;
+        }
+    }
+
+    void MembershipGraph::PrintSummary(const std::vector<GroupSummary>& summaries,
+        const std::vector<std::vector<unsigned int>>& cycles, size_t top) const
+    {
+        std::wcout << L"\n🕸️  Group Membership Graph:" << std::endl;
+        std::wcout << L"  Vertices: " << dns.size() << L", groups: " << summaries.size() << L", edges: "
+            << memberTargets.size() << L" (" << primaryEdges << L" primary group)" << std::endl;
+
+        std::vector<const GroupSummary*> largest;
+        for (const auto& s : summaries)
+            largest.push_back(&s);
+        size_t shown = std::min(top, largest.size());
+        std::partial_sort(largest.begin(), largest.begin() + shown, largest.end(),
+            [](const GroupSummary* a, const GroupSummary* b) { return a->effectiveMembers > b->effectiveMembers; });
+
+        std::wcout << L"\n  Largest effective memberships (direct / effective / accounts / depth):" << std::endl;
+        for (size_t i = 0; i < shown; ++i)
+        {
+            const GroupSummary& s = *largest[i];
+            std::wcout << L"  " << std::setw(6) << std::right << s.directMembers << std::setw(8) << s.effectiveMembers
+                << std::setw(8) << s.effectiveAccounts << std::setw(4) << s.nestingDepth << L"  " << dns[s.vertex]
+                << (s.inCycle ? L"  ⟲" : L"") << std::endl;
+        }
+
+        std::wcout << L"\n  Nesting cycles: " << cycles.size() << std::endl;
+        for (const auto& cycle : cycles)
+        {
+            std::wcout << L"  ⟲";
+            for (unsigned int v : cycle)
+                std::wcout << L" " << dns[v] << L";";
+            std::wcout << std::endl;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "LDAPTypes.h"
+#include <unordered_map>
+
+namespace LDAPUtils
+{
+    // Group membership as a directed graph (group -> member) built from the
+    // member, memberOf and primaryGroupID attributes of a result set. Edges are
+    // kept in CSR form in both directions, so expanding a group or an account is
+    // a walk over two flat arrays. DNs referenced but not present in the result
+    // set become vertices too, so the closure covers everything that is known.
+    class MembershipGraph
+    {
+    public:
+        static const unsigned int npos = static_cast<unsigned int>(-1);
+
+        struct Reach
+        {
+            unsigned int vertex;
+            unsigned int depth;     // 1 = direct
+            unsigned int via;       // Vertex the edge came from (the expanded one at depth 1)
+        };
+
+        struct GroupSummary
+        {
+            unsigned int vertex = 0;
+            size_t directMembers = 0;
+            size_t effectiveMembers = 0;    // Every vertex reachable through nesting
+            size_t effectiveAccounts = 0;   // Of those, the ones that are not groups
+            unsigned int nestingDepth = 0;  // Deepest level a member is first reached at
+            bool inCycle = false;
+        };
+
+    private:
+        std::vector<std::wstring> dns;
+        std::vector<std::wstring> classes;          // Most specific objectClass, empty outside the result set
+        std::vector<char> isGroup;
+        std::vector<unsigned int> memberOffsets;    // CSR: group -> direct members
+        std::vector<unsigned int> memberTargets;
+        std::vector<unsigned int> groupOffsets;     // CSR: member -> direct groups
+        std::vector<unsigned int> groupTargets;
+        std::unordered_map<std::wstring, unsigned int> byDn;        // Lower-cased DN
+        std::unordered_map<std::wstring, unsigned int> byAccount;   // Lower-cased sAMAccountName
+        size_t primaryEdges = 0;
+
+        unsigned int VertexFor(const std::wstring& dn);
+        void Expand(unsigned int start, const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& targets,
+            std::vector<Reach>& out) const;
+
+    public:
+        void Build(const std::vector<Entry>& entries);
+
+        size_t VertexCount() const { return dns.size(); }
+        size_t EdgeCount() const { return memberTargets.size(); }
+        size_t PrimaryGroupEdges() const { return primaryEdges; }
+        size_t GroupCount() const;
+
+        const std::wstring& Dn(unsigned int vertex) const { return dns[vertex]; }
+        const std::wstring& ObjectClass(unsigned int vertex) const { return classes[vertex]; }
+        bool IsGroup(unsigned int vertex) const { return isGroup[vertex] != 0; }
+
+        // By DN or sAMAccountName, case-insensitive; npos if unknown
+        unsigned int Find(const std::wstring& nameOrDn) const;
+
+        // Breadth-first: every effective member of a group, or every group an
+        // account is effectively in, each at the depth it is first reached
+        std::vector<Reach> EffectiveMembers(unsigned int group) const;
+        std::vector<Reach> EffectiveGroups(unsigned int account) const;
+
+        // Strongly connected groups (nesting loops), each as a list of vertices
+        std::vector<std::vector<unsigned int>> Cycles() const;
+
+        // Closure of every group, one breadth-first search per group spread over
+        // threadCount threads (0 = all cores)
+        std::vector<GroupSummary> Summarize(unsigned int threadCount = 0) const;
+
+        // Report rows shaped as entries, so every export format applies
+        std::vector<Entry> ReachReport(const std::vector<Reach>& reached) const;
+        std::vector<Entry> SummaryReport(const std::vector<GroupSummary>& summaries) const;
+
+        void PrintReach(const std::wstring& title, const std::vector<Reach>& reached) const;
+        void PrintSummary(const std::vector<GroupSummary>& summaries, const std::vector<std::vector<unsigned int>>& cycles,
+            size_t top = 20) const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+﻿#include "LDAPLdif.h"
+#include "LDAPConverters.h"
+#include "LDAPSchema.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <set>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        bool IsPrintableUtf8(const std::string& bytes)
+        {
+            for (unsigned char c : bytes)
+            {
+                if (c < 0x20 && c != '\t' && c != '\r' && c != '\n')
+                    return false;
+            }
+            return true;
+        }
+
+        // ldifde -u writes UTF-16LE; everything else is UTF-8
+        std::string ReadAsUtf8(std::ifstream& file)
+        {
+            std::string raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (raw.size() >= 2 && static_cast<unsigned char>(raw[0]) == 0xFF && static_cast<unsigned char>(raw[1]) == 0xFE)
+            {
+                std::wstring wide;
+                for (size_t i = 2; i + 1 < raw.size(); i += 2)
+                    wide += static_cast<wchar_t>(static_cast<unsigned char>(raw[i]) | (static_cast<unsigned char>(raw[i + 1]) << 8));
+                return Converters::WStringToUtf8(wide);
+            }
+            if (raw.size() >= 3 && raw.compare(0, 3, "\xEF\xBB\xBF") == 0)
+                raw.erase(0, 3);
+            return raw;
+        }
+    }
+
+    bool LdifReader::Load(const std::wstring& filename, std::vector<Entry>& outEntries,
+        std::vector<std::wstring>& outAttributeNames)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::wcerr << L"Failed to open LDIF file: " << filename << std::endl;
+            return false;
+        }
+
+        std::istringstream content(ReadAsUtf8(file));
+        std::vector<Entry> entries;
+        std::set<std::wstring> names;
+        Entry current;
+        bool inEntry = false;
+        size_t lineNumber = 0;
+
+        auto flush = [&]()
+        {
+            if (inEntry)
+                entries.push_back(std::move(current));
+            current = Entry();
+            inEntry = false;
+        };
+
+        // Unfold continuation lines (leading single space) before parsing each record line
+        std::string line, logical;
+        auto processLogical = [&](const std::string& text) -> bool
+        {
+            if (text.empty() || text[0] == '#')
+                return true;
+
+            size_t colon = text.find(':');
+            if (colon == std::string::npos)
+            {
+                std::wcerr << L"LDIF line " << lineNumber << L": missing ':'" << std::endl;
+                return false;
+            }
+
+            std::wstring name = Converters::StringToWString(text.substr(0, colon));
+            bool base64 = colon + 1 < text.size() && text[colon + 1] == ':';
+            size_t valueStart = colon + (base64 ? 2 : 1);
+            while (valueStart < text.size() && text[valueStart] == ' ') ++valueStart;
+            std::string rawValue = text.substr(valueStart);
+
+            std::string bytes = rawValue;
+            if (base64 && !Converters::DecodeBase64(rawValue, bytes))
+            {
+                std::wcerr << L"LDIF line " << lineNumber << L": invalid base64 value" << std::endl;
+                return false;
+            }
+
+            if (name == L"version" && !inEntry)
+                return true;
+            if (name == L"dn")
+            {
+                flush();
+                current.dn = Converters::StringToWString(bytes);
+                inEntry = true;
+                return true;
+            }
+            if (!inEntry || name == L"changetype")
+                return true;
+
+            // Binary values keep their bytes so GUIDs and SIDs are decoded like live results
+            bool binary = base64 && !IsPrintableUtf8(bytes);
+            std::wstring text16 = binary ? std::wstring() : Converters::StringToWString(bytes);
+            std::vector<wchar_t> valueBuffer(text16.begin(), text16.end());
+            valueBuffer.push_back(L'\0');
+            berval bval{ static_cast<unsigned long>(bytes.size()), const_cast<char*>(bytes.data()) };
+
+            current.attrs[name].push_back(Converters::DecodeAttributeValue(Schema::Active().KindOf(name),
+                valueBuffer.data(), base64 ? &bval : nullptr));
+            names.insert(name);
+            return true;
+        };
+
+        while (std::getline(content, line))
+        {
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            if (!line.empty() && line[0] == ' ')
+            {
+                logical += line.substr(1);
+                continue;
+            }
+            if (!processLogical(logical))
+                return false;
+            logical = line;
+            if (line.empty())
+                flush();
+        }
+        if (!processLogical(logical))
+            return false;
+        flush();
+
+        outEntries = std::move(entries);
+        outAttributeNames.assign(names.begin(), names.end());
+        return true;
+    }
+}
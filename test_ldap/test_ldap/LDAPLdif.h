@@ -0,0 +1,15 @@
+#pragma once
+#include "LDAPTypes.h"
+
+namespace LDAPUtils
+{
+    // Reads LDIF content records (ldifde / ldapsearch output) into entries.
+    // Values are formatted the same way as live search results, so filters,
+    // statistics and exports treat both sources alike.
+    class LdifReader
+    {
+    public:
+        static bool Load(const std::wstring& filename, std::vector<Entry>& outEntries,
+            std::vector<std::wstring>& outAttributeNames);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+﻿#include "LDAPPaging.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        // Pages slower than this shrink regardless of throughput, keeping
+        // responses well inside the server's query time limits
+        const double kMaxPageMs = 10000;
+        // Throughput changes smaller than this are treated as noise
+        const double kNoise = 0.03;
+        // Smallest step; once reached at MaxPageSize the size stays put
+        const double kMinFactor = 1.1;
+        // Consecutive short pages of one size that reveal a server cap; a single
+        // short page is usually objects the caller may not read
+        const int kCapConfirmations = 2;
+    }
+
+    PageSizeTuner::PageSizeTuner(unsigned long initial, unsigned long maxPageSize, bool adaptive)
+        : adaptive(adaptive), maxPageSize(maxPageSize > 0 ? maxPageSize : kDefaultMaxPageSize)
+    {
+        current = static_cast<double>(std::max(1ul, initial));
+        if (adaptive)
+            current = std::min(std::max(current, static_cast<double>(kMinPageSize)), static_cast<double>(this->maxPageSize));
+    }
+
+    unsigned long PageSizeTuner::Next() const
+    {
+        return static_cast<unsigned long>(current + 0.5);
+    }
+
+    void PageSizeTuner::Record(const Page& page, bool more)
+    {
+        pages.push_back(page);
+        if (!adaptive || !more || page.returned == 0)
+            return;
+
+        // Non-final pages shorter than asked for, repeatedly of the same size,
+        // mean the server caps them; lower the ceiling to that size
+        if (page.returned < page.requested)
+        {
+            shortPages = page.returned == shortReturned ? shortPages + 1 : 1;
+            shortReturned = page.returned;
+            if (shortPages < kCapConfirmations)
+                return;
+            maxPageSize = std::max(page.returned, static_cast<unsigned long>(kMinPageSize));
+            current = std::min(current, static_cast<double>(maxPageSize));
+            growing = false;
+            lastThroughput = 0;
+            return;
+        }
+        shortPages = 0;
+
+        // Only a page of a different size says which way throughput is moving; at
+        // a bound the size repeats and the difference is just noise
+        double elapsed = std::max(page.serverMs + page.decodeMs, 0.001);
+        double throughput = page.returned / elapsed;
+        if (lastThroughput > 0 && page.requested != lastRequested && throughput < lastThroughput * (1.0 - kNoise))
+        {
+            growing = !growing;
+            factor = std::max(kMinFactor, std::sqrt(factor));
+        }
+        lastThroughput = throughput;
+        lastRequested = page.requested;
+        if (elapsed > kMaxPageMs)
+            growing = false;
+
+        // Pinned at MaxPageSize: probe smaller pages until the step has converged
+        if (growing && current >= maxPageSize && factor > kMinFactor)
+        {
+            growing = false;
+            factor = std::max(kMinFactor, std::sqrt(factor));
+        }
+
+        current = growing ? current * factor : current / factor;
+        current = std::min(std::max(current, static_cast<double>(kMinPageSize)), static_cast<double>(maxPageSize));
+    }
+
+    void PageSizeTuner::PrintPage(size_t index) const
+    {
+        const Page& page = pages[index];
+        std::wcout << L"  Page " << (index + 1) << L": " << page.returned << L"/" << page.requested
+            << L" entries, server " << std::fixed << std::setprecision(1) << page.serverMs << L" ms, decode "
+            << page.decodeMs << L" ms" << std::defaultfloat << std::endl;
+    }
+
+    void PageSizeTuner::PrintSummary() const
+    {
+        double serverMs = 0, decodeMs = 0;
+        unsigned long long entries = 0;
+        for (const auto& page : pages)
+        {
+            serverMs += page.serverMs;
+            decodeMs += page.decodeMs;
+            entries += page.returned;
+        }
+        double totalMs = serverMs + decodeMs;
+        std::wcout << L"Paging (";
+        if (adaptive)
+            std::wcout << L"adaptive, MaxPageSize " << maxPageSize;
+        else
+            std::wcout << L"fixed " << Next();
+        std::wcout << L"): " << pages.size() << L" pages, " << entries << L" entries, server " << std::fixed << std::setprecision(1)
+            << serverMs << L" ms, decode " << decodeMs << L" ms";
+        if (totalMs > 0)
+            std::wcout << L", " << std::setprecision(0) << (entries * 1000.0 / totalMs) << L" entries/s";
+        std::wcout << std::defaultfloat << std::endl;
+    }
+
+    unsigned long PageSizeTuner::ParseMaxPageSize(const std::vector<Value>& adminLimits)
+    {
+        const std::wstring key = L"maxpagesize=";
+        for (const auto& limit : adminLimits)
+        {
+            if (limit.size() <= key.size())
+                continue;
+            std::wstring name = limit.str().substr(0, key.size());
+            std::transform(name.begin(), name.end(), name.begin(), towlower);
+            if (name == key)
+                return wcstoul(limit.c_str() + key.size(), nullptr, 10);
+        }
+        return 0;
+    }
+}
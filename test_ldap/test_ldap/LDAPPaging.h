@@ -0,0 +1,53 @@
+#pragma once
+#include "LDAPValue.h"
+#include <string>
+#include <vector>
+
+namespace LDAPUtils
+{
+    // Picks the size of each paged-results request. Fixed mode always asks for the
+    // same size; adaptive mode hill-climbs on entries per second (server wait plus
+    // decode time), growing or shrinking multiplicatively and damping the step each
+    // time the direction flips, always within the server's MaxPageSize.
+    class PageSizeTuner
+    {
+    public:
+        struct Page
+        {
+            unsigned long requested = 0;
+            unsigned long returned = 0;
+            double serverMs = 0;        // Waiting for the response, transfer included
+            double decodeMs = 0;        // Decoding, statistics and console output
+        };
+
+        static const unsigned long kMinPageSize = 50;
+        static const unsigned long kDefaultMaxPageSize = 1000;   // AD's default MaxPageSize
+
+    private:
+        bool adaptive;
+        unsigned long maxPageSize;
+        double current;
+        double factor = 2.0;
+        bool growing = true;
+        double lastThroughput = 0;
+        unsigned long lastRequested = 0;
+        unsigned long shortReturned = 0;    // Size of the latest short page
+        int shortPages = 0;                 // Consecutive short pages of that size
+        std::vector<Page> pages;
+
+    public:
+        PageSizeTuner(unsigned long initial, unsigned long maxPageSize, bool adaptive);
+
+        unsigned long Next() const;
+        unsigned long MaxPageSize() const { return maxPageSize; }
+        // more: the server returned a cookie, i.e. this was not the last page
+        void Record(const Page& page, bool more);
+        const std::vector<Page>& Pages() const { return pages; }
+
+        void PrintPage(size_t index) const;
+        void PrintSummary() const;
+
+        // "MaxPageSize=1000" among the lDAPAdminLimits values of a query policy (0 = not found)
+        static unsigned long ParseMaxPageSize(const std::vector<Value>& adminLimits);
+    };
+}
\ No newline at end of file
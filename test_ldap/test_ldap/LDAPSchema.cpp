@@ -0,0 +1,311 @@
+﻿#include "LDAPSchema.h"
+#include "LDAPConnection.h"
+#include "LDAPConverters.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        const char* const kCacheHeader = "LDAPSCHEMA1";
+
+        // Large integers (2.5.5.16) holding FILETIME timestamps
+        const wchar_t* const kFileTimeAttributes[] = {
+            L"accountExpires", L"badPasswordTime", L"creationTime", L"lastLogoff", L"lastLogon",
+            L"lastLogonTimestamp", L"lockoutTime", L"pwdLastSet", L"msDS-LastFailedInteractiveLogonTime",
+            L"msDS-LastSuccessfulInteractiveLogonTime", L"msDS-UserPasswordExpiryTimeComputed"
+        };
+
+        // Timestamps and signatures decoded by name when the schema is not loaded
+        const wchar_t* const kTimeAttributes[] = { L"whenCreated", L"whenChanged" };
+        const wchar_t* const kLogonAttributes[] = { L"lastLogonTimestamp", L"lastLogon" };
+        const wchar_t* const kBinaryAttributes[] = { L"dSASignature" };
+
+        // Octet strings holding a binary GUID or SID, for when the schema is not
+        // loaded. Exact names: rightsGuid, for one, is a string in GUID form
+        const wchar_t* const kGuidAttributes[] = {
+            L"objectGUID", L"invocationId", L"schemaIDGUID", L"attributeSecurityGUID", L"netbootGUID",
+            L"mS-DS-ConsistencyGuid", L"msExchMailboxGuid", L"msExchArchiveGUID"
+        };
+        const wchar_t* const kSidAttributes[] = {
+            L"objectSid", L"sIDHistory", L"securityIdentifier", L"mS-DS-CreatorSID", L"tokenGroups",
+            L"tokenGroupsGlobalAndUniversal", L"tokenGroupsNoGCAcceptable", L"msExchMasterAccountSid"
+        };
+
+        // Bitmasks and codes DisplayValue names
+        const wchar_t* const kIntegerAttributes[] = {
+            L"instanceType", L"systemFlags", L"userAccountControl", L"groupType", L"sAMAccountType"
+        };
+
+        bool IsOneOf(const std::wstring& name, const wchar_t* const* names, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (_wcsicmp(name.c_str(), names[i]) == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        const std::wstring& First(const Entry& entry, const wchar_t* name)
+        {
+            static const std::wstring empty;
+            auto it = entry.attrs.find(name);
+            return it != entry.attrs.end() && !it->second.empty() ? it->second[0].str() : empty;
+        }
+
+        Schema& ActiveSchema()
+        {
+            static Schema active;
+            return active;
+        }
+    }
+
+    const AttributeType* Schema::Find(const std::wstring& name) const
+    {
+        auto it = attributes.find(name);
+        return it != attributes.end() ? &it->second : nullptr;
+    }
+
+    ValueKind Schema::KindOf(const std::wstring& name) const
+    {
+        const AttributeType* type = Find(name);
+        return type ? type->kind : KindByName(name);
+    }
+
+    ValueKind Schema::KindForSyntax(const std::wstring& name, const AttributeType& type)
+    {
+        if (type.syntax == L"2.5.5.9")                      // Integer, enumeration
+            return ValueKind::INTEGER;
+        if (type.syntax == L"2.5.5.16")                     // Large integer
+            return IsOneOf(name, kFileTimeAttributes, sizeof(kFileTimeAttributes) / sizeof(kFileTimeAttributes[0])) ?
+                ValueKind::FILETIME : ValueKind::INTEGER;
+        if (type.syntax == L"2.5.5.11")                     // Generalized time (24); UTC time (23) has a two-digit year
+            return type.omSyntax == 24 ? ValueKind::TIME : ValueKind::TEXT;
+        if (type.syntax == L"2.5.5.17")                     // SID
+            return ValueKind::SID;
+        if (type.syntax == L"2.5.5.10")                     // Octet string; GUIDs are exactly 16 bytes
+            return type.rangeLower == 16 && type.rangeUpper == 16 ? ValueKind::GUID : ValueKind::BINARY;
+        if (type.syntax == L"2.5.5.15")                     // NT security descriptor
+            return ValueKind::BINARY;
+        return ValueKind::TEXT;
+    }
+
+    ValueKind Schema::KindByName(const std::wstring& name)
+    {
+        if (IsOneOf(name, kTimeAttributes, sizeof(kTimeAttributes) / sizeof(kTimeAttributes[0])))
+            return ValueKind::TIME;
+        if (IsOneOf(name, kLogonAttributes, sizeof(kLogonAttributes) / sizeof(kLogonAttributes[0])))
+            return ValueKind::FILETIME;
+        if (IsOneOf(name, kGuidAttributes, sizeof(kGuidAttributes) / sizeof(kGuidAttributes[0])))
+            return ValueKind::GUID;
+        if (IsOneOf(name, kSidAttributes, sizeof(kSidAttributes) / sizeof(kSidAttributes[0])))
+            return ValueKind::SID;
+        if (IsOneOf(name, kIntegerAttributes, sizeof(kIntegerAttributes) / sizeof(kIntegerAttributes[0])))
+            return ValueKind::INTEGER;
+        if (IsOneOf(name, kBinaryAttributes, sizeof(kBinaryAttributes) / sizeof(kBinaryAttributes[0])))
+            return ValueKind::BINARY;
+        return ValueKind::TEXT;
+    }
+
+    bool Schema::Read(LDAPConnection& connection)
+    {
+        SearchConfig query;
+        query.baseDN = namingContext;
+        query.filter = L"(objectClass=attributeSchema)";
+        query.attributesStr = L"lDAPDisplayName,attributeSyntax,oMSyntax,isSingleValued,rangeLower,rangeUpper,whenChanged";
+        query.sizeLimit = 0;
+        query.quiet = true;
+        query.collectEntries = true;
+
+        std::vector<Entry> entries;
+        Statistics stats;
+        if (!connection.Search(query, entries, stats))
+            return false;
+
+        attributes.clear();
+        lastChange.clear();
+        for (const auto& entry : entries)
+        {
+            const std::wstring& name = First(entry, L"lDAPDisplayName");
+            if (name.empty())
+                continue;
+            AttributeType type;
+            type.syntax = First(entry, L"attributeSyntax");
+            type.omSyntax = _wtoi(First(entry, L"oMSyntax").c_str());
+            type.singleValued = _wcsicmp(First(entry, L"isSingleValued").c_str(), L"TRUE") == 0;
+            type.rangeLower = wcstoul(First(entry, L"rangeLower").c_str(), nullptr, 10);
+            type.rangeUpper = wcstoul(First(entry, L"rangeUpper").c_str(), nullptr, 10);
+            type.kind = KindForSyntax(name, type);
+            attributes[name] = type;
+
+            // Generalized times of equal length order as strings
+            const std::wstring& changed = First(entry, L"whenChanged");
+            if (changed > lastChange)
+                lastChange = changed;
+        }
+        return !attributes.empty();
+    }
+
+    bool Schema::Load(LDAPConnection& connection, const std::wstring& cacheFile, Schema& outSchema, bool& outFromCache)
+    {
+        outFromCache = false;
+        Entry rootDse;
+        if (!connection.SearchByDN(L"", rootDse))
+        {
+            std::wcerr << L"Failed to read the rootDSE" << std::endl;
+            return false;
+        }
+        std::wstring namingContext = First(rootDse, L"schemaNamingContext");
+        if (namingContext.empty())
+        {
+            std::wcerr << L"The server does not publish a schemaNamingContext" << std::endl;
+            return false;
+        }
+
+        Schema cached;
+        if (!cacheFile.empty() && LoadCache(cacheFile, cached) &&
+            _wcsicmp(cached.namingContext.c_str(), namingContext.c_str()) == 0 && !cached.lastChange.empty())
+        {
+            // Any attributeSchema object changed after the cache was written makes it stale
+            SearchConfig probe;
+            probe.baseDN = namingContext;
+            probe.filter = L"(&(objectClass=attributeSchema)(!(whenChanged<=" + cached.lastChange + L")))";
+            probe.attributesStr = L"whenChanged";
+            probe.sizeLimit = 1;
+            probe.quiet = true;
+            probe.collectEntries = true;
+
+            std::vector<Entry> changed;
+            Statistics stats;
+            if (connection.Search(probe, changed, stats) && changed.empty())
+            {
+                outSchema = std::move(cached);
+                outFromCache = true;
+                return true;
+            }
+        }
+
+        Schema schema;
+        schema.namingContext = namingContext;
+        if (!schema.Read(connection))
+        {
+            std::wcerr << L"Failed to read the schema from " << namingContext << std::endl;
+            return false;
+        }
+        if (!cacheFile.empty())
+            schema.SaveCache(cacheFile);
+        outSchema = std::move(schema);
+        return true;
+    }
+
+    bool Schema::LoadCache(const std::wstring& filename, Schema& outSchema)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        std::string line;
+        if (!std::getline(file, line) || line != kCacheHeader)
+        {
+            std::wcerr << L"Not a schema cache: " << filename << std::endl;
+            return false;
+        }
+
+        Schema schema;
+        std::string namingContext, lastChange;
+        if (!std::getline(file, namingContext) || !std::getline(file, lastChange))
+            return false;
+        schema.namingContext = Converters::StringToWString(namingContext);
+        schema.lastChange = Converters::StringToWString(lastChange);
+
+        while (std::getline(file, line))
+        {
+            if (line.empty())
+                continue;
+            std::istringstream fields(line);
+            std::string name, syntax, omSyntax, single, rangeLower, rangeUpper;
+            if (!std::getline(fields, name, '\t') || !std::getline(fields, syntax, '\t') ||
+                !std::getline(fields, omSyntax, '\t') || !std::getline(fields, single, '\t') ||
+                !std::getline(fields, rangeLower, '\t') || !std::getline(fields, rangeUpper))
+            {
+                std::wcerr << L"Damaged schema cache: " << filename << std::endl;
+                return false;
+            }
+
+            AttributeType type;
+            std::wstring attrName = Converters::StringToWString(name);
+            type.syntax = Converters::StringToWString(syntax);
+            type.omSyntax = atoi(omSyntax.c_str());
+            type.singleValued = single == "1";
+            type.rangeLower = strtoul(rangeLower.c_str(), nullptr, 10);
+            type.rangeUpper = strtoul(rangeUpper.c_str(), nullptr, 10);
+            type.kind = KindForSyntax(attrName, type);
+            schema.attributes[attrName] = type;
+        }
+
+        outSchema = std::move(schema);
+        return true;
+    }
+
+    bool Schema::SaveCache(const std::wstring& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::wcerr << L"Failed to write schema cache: " << filename << std::endl;
+            return false;
+        }
+
+        file << kCacheHeader << "\n"
+            << Converters::WStringToUtf8(namingContext) << "\n"
+            << Converters::WStringToUtf8(lastChange) << "\n";
+        for (const auto& attribute : attributes)
+        {
+            const AttributeType& type = attribute.second;
+            file << Converters::WStringToUtf8(attribute.first) << '\t' << Converters::WStringToUtf8(type.syntax) << '\t'
+                << type.omSyntax << '\t' << (type.singleValued ? 1 : 0) << '\t'
+                << type.rangeLower << '\t' << type.rangeUpper << "\n";
+        }
+        return file.good();
+    }
+
+    void Schema::Activate(LDAPConnection* connection, const SearchConfig& config, bool verbose)
+    {
+        if (!config.loadSchema)
+            return;
+
+        Schema schema;
+        bool fromCache = true;
+        bool loaded = connection ? Load(*connection, config.schemaCacheFile, schema, fromCache) :
+            !config.schemaCacheFile.empty() && LoadCache(config.schemaCacheFile, schema);
+        if (!loaded)
+        {
+            if (connection)
+                std::wcerr << L"Schema not available; decoding values by attribute name" << std::endl;
+            return;
+        }
+
+        SetActive(schema);
+        if (verbose)
+        {
+            std::wcout << L"✓ Schema: " << schema.Size() << L" attribute types ";
+            if (fromCache)
+                std::wcout << L"(cached in " << config.schemaCacheFile << L")" << std::endl;
+            else
+                std::wcout << L"(read from " << schema.NamingContext() << L")" << std::endl;
+        }
+    }
+
+    const Schema& Schema::Active()
+    {
+        return ActiveSchema();
+    }
+
+    void Schema::SetActive(const Schema& schema)
+    {
+        ActiveSchema() = schema;
+    }
+}
\ No newline at end of file
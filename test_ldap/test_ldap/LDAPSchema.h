@@ -0,0 +1,69 @@
+#pragma once
+#include "LDAPTypes.h"
+#include "LDAPStatistics.h"
+#include <unordered_map>
+
+namespace LDAPUtils
+{
+    class LDAPConnection;
+
+    // An attributeSchema object, as far as decoding its values needs it
+    struct AttributeType
+    {
+        std::wstring syntax;            // attributeSyntax, e.g. 2.5.5.9 (integer)
+        int omSyntax = 0;               // oMSyntax, e.g. 65 (large integer)
+        bool singleValued = false;      // isSingleValued
+        unsigned long rangeLower = 0;   // Octet strings: size bounds in bytes (0 = unbounded)
+        unsigned long rangeUpper = 0;
+        ValueKind kind = ValueKind::TEXT;   // How values are decoded and stored, from the above
+    };
+
+    // Attribute types of the forest, read from the schema naming context once and
+    // kept in a cache file until an attributeSchema object changes. Searches and
+    // LDIF imports decode each attribute by the kind its syntax gives; attributes
+    // the schema does not list fall back to the well-known names (KindByName).
+    class Schema
+    {
+    private:
+        std::wstring namingContext;     // schemaNamingContext it was read from
+        std::wstring lastChange;        // Latest whenChanged among its attributeSchema objects
+        std::unordered_map<std::wstring, AttributeType, CaseInsensitiveHash, CaseInsensitiveEqual> attributes;
+
+        bool Read(LDAPConnection& connection);
+
+    public:
+        size_t Size() const { return attributes.size(); }
+        const std::wstring& NamingContext() const { return namingContext; }
+        // nullptr when the attribute is not in the schema
+        const AttributeType* Find(const std::wstring& name) const;
+        // Storage kind of an attribute: from its syntax when known, else by name
+        ValueKind KindOf(const std::wstring& name) const;
+
+        // Kind for a syntax; timestamps kept as integers (pwdLastSet, lastLogon, ...)
+        // are only recognizable by name, the schema calls them large integers
+        static ValueKind KindForSyntax(const std::wstring& name, const AttributeType& type);
+        // Kind of the attributes decoded specially before schemas were read, by
+        // exact name; only for attributes the schema does not list
+        static ValueKind KindByName(const std::wstring& name);
+
+        // Schema of the connected forest: from cacheFile when it is for the same
+        // schema naming context and no attributeSchema object changed since it was
+        // written, otherwise read from the server and written to cacheFile (when
+        // not empty). outFromCache tells which
+        static bool Load(LDAPConnection& connection, const std::wstring& cacheFile, Schema& outSchema,
+            bool& outFromCache);
+
+        // Cache file: UTF-8 text, a header line, the naming context and last change,
+        // then "name<TAB>syntax<TAB>oMSyntax<TAB>single<TAB>rangeLower<TAB>rangeUpper"
+        static bool LoadCache(const std::wstring& filename, Schema& outSchema);
+        bool SaveCache(const std::wstring& filename) const;
+
+        // Makes the schema config asks for (loadSchema, schemaCacheFile) active:
+        // loaded through connection, or only from the cache file when connection is
+        // null (offline LDIF). Without one, values are decoded by attribute name
+        static void Activate(LDAPConnection* connection, const SearchConfig& config, bool verbose);
+
+        static const Schema& Active();
+        static void SetActive(const Schema& schema);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,468 @@
+﻿#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "LDAPService.h"
+#include "LDAPConverters.h"
+#include "LDAPExporter.h"
+#include "LDAPSchema.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        std::wstring UrlDecode(const std::string& encoded)
+        {
+            std::string bytes;
+            for (size_t i = 0; i < encoded.size(); ++i)
+            {
+                char c = encoded[i];
+                if (c == '+')
+                {
+                    bytes += ' ';
+                }
+                else if (c == '%' && i + 2 < encoded.size() && isxdigit((unsigned char)encoded[i + 1]) &&
+                    isxdigit((unsigned char)encoded[i + 2]))
+                {
+                    bytes += static_cast<char>(strtol(encoded.substr(i + 1, 2).c_str(), nullptr, 16));
+                    i += 2;
+                }
+                else
+                {
+                    bytes += c;
+                }
+            }
+            return Converters::StringToWString(bytes);
+        }
+
+        std::map<std::wstring, std::wstring> ParseQueryString(const std::string& query)
+        {
+            std::map<std::wstring, std::wstring> params;
+            std::stringstream ss(query);
+            std::string pair;
+            while (std::getline(ss, pair, '&'))
+            {
+                size_t eq = pair.find('=');
+                if (eq == std::string::npos)
+                    params[UrlDecode(pair)] = L"";
+                else
+                    params[UrlDecode(pair.substr(0, eq))] = UrlDecode(pair.substr(eq + 1));
+            }
+            return params;
+        }
+
+        const char* StatusText(int status)
+        {
+            switch (status)
+            {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 503: return "Service Unavailable";
+            default: return "Bad Gateway";
+            }
+        }
+
+        void SendAll(SOCKET client, const std::string& data)
+        {
+            size_t sent = 0;
+            while (sent < data.size())
+            {
+                int chunk = static_cast<int>(std::min<size_t>(data.size() - sent, 1 << 20));
+                int n = send(client, data.data() + sent, chunk, 0);
+                if (n == SOCKET_ERROR || n == 0) return;
+                sent += static_cast<size_t>(n);
+            }
+        }
+    }
+
+    QueryCache::QueryCache(std::chrono::seconds ttl, size_t capacity)
+        : ttl(ttl), capacity(capacity == 0 ? 1 : capacity)
+    {
+    }
+
+    std::wstring QueryCache::MakeKey(const SearchConfig& config)
+    {
+        // Fields are separated by a character that cannot appear in DNs or filters
+        std::wstringstream key;
+        key << config.baseDN << L'\x1f' << config.scope << L'\x1f' << config.filter << L'\x1f'
+            << Converters::ToLower(config.attributesStr) << L'\x1f' << config.sizeLimit << L'\x1f'
+            << config.sortKeys << L'\x1f' << config.windowOffset << L'\x1f' << config.windowSize;
+        return key.str();
+    }
+
+    std::shared_ptr<const CachedResult> QueryCache::Find(const std::wstring& key)
+    {
+        auto it = slots.find(key);
+        if (it == slots.end())
+            return nullptr;
+        if (std::chrono::steady_clock::now() - it->second.stored > ttl)
+        {
+            lru.erase(it->second.lruPosition);
+            slots.erase(it);
+            return nullptr;
+        }
+
+        lru.splice(lru.begin(), lru, it->second.lruPosition);
+        return it->second.result;
+    }
+
+    void QueryCache::Store(const std::wstring& key, std::shared_ptr<const CachedResult> result)
+    {
+        auto it = slots.find(key);
+        if (it != slots.end())
+        {
+            lru.erase(it->second.lruPosition);
+            slots.erase(it);
+        }
+
+        while (slots.size() >= capacity && !lru.empty())
+        {
+            slots.erase(lru.back());
+            lru.pop_back();
+        }
+
+        lru.push_front(key);
+        slots[key] = { std::move(result), std::chrono::steady_clock::now(), lru.begin() };
+    }
+
+    std::shared_ptr<const CachedResult> QueryCache::Fetch(const std::wstring& key,
+        const std::function<std::shared_ptr<const CachedResult>()>& fetch, bool& outHit)
+    {
+        std::promise<std::shared_ptr<const CachedResult>> promise;
+        std::shared_future<std::shared_ptr<const CachedResult>> running;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<const CachedResult> cached = Find(key);
+            if (cached)
+            {
+                ++hits;
+                outHit = true;
+                return cached;
+            }
+            auto it = inFlight.find(key);
+            if (it != inFlight.end())
+            {
+                // Waiting on another request's search costs the DC nothing, like a hit
+                ++hits;
+                running = it->second;
+            }
+            else
+            {
+                ++misses;
+                inFlight.emplace(key, promise.get_future().share());
+            }
+        }
+
+        if (running.valid())
+        {
+            outHit = true;
+            return running.get();
+        }
+
+        outHit = false;
+        std::shared_ptr<const CachedResult> result = fetch();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (result)
+                Store(key, result);
+            inFlight.erase(key);
+        }
+        promise.set_value(result);
+        return result;
+    }
+
+    void QueryCache::GetCounters(size_t& outHits, size_t& outMisses, size_t& outSize)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        outHits = hits;
+        outMisses = misses;
+        outSize = slots.size();
+    }
+
+    QueryService::QueryService(const SearchConfig& defaults, std::chrono::seconds ttl, size_t cacheCapacity)
+        : defaults(defaults), cache(ttl, cacheCapacity)
+    {
+    }
+
+    std::string QueryService::HandleSearch(const std::map<std::wstring, std::wstring>& params, int& outStatus,
+        std::string& outContentType, bool& outCacheHit)
+    {
+        SearchConfig query = defaults;
+        query.outputFile.clear();
+        query.format = OutputFormat::CONSOLE_ONLY;
+        query.searchMode = SearchMode::STANDARD;
+        query.quiet = true;
+        query.collectEntries = true;
+
+        std::wstring format = L"ndjson";
+        for (const auto& param : params)
+        {
+            if (param.first == L"base") query.baseDN = param.second;
+            else if (param.first == L"filter") query.filter = param.second;
+            else if (param.first == L"attrs") query.attributesStr = param.second.empty() ? L"*" : param.second;
+            else if (param.first == L"limit") query.sizeLimit = wcstoul(param.second.c_str(), nullptr, 10);
+            else if (param.first == L"sort") query.sortKeys = param.second;
+            else if (param.first == L"window")
+            {
+                if (!LDAPConnection::ParseWindow(param.second, query))
+                {
+                    outStatus = 400;
+                    return "window must be <first>-<last>\n";
+                }
+            }
+            else if (param.first == L"format") format = Converters::ToLower(param.second);
+            else if (param.first == L"values")
+            {
+                if (param.second == L"display") query.valueStyle = ValueStyle::DISPLAY;
+                else if (param.second == L"raw") query.valueStyle = ValueStyle::RAW;
+                else
+                {
+                    outStatus = 400;
+                    return "values must be display or raw\n";
+                }
+            }
+            else if (param.first == L"scope")
+            {
+                if (param.second == L"base") query.scope = 0;
+                else if (param.second == L"one") query.scope = 1;
+                else if (param.second == L"sub") query.scope = 2;
+                else
+                {
+                    outStatus = 400;
+                    return "scope must be base, one or sub\n";
+                }
+            }
+        }
+
+        if (format != L"ndjson" && format != L"csv")
+        {
+            outStatus = 400;
+            return "format must be ndjson or csv\n";
+        }
+
+        std::wstring key = QueryCache::MakeKey(query);
+        std::shared_ptr<const CachedResult> result = cache.Fetch(key, [&]() -> std::shared_ptr<const CachedResult>
+        {
+            auto fresh = std::make_shared<CachedResult>();
+            Statistics stats;
+            LDAPConnection* connection = pool.Acquire();
+            bool ok = connection->Search(query, fresh->entries, stats);
+            if (!ok)
+            {
+                // The server may have dropped the connection while it sat idle;
+                // bind a new one and try once more
+                fresh->entries.clear();
+                connection = pool.Reconnect(connection);
+                ok = connection->Search(query, fresh->entries, stats);
+            }
+            pool.Release(connection);
+            if (!ok)
+                return nullptr;
+
+            if (query.attributesStr == L"*")
+            {
+                fresh->attributes = Exporter::AttributeNames(fresh->entries);
+            }
+            else
+            {
+                std::wstringstream ss(query.attributesStr);
+                std::wstring attr;
+                while (std::getline(ss, attr, L','))
+                {
+                    attr.erase(0, attr.find_first_not_of(L" \t"));
+                    attr.erase(attr.find_last_not_of(L" \t") + 1);
+                    if (!attr.empty()) fresh->attributes.push_back(attr);
+                }
+            }
+            return fresh;
+        }, outCacheHit);
+
+        if (!result)
+        {
+            outStatus = 502;
+            return "LDAP search failed\n";
+        }
+
+        // Cached entries hold stored values; each response renders them for its format
+        std::ostringstream body;
+        if (format == L"csv")
+        {
+            outContentType = "text/csv; charset=utf-8";
+            Exporter::WriteCsv(body, result->attributes, result->entries,
+                query.valueStyle == ValueStyle::AUTO ? ValueStyle::DISPLAY : query.valueStyle);
+        }
+        else
+        {
+            outContentType = "application/x-ndjson; charset=utf-8";
+            Exporter::WriteNdjson(body, result->entries,
+                query.valueStyle == ValueStyle::AUTO ? ValueStyle::RAW : query.valueStyle);
+        }
+        outStatus = 200;
+        return body.str();
+    }
+
+    void QueryService::HandleClient(uintptr_t clientHandle)
+    {
+        SOCKET client = static_cast<SOCKET>(clientHandle);
+        auto start = std::chrono::steady_clock::now();
+
+        // Read the request head; bodies are not used. A client trickling bytes
+        // gets the same time as one sending nothing
+        std::string request;
+        char buffer[4096];
+        auto deadline = start + std::chrono::milliseconds(static_cast<long long>(kSocketTimeoutMs));
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 65536 &&
+            std::chrono::steady_clock::now() < deadline)
+        {
+            int n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0) break;
+            request.append(buffer, n);
+        }
+        if (request.find("\r\n\r\n") == std::string::npos)
+        {
+            closesocket(client);
+            return;
+        }
+
+        int status = 404;
+        std::string contentType = "text/plain; charset=utf-8";
+        std::string body = "not found\n";
+        bool cacheHit = false;
+
+        std::string method, target;
+        std::istringstream head(request);
+        head >> method >> target;
+
+        size_t question = target.find('?');
+        std::string path = target.substr(0, question);
+        std::string queryString = question == std::string::npos ? "" : target.substr(question + 1);
+
+        if (method != "GET")
+        {
+            status = 405;
+            body = "only GET is supported\n";
+        }
+        else if (path == "/search")
+        {
+            body = HandleSearch(ParseQueryString(queryString), status, contentType, cacheHit);
+        }
+        else if (path == "/health")
+        {
+            size_t hits, misses, size;
+            cache.GetCounters(hits, misses, size);
+            std::ostringstream ss;
+            ss << "{\"status\":\"ok\",\"connections\":" << pool.Size() << ",\"cacheEntries\":" << size
+                << ",\"cacheHits\":" << hits << ",\"cacheMisses\":" << misses << "}\n";
+            status = 200;
+            contentType = "application/json";
+            body = ss.str();
+        }
+
+        std::ostringstream response;
+        response << "HTTP/1.1 " << status << " " << StatusText(status) << "\r\n"
+            << "Content-Type: " << contentType << "\r\n"
+            << "Content-Length: " << body.size() << "\r\n"
+            << "X-Cache: " << (cacheHit ? "HIT" : "MISS") << "\r\n"
+            << "Connection: close\r\n\r\n";
+        SendAll(client, response.str());
+        SendAll(client, body);
+        shutdown(client, SD_SEND);
+        closesocket(client);
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::wcout << Converters::StringToWString(method + " " + path) << L" -> " << status
+            << (cacheHit ? L" (cached)" : L"") << L" " << elapsedMs << L" ms" << std::endl;
+    }
+
+    void QueryService::HandlerLoop()
+    {
+        while (true)
+        {
+            uintptr_t client;
+            {
+                std::unique_lock<std::mutex> lock(pendingMutex);
+                clientQueued.wait(lock, [this] { return !pendingClients.empty(); });
+                client = pendingClients.front();
+                pendingClients.pop_front();
+            }
+            HandleClient(client);
+        }
+    }
+
+    bool QueryService::Run(unsigned short port, size_t poolSize)
+    {
+        if (!pool.Open(defaults, poolSize))
+        {
+            std::wcerr << L"✗ Failed to connect to LDAP server." << std::endl;
+            return false;
+        }
+        LDAPConnection* schemaConnection = pool.Acquire();
+        Schema::Activate(schemaConnection, defaults, true);
+        pool.Release(schemaConnection);
+
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+        {
+            std::wcerr << L"WSAStartup failed" << std::endl;
+            return false;
+        }
+
+        SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // Never exposed beyond localhost
+
+        if (listener == INVALID_SOCKET ||
+            bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR ||
+            listen(listener, SOMAXCONN) == SOCKET_ERROR)
+        {
+            std::wcerr << L"Failed to listen on 127.0.0.1:" << port << std::endl;
+            if (listener != INVALID_SOCKET) closesocket(listener);
+            WSACleanup();
+            return false;
+        }
+
+        size_t handlerCount = std::max<size_t>(2 * pool.Size(), 4);
+        for (size_t i = 0; i < handlerCount; ++i)
+            std::thread(&QueryService::HandlerLoop, this).detach();
+
+        std::wcout << L"✓ Serving on http://127.0.0.1:" << port << L"/search with " << pool.Size()
+            << L" bound connection(s) and " << handlerCount << L" handler threads" << std::endl;
+
+        DWORD timeout = kSocketTimeoutMs;
+        while (true)
+        {
+            SOCKET client = accept(listener, NULL, NULL);
+            if (client == INVALID_SOCKET)
+                continue;
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+            bool queued = false;
+            {
+                std::lock_guard<std::mutex> lock(pendingMutex);
+                if (pendingClients.size() < kMaxPendingClients)
+                {
+                    pendingClients.push_back(static_cast<uintptr_t>(client));
+                    queued = true;
+                }
+            }
+            if (queued)
+            {
+                clientQueued.notify_one();
+                continue;
+            }
+
+            SendAll(client, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            shutdown(client, SD_SEND);
+            closesocket(client);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+#include "LDAPTypes.h"
+#include "LDAPConnection.h"
+#include <chrono>
+#include <list>
+#include <deque>
+#include <functional>
+#include <future>
+#include <unordered_map>
+
+namespace LDAPUtils
+{
+    struct CachedResult
+    {
+        std::vector<std::wstring> attributes;   // Column order for CSV
+        std::vector<Entry> entries;
+    };
+
+    // Recent search results keyed by (baseDN, scope, filter, attributes), expiring
+    // after a TTL and evicting the least recently used entry beyond capacity.
+    // Concurrent misses on one key share a single fetch (Fetch).
+    class QueryCache
+    {
+    private:
+        struct Slot
+        {
+            std::shared_ptr<const CachedResult> result;
+            std::chrono::steady_clock::time_point stored;
+            std::list<std::wstring>::iterator lruPosition;
+        };
+
+        std::chrono::seconds ttl;
+        size_t capacity;
+        std::list<std::wstring> lru;
+        std::unordered_map<std::wstring, Slot> slots;
+        std::unordered_map<std::wstring, std::shared_future<std::shared_ptr<const CachedResult>>> inFlight;
+        std::mutex mutex;
+        size_t hits = 0;
+        size_t misses = 0;
+
+        // Called with mutex held
+        std::shared_ptr<const CachedResult> Find(const std::wstring& key);
+        void Store(const std::wstring& key, std::shared_ptr<const CachedResult> result);
+
+    public:
+        QueryCache(std::chrono::seconds ttl, size_t capacity);
+
+        static std::wstring MakeKey(const SearchConfig& config);
+
+        // Cached result for key, else the result of a fetch another caller already
+        // started for it, else calls fetch and stores what it returns. Only the
+        // caller that ran fetch sees outHit false; nullptr when the fetch failed
+        std::shared_ptr<const CachedResult> Fetch(const std::wstring& key,
+            const std::function<std::shared_ptr<const CachedResult>()>& fetch, bool& outHit);
+        void GetCounters(size_t& outHits, size_t& outMisses, size_t& outSize);
+    };
+
+    // Localhost HTTP front end for Search:
+    //   GET /search?base=&scope=base|one|sub&filter=&attrs=a,b&limit=&format=ndjson|csv
+    //               &sort=sn,-whenCreated&window=10001-10100&values=display|raw
+    //   GET /health
+    class QueryService
+    {
+    private:
+        SearchConfig defaults;
+        LDAPConnectionPool pool;
+        QueryCache cache;
+
+        // Accepted sockets waiting for a handler thread; Run answers 503 when
+        // kMaxPendingClients are already queued
+        std::deque<uintptr_t> pendingClients;
+        std::mutex pendingMutex;
+        std::condition_variable clientQueued;
+
+        void HandlerLoop();
+        void HandleClient(uintptr_t client);
+        std::string HandleSearch(const std::map<std::wstring, std::wstring>& params, int& outStatus,
+            std::string& outContentType, bool& outCacheHit);
+
+    public:
+        static const size_t kMaxPendingClients = 64;
+        static const unsigned long kSocketTimeoutMs = 10000;    // Per recv/send, and for the whole request head
+
+        QueryService(const SearchConfig& defaults, std::chrono::seconds ttl, size_t cacheCapacity = 256);
+
+        // Binds poolSize connections, then serves with 2 * poolSize handler threads
+        // (at least 4) until the process is stopped
+        bool Run(unsigned short port, size_t poolSize);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,888 @@
+﻿#include "LDAPSnapshot.h"
+#include "LDAPConverters.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        const char kSnapshotMagic[8] = { 'L', 'D', 'S', 'N', 'A', 'P', '0', '4' };
+        const char kSnapshotMagicV3[8] = { 'L', 'D', 'S', 'N', 'A', 'P', '0', '3' };   // Described values, no kinds
+        const char kSnapshotMagicV2[8] = { 'L', 'D', 'S', 'N', 'A', 'P', '0', '2' };   // Stream format
+        const char kSnapshotMagicV1[8] = { 'L', 'D', 'S', 'N', 'A', 'P', '0', '1' };   // Stream format, no DirSync cookie
+        const size_t kHeaderSize = 64;
+
+        // Header field positions
+        const size_t kEntryCountAt = 8;
+        const size_t kAttributeCountAt = 12;
+        const size_t kStateOffsetAt = 16;
+        const size_t kDictionaryOffsetAt = 24;
+        const size_t kEntryTableOffsetAt = 32;
+        const size_t kDnIndexOffsetAt = 40;
+        const size_t kFileSizeAt = 48;
+        const size_t kIndexOffsetAt = 56;       // 0 in files without secondary indexes
+
+        void AppendU32(std::string& out, unsigned int value)
+        {
+            char bytes[4] = {
+                static_cast<char>(value), static_cast<char>(value >> 8),
+                static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+            out.append(bytes, 4);
+        }
+
+        void AppendU64(std::string& out, unsigned long long value)
+        {
+            AppendU32(out, static_cast<unsigned int>(value));
+            AppendU32(out, static_cast<unsigned int>(value >> 32));
+        }
+
+        void AppendBytes(std::string& out, const std::string& value)
+        {
+            AppendU32(out, static_cast<unsigned int>(value.size()));
+            out.append(value);
+        }
+
+        void AppendString(std::string& out, const std::wstring& value)
+        {
+            AppendBytes(out, Converters::WStringToUtf8(value));
+        }
+
+        void PatchU32(std::string& out, size_t at, unsigned int value)
+        {
+            for (int i = 0; i < 4; ++i)
+                out[at + i] = static_cast<char>(value >> (8 * i));
+        }
+
+        void PatchU64(std::string& out, size_t at, unsigned long long value)
+        {
+            PatchU32(out, at, static_cast<unsigned int>(value));
+            PatchU32(out, at + 4, static_cast<unsigned int>(value >> 32));
+        }
+
+        unsigned int GetU32(const unsigned char* p)
+        {
+            return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+        }
+
+        unsigned long long GetU64(const unsigned char* p)
+        {
+            return GetU32(p) | (static_cast<unsigned long long>(GetU32(p + 4)) << 32);
+        }
+
+        // FNV-1a over the UTF-16 code units of a lower-cased value
+        unsigned int HashValue(const std::wstring& lowerValue)
+        {
+            unsigned int hash = 2166136261u;
+            for (wchar_t c : lowerValue)
+            {
+                hash = (hash ^ (c & 0xFF)) * 16777619u;
+                hash = (hash ^ ((c >> 8) & 0xFF)) * 16777619u;
+            }
+            return hash;
+        }
+
+        unsigned long long NowTicks()
+        {
+            FILETIME now;
+            GetSystemTimeAsFileTime(&now);
+            return (static_cast<unsigned long long>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        }
+
+        // Bounds-checked reader over a mapped region
+        struct Cursor
+        {
+            const unsigned char* p;
+            const unsigned char* end;
+
+            bool U8(unsigned char& value)
+            {
+                if (end - p < 1) return false;
+                value = *p++;
+                return true;
+            }
+
+            bool U32(unsigned int& value)
+            {
+                if (end - p < 4) return false;
+                value = GetU32(p);
+                p += 4;
+                return true;
+            }
+
+            bool U64(unsigned long long& value)
+            {
+                if (end - p < 8) return false;
+                value = GetU64(p);
+                p += 8;
+                return true;
+            }
+
+            bool Skip(unsigned long long length)
+            {
+                if (static_cast<unsigned long long>(end - p) < length) return false;
+                p += length;
+                return true;
+            }
+
+            bool Bytes(std::string& value)
+            {
+                unsigned int length;
+                if (!U32(length) || static_cast<size_t>(end - p) < length) return false;
+                value.assign(reinterpret_cast<const char*>(p), length);
+                p += length;
+                return true;
+            }
+
+            bool String(std::wstring& value)
+            {
+                std::string utf8;
+                if (!Bytes(utf8)) return false;
+                value = Converters::StringToWString(utf8);
+                return true;
+            }
+        };
+
+        bool ReadState(Cursor& cursor, SyncState& state)
+        {
+            return cursor.String(state.server) && cursor.String(state.baseDN) && cursor.String(state.filter) &&
+                cursor.String(state.invocationId) && cursor.U64(state.highestUSN) && cursor.Bytes(state.dirSyncCookie);
+        }
+
+        // Legacy stream format readers
+        bool ReadU32(std::istream& in, unsigned int& value)
+        {
+            unsigned char bytes[4];
+            if (!in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+            value = GetU32(bytes);
+            return true;
+        }
+
+        bool ReadU64(std::istream& in, unsigned long long& value)
+        {
+            unsigned char bytes[8];
+            if (!in.read(reinterpret_cast<char*>(bytes), 8)) return false;
+            value = GetU64(bytes);
+            return true;
+        }
+
+        bool ReadBytes(std::istream& in, std::string& value)
+        {
+            unsigned int length;
+            if (!ReadU32(in, length)) return false;
+            value.assign(length, '\0');
+            return length == 0 || static_cast<bool>(in.read(&value[0], length));
+        }
+
+        bool ReadString(std::istream& in, std::wstring& value)
+        {
+            std::string utf8;
+            if (!ReadBytes(in, utf8)) return false;
+            value = Converters::StringToWString(utf8);
+            return true;
+        }
+    }
+
+    std::wstring Snapshot::KeyOf(const Entry& entry)
+    {
+        auto it = entry.attrs.find(L"objectGUID");
+        if (it != entry.attrs.end() && !it->second.empty())
+            return L"guid:" + it->second[0].str();
+        return L"dn:" + Converters::ToLower(entry.dn);
+    }
+
+    void Snapshot::RebuildIndex()
+    {
+        keyIndex.clear();
+        keyIndex.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+            keyIndex[KeyOf(entries[i])] = i;
+    }
+
+    bool Snapshot::Upsert(Entry entry)
+    {
+        std::wstring key = KeyOf(entry);
+        auto it = keyIndex.find(key);
+        if (it != keyIndex.end())
+        {
+            entries[it->second] = std::move(entry);
+            return true;
+        }
+        keyIndex[key] = entries.size();
+        entries.push_back(std::move(entry));
+        return false;
+    }
+
+    bool Snapshot::Merge(Entry changes)
+    {
+        auto it = keyIndex.find(KeyOf(changes));
+        if (it == keyIndex.end())
+        {
+            for (auto attr = changes.attrs.begin(); attr != changes.attrs.end();)
+                attr = attr->second.empty() ? changes.attrs.erase(attr) : std::next(attr);
+            Upsert(std::move(changes));
+            return false;
+        }
+
+        Entry& existing = entries[it->second];
+        if (!changes.dn.empty())
+            existing.dn = std::move(changes.dn);
+        for (auto& attr : changes.attrs)
+        {
+            if (attr.second.empty())
+                existing.attrs.erase(attr.first);
+            else
+                existing.attrs[attr.first] = std::move(attr.second);
+        }
+        return true;
+    }
+
+    bool Snapshot::Remove(const Entry& entry)
+    {
+        auto it = keyIndex.find(KeyOf(entry));
+        if (it == keyIndex.end())
+            return false;
+
+        size_t index = it->second;
+        keyIndex.erase(it);
+        if (index != entries.size() - 1)
+        {
+            entries[index] = std::move(entries.back());
+            keyIndex[KeyOf(entries[index])] = index;
+        }
+        entries.pop_back();
+        return true;
+    }
+
+    void Snapshot::Clear()
+    {
+        entries.clear();
+        keyIndex.clear();
+    }
+
+    bool Snapshot::Save(const std::wstring& filename) const
+    {
+        return Save(filename, state, entries, indexOptions);
+    }
+
+    bool Snapshot::Save(const std::wstring& filename, const SyncState& state, const std::vector<Entry>& entries,
+        const SnapshotIndexOptions& indexOptions)
+    {
+        std::string out(kHeaderSize, '\0');
+        std::memcpy(&out[0], kSnapshotMagic, sizeof(kSnapshotMagic));
+
+        PatchU64(out, kStateOffsetAt, out.size());
+        AppendString(out, state.server);
+        AppendString(out, state.baseDN);
+        AppendString(out, state.filter);
+        AppendString(out, state.invocationId);
+        AppendU64(out, state.highestUSN);
+        AppendBytes(out, state.dirSyncCookie);
+
+        // Attribute names are stored once and referenced by index
+        std::unordered_map<std::wstring, unsigned int> dictionary;
+        std::vector<const std::wstring*> names;
+        for (const auto& e : entries)
+        {
+            for (const auto& attr : e.attrs)
+            {
+                if (dictionary.emplace(attr.first, static_cast<unsigned int>(names.size())).second)
+                    names.push_back(&attr.first.str());
+            }
+        }
+        PatchU64(out, kDictionaryOffsetAt, out.size());
+        for (const auto* name : names)
+            AppendString(out, *name);
+
+        std::vector<unsigned long long> recordOffsets;
+        recordOffsets.reserve(entries.size());
+        for (const auto& e : entries)
+        {
+            recordOffsets.push_back(out.size());
+            AppendString(out, e.dn);
+            AppendU32(out, static_cast<unsigned int>(e.attrs.size()));
+            for (const auto& attr : e.attrs)
+            {
+                AppendU32(out, dictionary[attr.first]);
+                AppendU32(out, static_cast<unsigned int>(attr.second.size()));
+                for (const auto& val : attr.second)
+                {
+                    out += static_cast<char>(val.kind());
+                    AppendString(out, val);
+                }
+            }
+        }
+
+        PatchU64(out, kEntryTableOffsetAt, out.size());
+        for (auto offset : recordOffsets)
+            AppendU64(out, offset);
+
+        std::vector<std::wstring> lowerDns;
+        lowerDns.reserve(entries.size());
+        for (const auto& e : entries)
+            lowerDns.push_back(Converters::ToLower(e.dn));
+        std::vector<unsigned int> dnOrder(entries.size());
+        for (size_t i = 0; i < dnOrder.size(); ++i)
+            dnOrder[i] = static_cast<unsigned int>(i);
+        std::sort(dnOrder.begin(), dnOrder.end(),
+            [&](unsigned int a, unsigned int b) { return lowerDns[a] < lowerDns[b]; });
+
+        PatchU64(out, kDnIndexOffsetAt, out.size());
+        for (auto index : dnOrder)
+            AppendU32(out, index);
+
+        // Secondary indexes cover only attributes present in the data, under
+        // every spelling the entries use
+        auto spellingsOf = [&](const std::wstring& attribute)
+        {
+            std::vector<const std::wstring*> spellings;
+            for (const auto* name : names)
+            {
+                if (_wcsicmp(name->c_str(), attribute.c_str()) == 0)
+                    spellings.push_back(name);
+            }
+            return spellings;
+        };
+
+        PatchU64(out, kIndexOffsetAt, out.size());
+        AppendU64(out, NowTicks());
+
+        std::vector<std::vector<const std::wstring*>> equality;
+        for (const auto& attribute : indexOptions.equality)
+        {
+            std::vector<const std::wstring*> spellings = spellingsOf(attribute);
+            if (!spellings.empty())
+                equality.push_back(spellings);
+        }
+        AppendU32(out, static_cast<unsigned int>(equality.size()));
+        for (const auto& spellings : equality)
+        {
+            std::vector<std::pair<unsigned int, unsigned int>> slots;     // (hash, entry)
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                for (const auto* spelling : spellings)
+                {
+                    auto it = entries[i].attrs.find(*spelling);
+                    if (it == entries[i].attrs.end()) continue;
+                    for (const auto& val : it->second)
+                        slots.emplace_back(HashValue(Converters::ToLower(val)), static_cast<unsigned int>(i));
+                }
+            }
+
+            unsigned int bucketCount = 1;
+            while (bucketCount < slots.size())
+                bucketCount <<= 1;
+            std::vector<unsigned int> starts(bucketCount + 1, 0);
+            for (const auto& slot : slots)
+                ++starts[(slot.first & (bucketCount - 1)) + 1];
+            for (unsigned int b = 0; b < bucketCount; ++b)
+                starts[b + 1] += starts[b];
+
+            std::vector<std::pair<unsigned int, unsigned int>> grouped(slots.size());
+            std::vector<unsigned int> fill(starts.begin(), starts.end() - 1);
+            for (const auto& slot : slots)
+                grouped[fill[slot.first & (bucketCount - 1)]++] = slot;
+
+            AppendString(out, *spellings.front());
+            AppendU32(out, bucketCount);
+            AppendU32(out, static_cast<unsigned int>(grouped.size()));
+            for (auto start : starts)
+                AppendU32(out, start);
+            for (const auto& slot : grouped)
+            {
+                AppendU32(out, slot.first);
+                AppendU32(out, slot.second);
+            }
+        }
+
+        std::vector<std::vector<const std::wstring*>> ranges;
+        for (const auto& attribute : indexOptions.range)
+        {
+            std::vector<const std::wstring*> spellings = spellingsOf(attribute);
+            if (!spellings.empty())
+                ranges.push_back(spellings);
+        }
+        AppendU32(out, static_cast<unsigned int>(ranges.size()));
+        for (const auto& spellings : ranges)
+        {
+            std::vector<std::pair<unsigned long long, unsigned int>> records;
+            std::vector<unsigned int> others;
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                for (const auto* spelling : spellings)
+                {
+                    auto it = entries[i].attrs.find(*spelling);
+                    if (it == entries[i].attrs.end()) continue;
+                    for (const auto& val : it->second)
+                    {
+                        unsigned long long ticks = Converters::TimestampTicks(val);
+                        if (ticks != 0)
+                            records.emplace_back(ticks, static_cast<unsigned int>(i));
+                        else
+                            others.push_back(static_cast<unsigned int>(i));
+                    }
+                }
+            }
+            std::sort(records.begin(), records.end());
+
+            AppendString(out, *spellings.front());
+            AppendU32(out, static_cast<unsigned int>(records.size()));
+            for (const auto& record : records)
+            {
+                AppendU64(out, record.first);
+                AppendU32(out, record.second);
+            }
+            AppendU32(out, static_cast<unsigned int>(others.size()));
+            for (auto other : others)
+                AppendU32(out, other);
+        }
+
+        PatchU32(out, kEntryCountAt, static_cast<unsigned int>(entries.size()));
+        PatchU32(out, kAttributeCountAt, static_cast<unsigned int>(names.size()));
+        PatchU64(out, kFileSizeAt, out.size());
+
+        // Write to a temporary file first so an interrupted run keeps the old snapshot
+        std::wstring tempFile = filename + L".tmp";
+        {
+            std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                std::wcerr << L"Failed to create snapshot file: " << tempFile << std::endl;
+                return false;
+            }
+            if (!file.write(out.data(), out.size()))
+            {
+                std::wcerr << L"Failed to write snapshot file: " << tempFile << std::endl;
+                return false;
+            }
+        }
+
+        if (!MoveFileExW(tempFile.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            std::wcerr << L"Failed to replace snapshot file: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool Snapshot::Load(const std::wstring& filename)
+    {
+        char magic[sizeof(kSnapshotMagic)] = {};
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open())
+                return false;
+            file.read(magic, sizeof(magic));
+        }
+        if (std::memcmp(magic, kSnapshotMagic, sizeof(magic)) != 0 && std::memcmp(magic, kSnapshotMagicV3, sizeof(magic)) != 0)
+            return LoadLegacy(filename);
+
+        SnapshotView view;
+        if (!view.Open(filename))
+            return false;
+
+        std::vector<Entry> loaded = view.Materialize();
+        if (loaded.size() != view.Size())
+            return false;
+
+        state = view.State();
+        entries = std::move(loaded);
+        RebuildIndex();
+        return true;
+    }
+
+    bool Snapshot::LoadLegacy(const std::wstring& filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        char magic[sizeof(kSnapshotMagic)];
+        bool hasCookie = true;
+        if (!file.read(magic, sizeof(magic)))
+        {
+            std::wcerr << L"Not a snapshot file: " << filename << std::endl;
+            return false;
+        }
+        if (std::memcmp(magic, kSnapshotMagicV1, sizeof(magic)) == 0)
+        {
+            hasCookie = false;
+        }
+        else if (std::memcmp(magic, kSnapshotMagicV2, sizeof(magic)) != 0)
+        {
+            std::wcerr << L"Not a snapshot file: " << filename << std::endl;
+            return false;
+        }
+
+        SyncState loadedState;
+        unsigned int entryCount = 0;
+        if (!ReadString(file, loadedState.server) || !ReadString(file, loadedState.baseDN) ||
+            !ReadString(file, loadedState.filter) || !ReadString(file, loadedState.invocationId) ||
+            !ReadU64(file, loadedState.highestUSN) ||
+            (hasCookie && !ReadBytes(file, loadedState.dirSyncCookie)) || !ReadU32(file, entryCount))
+        {
+            std::wcerr << L"Corrupt snapshot header: " << filename << std::endl;
+            return false;
+        }
+
+        std::vector<Entry> loaded;
+        loaded.reserve(entryCount);
+        for (unsigned int i = 0; i < entryCount; ++i)
+        {
+            Entry e;
+            unsigned int attrCount = 0;
+            if (!ReadString(file, e.dn) || !ReadU32(file, attrCount))
+            {
+                std::wcerr << L"Corrupt snapshot entry " << i << L": " << filename << std::endl;
+                return false;
+            }
+            for (unsigned int a = 0; a < attrCount; ++a)
+            {
+                std::wstring name;
+                unsigned int valCount = 0;
+                if (!ReadString(file, name) || !ReadU32(file, valCount))
+                {
+                    std::wcerr << L"Corrupt snapshot entry " << i << L": " << filename << std::endl;
+                    return false;
+                }
+                std::vector<Value>& values = e.attrs[name];
+                values.reserve(valCount);
+                for (unsigned int v = 0; v < valCount; ++v)
+                {
+                    std::wstring value;
+                    if (!ReadString(file, value))
+                    {
+                        std::wcerr << L"Corrupt snapshot entry " << i << L": " << filename << std::endl;
+                        return false;
+                    }
+                    values.push_back(std::move(value));
+                }
+            }
+            loaded.push_back(std::move(e));
+        }
+
+        state = loadedState;
+        entries = std::move(loaded);
+        RebuildIndex();
+        return true;
+    }
+
+    SnapshotView::~SnapshotView()
+    {
+        Close();
+    }
+
+    void SnapshotView::Close()
+    {
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        data = nullptr;
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+        size = 0;
+        typed = false;
+        entryCount = 0;
+        attributeNames.clear();
+        attributeKeys.clear();
+        state = SyncState();
+        savedAt = 0;
+        equalityIndexes.clear();
+        rangeIndexes.clear();
+    }
+
+    bool SnapshotView::Open(const std::wstring& filename)
+    {
+        Close();
+
+        file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            std::wcerr << L"Failed to open snapshot file: " << filename << std::endl;
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(kHeaderSize))
+        {
+            std::wcerr << L"Not a snapshot file: " << filename << std::endl;
+            Close();
+            return false;
+        }
+
+        mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        data = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!data)
+        {
+            std::wcerr << L"Failed to map snapshot file: " << filename << std::endl;
+            Close();
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+
+        typed = std::memcmp(data, kSnapshotMagic, sizeof(kSnapshotMagic)) == 0;
+        if ((!typed && std::memcmp(data, kSnapshotMagicV3, sizeof(kSnapshotMagicV3)) != 0) || GetU64(data + kFileSizeAt) != size)
+        {
+            std::wcerr << L"Not a v3 or v4 snapshot file or truncated: " << filename << std::endl;
+            Close();
+            return false;
+        }
+
+        entryCount = GetU32(data + kEntryCountAt);
+        unsigned int attributeCount = GetU32(data + kAttributeCountAt);
+        unsigned long long stateOffset = GetU64(data + kStateOffsetAt);
+        unsigned long long dictionaryOffset = GetU64(data + kDictionaryOffsetAt);
+        entryTableOffset = GetU64(data + kEntryTableOffsetAt);
+        dnIndexOffset = GetU64(data + kDnIndexOffsetAt);
+
+        bool valid = stateOffset < size && dictionaryOffset < size &&
+            entryTableOffset + 8ULL * entryCount <= size && dnIndexOffset + 4ULL * entryCount <= size;
+
+        Cursor stateCursor{ data + (valid ? stateOffset : 0), data + size };
+        valid = valid && ReadState(stateCursor, state);
+
+        Cursor dictionaryCursor{ data + (valid ? dictionaryOffset : 0), data + size };
+        attributeNames.resize(valid ? attributeCount : 0);
+        for (unsigned int i = 0; valid && i < attributeCount; ++i)
+            valid = dictionaryCursor.String(attributeNames[i]);
+        attributeKeys.assign(attributeNames.begin(), attributeNames.end());
+
+        unsigned long long indexOffset = GetU64(data + kIndexOffsetAt);
+        valid = valid && (indexOffset == 0 || ReadIndexes(indexOffset));
+
+        if (!valid)
+        {
+            std::wcerr << L"Corrupt snapshot header: " << filename << std::endl;
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool SnapshotView::ReadIndexes(unsigned long long offset)
+    {
+        // Only the section directory is read; lookups go to the mapped arrays
+        if (offset >= size)
+            return false;
+        Cursor cursor{ data + offset, data + size };
+
+        unsigned int count;
+        if (!cursor.U64(savedAt) || !cursor.U32(count))
+            return false;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            std::wstring name;
+            EqualityIndex index;
+            if (!cursor.String(name) || !cursor.U32(index.bucketCount) || !cursor.U32(index.slotCount) ||
+                index.bucketCount == 0 || (index.bucketCount & (index.bucketCount - 1)) != 0)
+                return false;
+            index.bucketsOffset = cursor.p - data;
+            if (!cursor.Skip(4ULL * (index.bucketCount + 1ULL)))
+                return false;
+            index.slotsOffset = cursor.p - data;
+            if (!cursor.Skip(8ULL * index.slotCount))
+                return false;
+            equalityIndexes[Converters::ToLower(name)] = index;
+        }
+
+        if (!cursor.U32(count))
+            return false;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            std::wstring name;
+            RangeIndex index;
+            if (!cursor.String(name) || !cursor.U32(index.recordCount))
+                return false;
+            index.recordsOffset = cursor.p - data;
+            if (!cursor.Skip(12ULL * index.recordCount) || !cursor.U32(index.otherCount))
+                return false;
+            index.othersOffset = cursor.p - data;
+            if (!cursor.Skip(4ULL * index.otherCount))
+                return false;
+            rangeIndexes[Converters::ToLower(name)] = index;
+        }
+        return true;
+    }
+
+    bool SnapshotView::HasEqualityIndex(const std::wstring& attribute) const
+    {
+        return equalityIndexes.count(Converters::ToLower(attribute)) > 0;
+    }
+
+    bool SnapshotView::HasRangeIndex(const std::wstring& attribute) const
+    {
+        return rangeIndexes.count(Converters::ToLower(attribute)) > 0;
+    }
+
+    bool SnapshotView::FindEqual(const std::wstring& attribute, const std::wstring& value,
+        std::vector<unsigned int>& outEntries) const
+    {
+        auto it = equalityIndexes.find(Converters::ToLower(attribute));
+        if (it == equalityIndexes.end())
+            return false;
+
+        const EqualityIndex& index = it->second;
+        unsigned int hash = HashValue(Converters::ToLower(value));
+        unsigned int bucket = hash & (index.bucketCount - 1);
+        unsigned int begin = GetU32(data + index.bucketsOffset + 4ULL * bucket);
+        unsigned int end = std::min(GetU32(data + index.bucketsOffset + 4ULL * (bucket + 1)), index.slotCount);
+
+        outEntries.clear();
+        for (unsigned int s = begin; s < end; ++s)
+        {
+            const unsigned char* slot = data + index.slotsOffset + 8ULL * s;
+            if (GetU32(slot) == hash && GetU32(slot + 4) < entryCount)
+                outEntries.push_back(GetU32(slot + 4));
+        }
+        std::sort(outEntries.begin(), outEntries.end());
+        outEntries.erase(std::unique(outEntries.begin(), outEntries.end()), outEntries.end());
+        return true;
+    }
+
+    bool SnapshotView::FindRange(const std::wstring& attribute, unsigned long long lowTicks, unsigned long long highTicks,
+        std::vector<unsigned int>& outEntries) const
+    {
+        auto it = rangeIndexes.find(Converters::ToLower(attribute));
+        if (it == rangeIndexes.end())
+            return false;
+
+        const RangeIndex& index = it->second;
+        auto ticksAt = [&](size_t r) { return GetU64(data + index.recordsOffset + 12ULL * r); };
+        size_t low = 0, high = index.recordCount;
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            if (ticksAt(mid) < lowTicks)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        outEntries.clear();
+        for (size_t r = low; r < index.recordCount && ticksAt(r) <= highTicks; ++r)
+        {
+            unsigned int entry = GetU32(data + index.recordsOffset + 12ULL * r + 8);
+            if (entry < entryCount)
+                outEntries.push_back(entry);
+        }
+        for (unsigned int o = 0; o < index.otherCount; ++o)
+        {
+            unsigned int entry = GetU32(data + index.othersOffset + 4ULL * o);
+            if (entry < entryCount)
+                outEntries.push_back(entry);
+        }
+        std::sort(outEntries.begin(), outEntries.end());
+        outEntries.erase(std::unique(outEntries.begin(), outEntries.end()), outEntries.end());
+        return true;
+    }
+
+    unsigned long long SnapshotView::RecordOffset(size_t index) const
+    {
+        return GetU64(data + entryTableOffset + 8 * index);
+    }
+
+    std::wstring SnapshotView::DnAt(size_t index) const
+    {
+        std::wstring dn;
+        unsigned long long offset = index < entryCount ? RecordOffset(index) : size;
+        if (offset < size)
+        {
+            Cursor cursor{ data + offset, data + size };
+            cursor.String(dn);
+        }
+        return dn;
+    }
+
+    bool SnapshotView::EntryAt(size_t index, Entry& outEntry) const
+    {
+        if (index >= entryCount)
+            return false;
+        unsigned long long offset = RecordOffset(index);
+        if (offset >= size)
+            return false;
+
+        Cursor cursor{ data + offset, data + size };
+        Entry e;
+        unsigned int attrCount;
+        if (!cursor.String(e.dn) || !cursor.U32(attrCount))
+            return false;
+
+        for (unsigned int a = 0; a < attrCount; ++a)
+        {
+            unsigned int nameIndex, valCount;
+            if (!cursor.U32(nameIndex) || !cursor.U32(valCount) || nameIndex >= attributeNames.size())
+                return false;
+
+            std::vector<Value>& values = e.attrs[attributeKeys[nameIndex]];
+            values.reserve(valCount);
+            for (unsigned int v = 0; v < valCount; ++v)
+            {
+                unsigned char kind = static_cast<unsigned char>(ValueKind::TEXT);
+                std::wstring value;
+                if ((typed && !cursor.U8(kind)) || kind > static_cast<unsigned char>(ValueKind::BINARY) || !cursor.String(value))
+                    return false;
+                values.emplace_back(std::move(value), static_cast<ValueKind>(kind));
+            }
+        }
+
+        outEntry = std::move(e);
+        return true;
+    }
+
+    bool SnapshotView::FindByDN(const std::wstring& dn, Entry& outEntry) const
+    {
+        // Binary search over the DN index; each probe decodes only the DN
+        std::wstring target = Converters::ToLower(dn);
+        size_t low = 0, high = entryCount;
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            unsigned int index = GetU32(data + dnIndexOffset + 4 * mid);
+            if (Converters::ToLower(DnAt(index)) < target)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low == entryCount)
+            return false;
+
+        unsigned int index = GetU32(data + dnIndexOffset + 4 * low);
+        return Converters::ToLower(DnAt(index)) == target && EntryAt(index, outEntry);
+    }
+
+    std::vector<Entry> SnapshotView::Materialize(unsigned int threadCount) const
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        const size_t minEntriesPerThread = 4096;
+        size_t partitions = std::min<size_t>(threadCount, std::max<size_t>(1, entryCount / minEntriesPerThread));
+
+        std::vector<Entry> entries(entryCount);
+        std::vector<char> ok(partitions, 1);
+        auto decodeRange = [&](size_t partition, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end && ok[partition]; ++i)
+                ok[partition] = EntryAt(i, entries[i]);
+        };
+
+        size_t chunk = partitions > 0 ? (entryCount + partitions - 1) / partitions : 0;
+        std::vector<std::thread> workers;
+        for (size_t p = 1; p < partitions; ++p)
+            workers.emplace_back(decodeRange, p, p * chunk, std::min<size_t>(entryCount, (p + 1) * chunk));
+        decodeRange(0, 0, std::min<size_t>(entryCount, chunk));
+        for (auto& worker : workers)
+            worker.join();
+
+        if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+        {
+            std::wcerr << L"Corrupt snapshot entry data" << std::endl;
+            entries.clear();
+        }
+        return entries;
+    }
+}
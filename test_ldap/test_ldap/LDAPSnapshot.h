@@ -0,0 +1,153 @@
+#pragma once
+#include "LDAPTypes.h"
+#include <windows.h>
+#include <unordered_map>
+
+namespace LDAPUtils
+{
+    // Replication position a snapshot was last synchronized to
+    struct SyncState
+    {
+        std::wstring server;
+        std::wstring baseDN;
+        std::wstring filter;
+        std::wstring invocationId;          // DC database identity; USNs are only comparable within one
+        unsigned long long highestUSN = 0;  // highestCommittedUSN read before the last sync
+        std::string dirSyncCookie;          // Set instead of highestUSN when synced with DirSync
+    };
+
+    // Attributes indexed when a snapshot is saved. Equality indexes are hash
+    // tables of lower-cased values; range indexes list timestamp values in order.
+    struct SnapshotIndexOptions
+    {
+        std::vector<std::wstring> equality = { L"sAMAccountName", L"userPrincipalName", L"objectSid", L"objectGUID", L"mail" };
+        std::vector<std::wstring> range = { L"whenCreated", L"whenChanged", L"lastLogonTimestamp", L"pwdLastSet" };
+    };
+
+    // Local copy of a search result that incremental runs merge changes into.
+    // Entries are keyed by objectGUID when present (survives renames and moves),
+    // otherwise by DN.
+    //
+    // On disk (v4, little-endian) the file is laid out for memory-mapped reads:
+    //   header      magic "LDSNAP04", counts and section offsets
+    //   state       SyncState
+    //   dictionary  attribute names, referenced by index from entries
+    //   records     per entry: DN, then (attribute index, values) pairs; each
+    //               value is a ValueKind byte and its text (v3 files hold
+    //               described text only and read back as TEXT)
+    //   entry table u64 offset of each record
+    //   DN index    u32 entry numbers ordered by lower-cased DN
+    //   indexes     save time, equality hash tables and sorted timestamp lists
+    //               (absent in files written before secondary indexes existed)
+    class Snapshot
+    {
+    private:
+        std::vector<Entry> entries;
+        std::unordered_map<std::wstring, size_t> keyIndex;
+
+        static std::wstring KeyOf(const Entry& entry);
+        void RebuildIndex();
+        bool LoadLegacy(const std::wstring& filename);
+
+    public:
+        SyncState state;
+        SnapshotIndexOptions indexOptions;
+
+        const std::vector<Entry>& Entries() const { return entries; }
+        size_t Size() const { return entries.size(); }
+
+        // Returns true when an existing entry was replaced
+        bool Upsert(Entry entry);
+        // Applies a partial entry (DirSync returns only changed attributes); an
+        // attribute with no values is removed. Returns true when the entry existed.
+        bool Merge(Entry changes);
+        bool Remove(const Entry& entry);
+        void Clear();
+
+        bool Load(const std::wstring& filename);
+        bool Save(const std::wstring& filename) const;
+
+        static bool Save(const std::wstring& filename, const SyncState& state, const std::vector<Entry>& entries,
+            const SnapshotIndexOptions& indexOptions = SnapshotIndexOptions());
+    };
+
+    // Read-only view of a v3 or v4 snapshot file. Open only maps the file and checks
+    // the header, so it costs the same for 300 entries or 300k; entries are
+    // decoded when asked for.
+    class SnapshotView
+    {
+    private:
+        struct EqualityIndex
+        {
+            unsigned int bucketCount = 0;       // Power of two
+            unsigned int slotCount = 0;
+            unsigned long long bucketsOffset = 0;   // u32 first slot of each bucket, plus an end marker
+            unsigned long long slotsOffset = 0;     // (u32 value hash, u32 entry number) grouped by bucket
+        };
+
+        struct RangeIndex
+        {
+            unsigned int recordCount = 0;
+            unsigned int otherCount = 0;
+            unsigned long long recordsOffset = 0;   // (u64 ticks, u32 entry number) in tick order
+            unsigned long long othersOffset = 0;    // u32 entries holding values that are not timestamps
+        };
+
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        bool typed = false;                     // v4: values carry their kind
+
+        unsigned int entryCount = 0;
+        unsigned long long entryTableOffset = 0;
+        unsigned long long dnIndexOffset = 0;
+        std::vector<std::wstring> attributeNames;
+        std::vector<Value> attributeKeys;       // attributeNames interned once, for decoding entries
+        SyncState state;
+        unsigned long long savedAt = 0;
+        std::unordered_map<std::wstring, EqualityIndex> equalityIndexes;   // Keyed by lower-cased attribute
+        std::unordered_map<std::wstring, RangeIndex> rangeIndexes;
+
+        unsigned long long RecordOffset(size_t index) const;
+        bool ReadIndexes(unsigned long long offset);
+
+    public:
+        SnapshotView() = default;
+        ~SnapshotView();
+        SnapshotView(const SnapshotView&) = delete;
+        SnapshotView& operator=(const SnapshotView&) = delete;
+
+        bool Open(const std::wstring& filename);
+        void Close();
+        bool IsOpen() const { return data != nullptr; }
+
+        size_t Size() const { return entryCount; }
+        size_t FileSize() const { return size; }
+        const SyncState& State() const { return state; }
+        const std::vector<std::wstring>& AttributeNames() const { return attributeNames; }
+
+        std::wstring DnAt(size_t index) const;
+        bool EntryAt(size_t index, Entry& outEntry) const;
+        bool FindByDN(const std::wstring& dn, Entry& outEntry) const;
+
+        // UTC FILETIME ticks of the save, 0 for files without secondary indexes
+        unsigned long long SavedAt() const { return savedAt; }
+        bool HasEqualityIndex(const std::wstring& attribute) const;
+        bool HasRangeIndex(const std::wstring& attribute) const;
+
+        // Sorted entry numbers that may hold value (case-insensitive); hash
+        // collisions are possible, so callers check the decoded entry.
+        // Returns false when the attribute has no equality index.
+        bool FindEqual(const std::wstring& attribute, const std::wstring& value, std::vector<unsigned int>& outEntries) const;
+
+        // Sorted entry numbers with a timestamp value in [lowTicks, highTicks], plus
+        // those holding values that are not timestamps ("Never", 0), which the
+        // caller has to judge itself. Returns false when there is no range index.
+        bool FindRange(const std::wstring& attribute, unsigned long long lowTicks, unsigned long long highTicks,
+            std::vector<unsigned int>& outEntries) const;
+
+        // Decodes every entry, splitting the work across threadCount threads (0 = all cores)
+        std::vector<Entry> Materialize(unsigned int threadCount = 0) const;
+    };
+}
\ No newline at end of file
@@ -3,57 +3,510 @@
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <fstream>
+#include <cmath>
+#include <thread>
+#include <cwctype>
 
 namespace LDAPUtils
 {
-    Statistics StatisticsCalculator::Calculate(const std::vector<Entry>& entries)
+    namespace
     {
-        Statistics stats;
-        stats.totalEntries = static_cast<int>(entries.size());
+        const int kHllPrecision = 12;
+        const size_t kHllRegisters = static_cast<size_t>(1) << kHllPrecision;
 
-        if (entries.empty())
+        unsigned long long HashValue(const std::wstring& value)
         {
-            return stats;
+            // FNV-1a followed by a splitmix64 finalizer for well-spread HLL buckets
+            unsigned long long h = 14695981039346656037ULL;
+            for (wchar_t c : value)
+            {
+                h ^= static_cast<unsigned long long>(c);
+                h *= 1099511628211ULL;
+            }
+            h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+            h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+            h ^= h >> 31;
+            return h;
         }
 
-        std::set<std::wstring> allAttrs;
+        void HllAdd(std::vector<unsigned char>& registers, const std::wstring& value)
+        {
+            unsigned long long h = HashValue(value);
+            size_t index = static_cast<size_t>(h >> (64 - kHllPrecision));
+            unsigned long long rest = (h << kHllPrecision) | (1ULL << (kHllPrecision - 1));
+            unsigned char rank = 1;
+            while ((rest & 0x8000000000000000ULL) == 0)
+            {
+                rest <<= 1;
+                ++rank;
+            }
+            if (rank > registers[index]) registers[index] = rank;
+        }
 
-        for (const auto& entry : entries)
+        unsigned long long HllEstimate(const std::vector<unsigned char>& registers)
         {
-            for (const auto& attr : entry.attrs)
+            double m = static_cast<double>(registers.size());
+            double sum = 0.0;
+            size_t zeros = 0;
+            for (unsigned char r : registers)
             {
-                allAttrs.insert(attr.first);
-                stats.attributeCount[attr.first]++;
+                sum += std::ldexp(1.0, -static_cast<int>(r));
+                if (r == 0) ++zeros;
+            }
+            double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+            if (estimate <= 2.5 * m && zeros > 0)
+                estimate = m * std::log(m / static_cast<double>(zeros)); // Linear counting
+            return static_cast<unsigned long long>(estimate + 0.5);
+        }
+
+        const unsigned long long kTicksPerDay = 864000000000ULL;
 
-                // Count unique values for specific attributes
-                if (attr.first == L"objectClass" ||
-                    attr.first == L"sAMAccountType" ||
-                    attr.first == L"department" ||
-                    attr.first == L"title" ||
-                    attr.first == L"userAccountControl" ||
-                    attr.first == L"groupType")
+        bool ParseAgeBuckets(const std::wstring& spec, std::vector<int>& outDays)
+        {
+            std::wstringstream ss(spec);
+            std::wstring bucket;
+            while (std::getline(ss, bucket, L'/'))
+            {
+                int days = 0;
+                if (bucket == L"day") days = 1;
+                else if (bucket == L"week") days = 7;
+                else if (bucket == L"month") days = 30;
+                else if (bucket == L"quarter") days = 90;
+                else if (bucket == L"year") days = 365;
+                else
                 {
-                    for (const auto& val : attr.second)
-                    {
-                        stats.uniqueValues[attr.first].insert(val);
-                    }
+                    if (!bucket.empty() && bucket.back() == L'd') bucket.pop_back();
+                    if (bucket.empty() || bucket.find_first_not_of(L"0123456789") != std::wstring::npos)
+                        return false;
+                    days = _wtoi(bucket.c_str());
                 }
+                if (days <= 0 || (!outDays.empty() && days <= outDays.back()))
+                    return false;
+                outDays.push_back(days);
+            }
+            return !outDays.empty();
+        }
+
+        std::wstring AgeBucketLabel(const std::vector<int>& buckets, size_t index)
+        {
+            std::wstringstream ss;
+            if (index < buckets.size())
+                ss << L"<= " << buckets[index] << (buckets[index] == 1 ? L" day" : L" days");
+            else
+                ss << L"> " << buckets.back() << L" days";
+            return ss.str();
+        }
 
-                // Count object classes
-                if (attr.first == L"objectClass")
+        bool ParseModes(const std::wstring& modesStr, StatisticsRule& rule)
+        {
+            std::wstringstream ss(modesStr);
+            std::wstring mode;
+            while (std::getline(ss, mode, L','))
+            {
+                mode.erase(0, mode.find_first_not_of(L" \t"));
+                mode.erase(mode.find_last_not_of(L" \t") + 1);
+                std::wstring lower = Converters::ToLower(mode);
+                if (lower.empty()) continue;
+
+                if (lower == L"unique") rule.modes |= STATS_UNIQUE;
+                else if (lower == L"histogram") rule.modes |= STATS_HISTOGRAM;
+                else if (lower == L"cardinality") rule.modes |= STATS_CARDINALITY;
+                else if (lower == L"flags") rule.modes |= STATS_FLAGS;
+                else if (lower == L"timehist" || lower.compare(0, 9, L"timehist:") == 0)
+                {
+                    rule.modes |= STATS_TIMEHIST;
+                    std::wstring spec = lower.size() > 8 ? lower.substr(9) : L"day/week/month/90d/180d/year";
+                    rule.ageBucketsDays.clear();
+                    if (!ParseAgeBuckets(spec, rule.ageBucketsDays)) return false;
+                }
+                else if (lower == L"topk" || lower.compare(0, 5, L"topk:") == 0)
                 {
-                    for (const auto& oc : attr.second)
+                    rule.modes |= STATS_TOPK;
+                    if (lower.size() > 4)
                     {
-                        stats.objectClassCount[oc]++;
+                        // topk:N, N a positive decimal and nothing after it
+                        const wchar_t* digits = lower.c_str() + 5;
+                        wchar_t* end = nullptr;
+                        unsigned long k = wcstoul(digits, &end, 10);
+                        if (!iswdigit(*digits) || *end != L'\0' || k == 0) return false;
+                        rule.topK = static_cast<size_t>(k);
                     }
                 }
+                else
+                {
+                    return false;
+                }
+            }
+            return rule.modes != 0;
+        }
+
+        StatisticsProfile& ActiveProfile()
+        {
+            static StatisticsProfile active = StatisticsProfile::Default();
+            return active;
+        }
+    }
+
+    size_t CaseInsensitiveHash::operator()(const std::wstring& s) const
+    {
+        size_t h = 14695981039346656037ULL;
+        for (wchar_t c : s)
+        {
+            h ^= static_cast<size_t>(towlower(c));
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    bool CaseInsensitiveEqual::operator()(const std::wstring& a, const std::wstring& b) const
+    {
+        return a.size() == b.size() && _wcsicmp(a.c_str(), b.c_str()) == 0;
+    }
+
+    void StatisticsProfile::AddRule(const StatisticsRule& rule)
+    {
+        auto it = lookup.find(rule.attribute);
+        if (it != lookup.end())
+        {
+            rules[it->second] = rule;
+            return;
+        }
+        lookup[rule.attribute] = rules.size();
+        rules.push_back(rule);
+    }
+
+    size_t StatisticsProfile::IndexOf(const std::wstring& attribute) const
+    {
+        auto it = lookup.find(attribute);
+        return it != lookup.end() ? it->second : npos;
+    }
+
+    bool StatisticsProfile::LoadFromFile(const std::wstring& filename, StatisticsProfile& outProfile)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::wcerr << L"Failed to open statistics profile: " << filename << std::endl;
+            return false;
+        }
+
+        StatisticsProfile profile;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNumber;
+            if (lineNumber == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0)
+                line.erase(0, 3);
+
+            std::wstring wline = Converters::StringToWString(line);
+            wline.erase(0, wline.find_first_not_of(L" \t\r"));
+            wline.erase(wline.find_last_not_of(L" \t\r") + 1);
+            if (wline.empty() || wline[0] == L'#' || wline[0] == L';')
+                continue;
+
+            size_t eq = wline.find(L'=');
+            StatisticsRule rule;
+            if (eq != std::wstring::npos)
+            {
+                rule.attribute = wline.substr(0, eq);
+                rule.attribute.erase(rule.attribute.find_last_not_of(L" \t") + 1);
+            }
+
+            if (rule.attribute.empty() || !ParseModes(wline.substr(eq + 1), rule))
+            {
+                std::wcerr << L"Invalid statistics profile line " << lineNumber << L": " << wline << std::endl;
+                return false;
+            }
+            profile.AddRule(rule);
+        }
+
+        outProfile = std::move(profile);
+        return true;
+    }
+
+    StatisticsProfile StatisticsProfile::Default()
+    {
+        StatisticsProfile profile;
+        profile.AddRule({ L"objectClass", STATS_UNIQUE | STATS_HISTOGRAM });
+        profile.AddRule({ L"sAMAccountType", STATS_UNIQUE });
+        profile.AddRule({ L"department", STATS_UNIQUE });
+        profile.AddRule({ L"title", STATS_UNIQUE });
+        profile.AddRule({ L"userAccountControl", STATS_UNIQUE | STATS_FLAGS });
+        profile.AddRule({ L"groupType", STATS_UNIQUE });
+
+        std::vector<int> ageBuckets = { 1, 7, 30, 90, 180, 365 };
+        for (const wchar_t* attr : { L"lastLogonTimestamp", L"pwdLastSet", L"whenCreated", L"whenChanged" })
+        {
+            profile.AddRule({ attr, STATS_TIMEHIST, 10, ageBuckets });
+        }
+        return profile;
+    }
+
+    const StatisticsProfile& StatisticsProfile::Active()
+    {
+        return ActiveProfile();
+    }
+
+    void StatisticsProfile::SetActive(const StatisticsProfile& profile)
+    {
+        ActiveProfile() = profile;
+    }
+
+    Statistics StatisticsCalculator::Calculate(const std::vector<Entry>& entries)
+    {
+        return Calculate(entries, StatisticsProfile::Active());
+    }
+
+    StatisticsAccumulator::StatisticsAccumulator(const StatisticsProfile& profile, unsigned long long nowTicks)
+        : profile(profile), states(profile.Rules().size()), nowTicks(nowTicks)
+    {
+        const std::vector<StatisticsRule>& rules = profile.Rules();
+        for (size_t r = 0; r < rules.size(); ++r)
+        {
+            if (rules[r].modes & STATS_CARDINALITY)
+                states[r].registers.assign(kHllRegisters, 0);
+            if (rules[r].modes & STATS_TIMEHIST)
+                states[r].ageBuckets.assign(rules[r].ageBucketsDays.size() + 1, 0);
+        }
+
+        if (this->nowTicks == 0)
+        {
+            FILETIME now;
+            GetSystemTimeAsFileTime(&now);
+            this->nowTicks = (static_cast<unsigned long long>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+        }
+    }
+
+    void StatisticsAccumulator::BeginEntry()
+    {
+        totalEntries++;
+    }
+
+    void StatisticsAccumulator::AddAttribute(const std::wstring& name, const std::vector<Value>& values)
+    {
+        attributeCount[name]++;
+
+        size_t ruleIndex = profile.IndexOf(name);
+        if (ruleIndex == StatisticsProfile::npos)
+            return;
+
+        const StatisticsRule& rule = profile.Rules()[ruleIndex];
+        StatisticsRuleState& state = states[ruleIndex];
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            const std::wstring& val = values[i];
+            if (rule.modes & STATS_UNIQUE)
+                state.unique.insert(values[i]);
+            if (rule.modes & (STATS_HISTOGRAM | STATS_TOPK))
+                state.counts[values[i]]++;
+            if (rule.modes & STATS_CARDINALITY)
+                HllAdd(state.registers, val);
+
+            if (rule.modes & STATS_FLAGS)
+            {
+                // Values from older snapshots are described bitmasks; those keep
+                // the number as their "0x..." prefix
+                unsigned int bits = static_cast<unsigned int>(values[i].kind() == ValueKind::INTEGER ?
+                    values[i].Number() : wcstoll(val.c_str(), nullptr, 0));
+                for (unsigned int bit = 0; bits != 0; ++bit, bits >>= 1)
+                {
+                    if (bits & 1) state.flagBits[bit]++;
+                }
+            }
+
+            if (rule.modes & STATS_TIMEHIST)
+            {
+                unsigned long long ticks = Converters::TimestampTicks(values[i]);
+                if (ticks == 0)
+                {
+                    state.neverCount++;
+                    continue;
+                }
+                long long ageDays = ticks >= nowTicks ? 0 : static_cast<long long>((nowTicks - ticks) / kTicksPerDay);
+                size_t bucket = 0;
+                while (bucket < rule.ageBucketsDays.size() && ageDays > rule.ageBucketsDays[bucket])
+                    ++bucket;
+                state.ageBuckets[bucket]++;
+            }
+        }
+    }
+
+    void StatisticsAccumulator::AddEntry(const Entry& entry)
+    {
+        BeginEntry();
+        for (const auto& attr : entry.attrs)
+        {
+            AddAttribute(attr.first, attr.second);
+        }
+    }
+
+    void StatisticsAccumulator::Merge(StatisticsAccumulator& other)
+    {
+        totalEntries += other.totalEntries;
+        for (const auto& attr : other.attributeCount)
+        {
+            attributeCount[attr.first] += attr.second;
+        }
+
+        for (size_t r = 0; r < states.size() && r < other.states.size(); ++r)
+        {
+            StatisticsRuleState& state = states[r];
+            StatisticsRuleState& from = other.states[r];
+
+            if (state.unique.empty()) state.unique.swap(from.unique);
+            else state.unique.insert(from.unique.begin(), from.unique.end());
+
+            if (state.counts.empty()) state.counts.swap(from.counts);
+            else for (const auto& c : from.counts) state.counts[c.first] += c.second;
+
+            for (size_t i = 0; i < state.registers.size() && i < from.registers.size(); ++i)
+                state.registers[i] = std::max(state.registers[i], from.registers[i]);
+            for (size_t i = 0; i < state.ageBuckets.size() && i < from.ageBuckets.size(); ++i)
+                state.ageBuckets[i] += from.ageBuckets[i];
+            state.neverCount += from.neverCount;
+            for (int bit = 0; bit < 32; ++bit)
+                state.flagBits[bit] += from.flagBits[bit];
+        }
+    }
+
+    Statistics StatisticsAccumulator::Finish()
+    {
+        Statistics stats;
+        stats.totalEntries = totalEntries;
+        stats.attributeCount.insert(attributeCount.begin(), attributeCount.end());
+
+        const std::vector<StatisticsRule>& rules = profile.Rules();
+        for (size_t r = 0; r < rules.size(); ++r)
+        {
+            const StatisticsRule& rule = rules[r];
+            StatisticsRuleState& state = states[r];
+
+            if (!state.unique.empty())
+            {
+                std::set<std::wstring>& unique = stats.uniqueValues[rule.attribute];
+                for (const auto& value : state.unique)
+                    unique.insert(Converters::DisplayValue(rule.attribute, value));
+            }
+
+            // Reports are read by people: values are described once per distinct value
+            std::map<std::wstring, int> described;
+            for (const auto& c : state.counts)
+                described[Converters::DisplayValue(rule.attribute, c.first)] += c.second;
+
+            if ((rule.modes & STATS_HISTOGRAM) && !described.empty())
+            {
+                // objectClass keeps its dedicated distribution used by the reports
+                std::map<std::wstring, int>& histogram = CaseInsensitiveEqual()(rule.attribute, L"objectClass") ?
+                    stats.objectClassCount : stats.valueHistograms[rule.attribute];
+                histogram.insert(described.begin(), described.end());
+            }
+
+            if ((rule.modes & STATS_TOPK) && !described.empty())
+            {
+                std::vector<std::pair<std::wstring, int>> top(described.begin(), described.end());
+                size_t k = std::min(rule.topK, top.size());
+                std::partial_sort(top.begin(), top.begin() + k, top.end(),
+                    [](const auto& a, const auto& b) { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+                top.resize(k);
+                stats.topValues[rule.attribute] = std::move(top);
+            }
+
+            if (rule.modes & STATS_CARDINALITY)
+            {
+                stats.cardinalityEstimates[rule.attribute] = HllEstimate(state.registers);
+            }
+
+            if (rule.modes & STATS_TIMEHIST)
+            {
+                int total = state.neverCount;
+                for (int n : state.ageBuckets) total += n;
+                if (total > 0)
+                {
+                    std::vector<std::pair<std::wstring, int>>& hist = stats.timeHistograms[rule.attribute];
+                    for (size_t b = 0; b < state.ageBuckets.size(); ++b)
+                        hist.emplace_back(AgeBucketLabel(rule.ageBucketsDays, b), state.ageBuckets[b]);
+                    if (state.neverCount > 0)
+                        hist.emplace_back(L"never", state.neverCount);
+                }
+            }
+
+            if (rule.modes & STATS_FLAGS)
+            {
+                for (unsigned int bit = 0; bit < 32; ++bit)
+                {
+                    if (state.flagBits[bit] > 0)
+                        stats.flagCounts[rule.attribute].emplace_back(
+                            Converters::GetFlagName(rule.attribute, bit), state.flagBits[bit]);
+                }
             }
         }
 
-        stats.totalAttributes = static_cast<int>(allAttrs.size());
+        stats.totalAttributes = static_cast<int>(stats.attributeCount.size());
         return stats;
     }
 
+    Statistics StatisticsCalculator::Calculate(const std::vector<Entry>& entries, const StatisticsProfile& profile)
+    {
+        StatisticsAccumulator accumulator(profile);
+        for (const auto& entry : entries)
+        {
+            accumulator.AddEntry(entry);
+        }
+        return accumulator.Finish();
+    }
+
+    Statistics StatisticsCalculator::CalculateParallel(const std::vector<Entry>& entries, unsigned int threadCount)
+    {
+        return CalculateParallel(entries, StatisticsProfile::Active(), threadCount);
+    }
+
+    Statistics StatisticsCalculator::CalculateParallel(const std::vector<Entry>& entries, const StatisticsProfile& profile,
+        unsigned int threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        // Small inputs are not worth the thread start-up
+        const size_t minEntriesPerThread = 4096;
+        size_t maxThreads = std::max<size_t>(1, entries.size() / minEntriesPerThread);
+        size_t partitions = std::min<size_t>(threadCount, maxThreads);
+
+        StatisticsAccumulator merged(profile);
+        if (partitions <= 1)
+        {
+            for (const auto& entry : entries)
+                merged.AddEntry(entry);
+            return merged.Finish();
+        }
+
+        // All partitions share one reference time so age buckets match the serial path
+        std::vector<StatisticsAccumulator> partials;
+        partials.reserve(partitions);
+        for (size_t p = 0; p < partitions; ++p)
+            partials.emplace_back(profile, merged.ReferenceTicks());
+
+        std::vector<std::thread> workers;
+        size_t chunk = (entries.size() + partitions - 1) / partitions;
+        for (size_t p = 0; p < partitions; ++p)
+        {
+            size_t begin = p * chunk;
+            size_t end = std::min(entries.size(), begin + chunk);
+            workers.emplace_back([&entries, &partials, p, begin, end]()
+            {
+                for (size_t i = begin; i < end; ++i)
+                    partials[p].AddEntry(entries[i]);
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+
+        for (auto& partial : partials)
+            merged.Merge(partial);
+        return merged.Finish();
+    }
+
     void StatisticsCalculator::PrintStatistics(const Statistics& stats)
     {
         std::wcout << L"\n╔═══════════════════════════════════════════════════════════════╗" << std::endl;
@@ -129,6 +582,72 @@ namespace LDAPUtils
             }
         }
 
+        if (!stats.valueHistograms.empty())
+        {
+            std::wcout << L"\n📊 Value Histograms:" << std::endl;
+            for (const auto& hist : stats.valueHistograms)
+            {
+                std::wcout << L"  " << hist.first << L":" << std::endl;
+                for (const auto& bucket : hist.second)
+                {
+                    std::wcout << L"      " << std::setw(30) << std::left << bucket.first
+                        << L": " << std::setw(6) << std::right << bucket.second << std::endl;
+                }
+            }
+        }
+
+        if (!stats.topValues.empty())
+        {
+            std::wcout << L"\n🏆 Top Values:" << std::endl;
+            for (const auto& top : stats.topValues)
+            {
+                std::wcout << L"  " << top.first << L":" << std::endl;
+                for (const auto& val : top.second)
+                {
+                    std::wcout << L"      " << std::setw(30) << std::left << val.first
+                        << L": " << std::setw(6) << std::right << val.second << std::endl;
+                }
+            }
+        }
+
+        if (!stats.timeHistograms.empty())
+        {
+            std::wcout << L"\n⏱️  Account Age Histograms:" << std::endl;
+            for (const auto& hist : stats.timeHistograms)
+            {
+                std::wcout << L"  " << hist.first << L":" << std::endl;
+                for (const auto& bucket : hist.second)
+                {
+                    std::wcout << L"      " << std::setw(30) << std::left << bucket.first
+                        << L": " << std::setw(6) << std::right << bucket.second << std::endl;
+                }
+            }
+        }
+
+        if (!stats.flagCounts.empty())
+        {
+            std::wcout << L"\n🚩 Flag Breakdown:" << std::endl;
+            for (const auto& flags : stats.flagCounts)
+            {
+                std::wcout << L"  " << flags.first << L":" << std::endl;
+                for (const auto& flag : flags.second)
+                {
+                    std::wcout << L"      " << std::setw(30) << std::left << flag.first
+                        << L": " << std::setw(6) << std::right << flag.second << std::endl;
+                }
+            }
+        }
+
+        if (!stats.cardinalityEstimates.empty())
+        {
+            std::wcout << L"\n🔢 Estimated Distinct Values:" << std::endl;
+            for (const auto& card : stats.cardinalityEstimates)
+            {
+                std::wcout << L"  " << std::setw(35) << std::left << card.first
+                    << L": ~" << card.second << std::endl;
+            }
+        }
+
         std::wcout << L"\n" << std::wstring(67, L'═') << std::endl;
     }
 
@@ -188,6 +707,56 @@ namespace LDAPUtils
             report << L"</ul>";
         }
 
+        for (const auto& hist : stats.valueHistograms)
+        {
+            report << L"<h3>" << hist.first << L" values</h3><ul>";
+            for (const auto& bucket : hist.second)
+            {
+                report << L"<li>" << bucket.first << L": <strong>" << bucket.second << L"</strong></li>";
+            }
+            report << L"</ul>";
+        }
+
+        for (const auto& top : stats.topValues)
+        {
+            report << L"<h3>Top " << top.first << L"</h3><ul>";
+            for (const auto& val : top.second)
+            {
+                report << L"<li>" << val.first << L": <strong>" << val.second << L"</strong></li>";
+            }
+            report << L"</ul>";
+        }
+
+        for (const auto& hist : stats.timeHistograms)
+        {
+            report << L"<h3>" << hist.first << L" age</h3><ul>";
+            for (const auto& bucket : hist.second)
+            {
+                report << L"<li>" << bucket.first << L": <strong>" << bucket.second << L"</strong></li>";
+            }
+            report << L"</ul>";
+        }
+
+        for (const auto& flags : stats.flagCounts)
+        {
+            report << L"<h3>" << flags.first << L" flags</h3><ul>";
+            for (const auto& flag : flags.second)
+            {
+                report << L"<li>" << flag.first << L": <strong>" << flag.second << L"</strong></li>";
+            }
+            report << L"</ul>";
+        }
+
+        if (!stats.cardinalityEstimates.empty())
+        {
+            report << L"<h3>Estimated Distinct Values</h3><ul>";
+            for (const auto& card : stats.cardinalityEstimates)
+            {
+                report << L"<li>" << card.first << L": <strong>~" << card.second << L"</strong></li>";
+            }
+            report << L"</ul>";
+        }
+
         report << L"</div>";
         return report.str();
     }
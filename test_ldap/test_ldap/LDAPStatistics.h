@@ -1,13 +1,110 @@
 #pragma once
 #include "LDAPTypes.h"
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace LDAPUtils
 {
+    // What to collect for a profiled attribute (can be combined)
+    enum StatisticsMode : unsigned int
+    {
+        STATS_UNIQUE = 0x1,         // Distinct value set
+        STATS_HISTOGRAM = 0x2,      // Value -> occurrence count
+        STATS_CARDINALITY = 0x4,    // HyperLogLog distinct-count estimate
+        STATS_TOPK = 0x8,           // K most frequent values
+        STATS_TIMEHIST = 0x10,      // Age histogram of a timestamp attribute
+        STATS_FLAGS = 0x20          // Per-bit counts of an integer bitmask
+    };
+
+    struct StatisticsRule
+    {
+        std::wstring attribute;
+        unsigned int modes = 0;
+        size_t topK = 10;
+        std::vector<int> ageBucketsDays;    // Ascending upper bounds, last bucket is "older"
+    };
+
+    struct CaseInsensitiveHash
+    {
+        size_t operator()(const std::wstring& s) const;
+    };
+
+    struct CaseInsensitiveEqual
+    {
+        bool operator()(const std::wstring& a, const std::wstring& b) const;
+    };
+
+    // Attribute rules compiled into a name -> rule index table, so the per-attribute
+    // cost in Calculate is a single hash probe instead of a chain of string compares.
+    class StatisticsProfile
+    {
+    private:
+        std::vector<StatisticsRule> rules;
+        std::unordered_map<std::wstring, size_t, CaseInsensitiveHash, CaseInsensitiveEqual> lookup;
+
+    public:
+        static const size_t npos = static_cast<size_t>(-1);
+
+        void AddRule(const StatisticsRule& rule);
+        size_t IndexOf(const std::wstring& attribute) const;
+        const std::vector<StatisticsRule>& Rules() const { return rules; }
+
+        // Profile file: one "attribute = mode[, mode...]" per line, '#' comments.
+        // Modes: unique, histogram, cardinality, topk[:N]
+        static bool LoadFromFile(const std::wstring& filename, StatisticsProfile& outProfile);
+        static StatisticsProfile Default();
+
+        static const StatisticsProfile& Active();
+        static void SetActive(const StatisticsProfile& profile);
+    };
+
+    struct StatisticsRuleState
+    {
+        // Keyed by stored value; Finish describes each distinct one once
+        std::unordered_set<Value, ValueHash> unique;
+        std::unordered_map<Value, int, ValueHash> counts;
+        std::vector<unsigned char> registers;
+        std::vector<int> ageBuckets;
+        int neverCount = 0;
+        int flagBits[32] = {};
+    };
+
+    // Streaming statistics: entries (or single attributes while a search is still
+    // decoding them) are fed one at a time, nothing is retained but the aggregates.
+    class StatisticsAccumulator
+    {
+    private:
+        const StatisticsProfile& profile;
+        int totalEntries = 0;
+        std::unordered_map<std::wstring, int> attributeCount;
+        std::vector<StatisticsRuleState> states;
+        unsigned long long nowTicks;
+
+    public:
+        // nowTicks pins the reference time for age buckets (0 = current time)
+        explicit StatisticsAccumulator(const StatisticsProfile& profile, unsigned long long nowTicks = 0);
+
+        void BeginEntry();
+        void AddAttribute(const std::wstring& name, const std::vector<Value>& values);
+        void AddEntry(const Entry& entry);
+        // Fold another accumulator built from the same profile into this one
+        void Merge(StatisticsAccumulator& other);
+        Statistics Finish();
+
+        unsigned long long ReferenceTicks() const { return nowTicks; }
+    };
+
     class StatisticsCalculator
     {
     public:
         static Statistics Calculate(const std::vector<Entry>& entries);
+        static Statistics Calculate(const std::vector<Entry>& entries, const StatisticsProfile& profile);
+        // Partitions entries across worker threads (0 = hardware concurrency), each
+        // aggregating into its own accumulator; results are identical to Calculate.
+        static Statistics CalculateParallel(const std::vector<Entry>& entries, unsigned int threadCount = 0);
+        static Statistics CalculateParallel(const std::vector<Entry>& entries, const StatisticsProfile& profile,
+            unsigned int threadCount = 0);
         static void PrintStatistics(const Statistics& stats);
         static std::wstring GenerateStatisticsReport(const Statistics& stats);
     };
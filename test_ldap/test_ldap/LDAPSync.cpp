@@ -0,0 +1,260 @@
+﻿#include "LDAPSync.h"
+#include "LDAPConverters.h"
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        std::wstring FirstValue(const Entry& entry, const std::wstring& name)
+        {
+            auto it = entry.attrs.find(name);
+            return (it != entry.attrs.end() && !it->second.empty()) ? it->second[0] : L"";
+        }
+
+        // Attributes the merge needs even when the caller asked for a narrower list
+        std::wstring WithSyncAttributes(const std::wstring& attributesStr)
+        {
+            if (attributesStr == L"*")
+                return attributesStr;
+
+            std::wstring result = attributesStr;
+            std::wstring lower = L"," + Converters::ToLower(attributesStr) + L",";
+            for (const wchar_t* required : { L"objectGUID", L"uSNChanged", L"isDeleted" })
+            {
+                if (lower.find(L"," + Converters::ToLower(required) + L",") == std::wstring::npos)
+                    result += std::wstring(L",") + required;
+            }
+            return result;
+        }
+
+        // Bare items without parentheses are accepted on the command line, as
+        // ldap_search does; they need them to be combined with another term
+        std::wstring Parenthesized(const std::wstring& filter)
+        {
+            size_t first = filter.find_first_not_of(L' ');
+            if (first == std::wstring::npos)
+                return L"(objectClass=*)";
+            return filter[first] == L'(' ? filter : L"(" + filter + L")";
+        }
+
+        // The rootDSE namingContexts value holding dn (the longest that is a suffix
+        // of it), or dn itself when none does
+        std::wstring NamingContextOf(const Entry& rootDse, const std::wstring& dn)
+        {
+            std::wstring lowerDn = Converters::ToLower(dn);
+            std::wstring best = dn;
+            size_t bestLength = 0;
+            auto it = rootDse.attrs.find(L"namingContexts");
+            if (it == rootDse.attrs.end())
+                return best;
+            for (const auto& value : it->second)
+            {
+                std::wstring context = Converters::ToLower(value);
+                if (context.empty() || context.size() > lowerDn.size() || context.size() <= bestLength)
+                    continue;
+                size_t offset = lowerDn.size() - context.size();
+                if (lowerDn.compare(offset, context.size(), context) == 0 && (offset == 0 || lowerDn[offset - 1] == L','))
+                {
+                    best = value;
+                    bestLength = context.size();
+                }
+            }
+            return best;
+        }
+
+        bool SameScope(const SyncState& state, const SearchConfig& config)
+        {
+            return Converters::ToLower(state.server) == Converters::ToLower(config.serverAddress) &&
+                Converters::ToLower(state.baseDN) == Converters::ToLower(config.baseDN) &&
+                state.filter == config.filter;
+        }
+    }
+
+    bool IncrementalSync::RunUsn(LDAPConnection& connection, const SearchConfig& config, SearchConfig& query,
+        Snapshot& snapshot, SyncSummary& summary)
+    {
+        // Read the DC's position before searching so changes committed during
+        // the search are picked up again next time rather than lost
+        Entry rootDse;
+        if (!connection.SearchByDN(L"", rootDse))
+        {
+            std::wcerr << L"Failed to read rootDSE" << std::endl;
+            return false;
+        }
+        unsigned long long highestUSN = wcstoull(FirstValue(rootDse, L"highestCommittedUSN").c_str(), nullptr, 10);
+
+        std::wstring invocationId;
+        Entry dsaEntry;
+        std::wstring dsServiceName = FirstValue(rootDse, L"dsServiceName");
+        if (!dsServiceName.empty() && connection.SearchByDN(dsServiceName, dsaEntry))
+            invocationId = FirstValue(dsaEntry, L"invocationId");
+
+        const SyncState& previous = snapshot.state;
+        summary.fullResync = summary.fullResync || invocationId.empty() || previous.invocationId != invocationId ||
+            previous.highestUSN == 0;
+
+        // Every matching change must come back, or the check for objects that
+        // left the result below would drop the ones cut off
+        query.sizeLimit = 0;
+        query.windowOffset = 0;
+        query.windowSize = 0;
+        query.windowValue.clear();
+
+        if (!summary.fullResync)
+        {
+            summary.fromUSN = previous.highestUSN;
+            std::wstringstream filter;
+            filter << L"(&" << Parenthesized(config.filter) << L"(uSNChanged>=" << (previous.highestUSN + 1) << L"))";
+            query.filter = filter.str();
+            query.showDeleted = true;
+        }
+        query.dirSyncCookieFile.clear();
+
+        std::vector<Entry> changes;
+        Statistics ignored;
+        if (summary.fullResync)
+            snapshot.Clear();
+        if (!connection.Search(query, changes, ignored))
+            return false;
+
+        std::unordered_set<std::wstring> returned;
+        for (auto& e : changes)
+        {
+            returned.insert(FirstValue(e, L"objectGUID"));
+            if (Converters::ToLower(FirstValue(e, L"isDeleted")) == L"true")
+            {
+                if (snapshot.Remove(e))
+                    ++summary.deleted;
+            }
+            else if (snapshot.Upsert(std::move(e)))
+            {
+                ++summary.updated;
+            }
+            else
+            {
+                ++summary.added;
+            }
+        }
+
+        if (!summary.fullResync)
+        {
+            // An object changed since the last sync that the filtered search did not
+            // return has stopped matching the filter, left the search scope or been
+            // deleted; tombstones live under CN=Deleted Objects at the naming context
+            // root. Its GUID is all that is needed to drop it, so ask the whole
+            // naming context, deleted objects included, for every changed GUID
+            SearchConfig left = query;
+            left.baseDN = NamingContextOf(rootDse, config.baseDN);
+            left.scope = 2;
+            left.filter = L"(uSNChanged>=" + std::to_wstring(previous.highestUSN + 1) + L")";
+            left.attributesStr = L"objectGUID";
+            left.sortKeys.clear();
+
+            std::vector<Entry> changed;
+            if (!connection.Search(left, changed, ignored))
+                return false;
+            for (const auto& e : changed)
+            {
+                if (returned.count(FirstValue(e, L"objectGUID")) == 0 && snapshot.Remove(e))
+                    ++summary.deleted;
+            }
+        }
+
+        snapshot.state.invocationId = invocationId;
+        snapshot.state.highestUSN = highestUSN;
+        snapshot.state.dirSyncCookie.clear();
+        summary.toUSN = highestUSN;
+        return true;
+    }
+
+    bool IncrementalSync::RunDirSync(LDAPConnection& connection, const SearchConfig& config, SearchConfig& query,
+        Snapshot& snapshot, SyncSummary& summary)
+    {
+        // The snapshot owns the cookie; the cookie file only carries it through
+        // Search, so an interrupted run restarts from the last saved snapshot
+        summary.dirSync = true;
+        summary.fullResync = summary.fullResync || snapshot.state.dirSyncCookie.empty();
+        if (summary.fullResync)
+            snapshot.Clear();
+
+        std::string cookie = summary.fullResync ? std::string() : snapshot.state.dirSyncCookie;
+        if (!LDAPConnection::SaveDirSyncCookie(config.dirSyncCookieFile, cookie))
+            return false;
+
+        std::vector<Entry> changes;
+        Statistics ignored;
+        if (!connection.Search(query, changes, ignored))
+            return false;
+
+        for (auto& e : changes)
+        {
+            if (Converters::ToLower(FirstValue(e, L"isDeleted")) == L"true")
+            {
+                if (snapshot.Remove(e))
+                    ++summary.deleted;
+            }
+            else if (snapshot.Merge(std::move(e)))
+            {
+                ++summary.updated;
+            }
+            else
+            {
+                ++summary.added;
+            }
+        }
+
+        if (!LDAPConnection::LoadDirSyncCookie(config.dirSyncCookieFile, snapshot.state.dirSyncCookie))
+        {
+            std::wcerr << L"Failed to read DirSync cookie: " << config.dirSyncCookieFile << std::endl;
+            return false;
+        }
+        snapshot.state.invocationId.clear();
+        snapshot.state.highestUSN = 0;
+        return true;
+    }
+
+    bool IncrementalSync::Run(LDAPConnection& connection, const SearchConfig& config, const std::wstring& snapshotFile,
+        Snapshot& outSnapshot, SyncSummary& outSummary)
+    {
+        outSummary = SyncSummary();
+
+        bool haveSnapshot = outSnapshot.Load(snapshotFile);
+        outSummary.fullResync = !haveSnapshot || !SameScope(outSnapshot.state, config);
+
+        SearchConfig query = config;
+        query.outputFile.clear();
+        query.format = OutputFormat::CONSOLE_ONLY;
+        query.quiet = true;
+        query.collectEntries = true;
+        query.attributesStr = WithSyncAttributes(config.attributesStr);
+
+        bool ok = config.dirSyncCookieFile.empty() ?
+            RunUsn(connection, config, query, outSnapshot, outSummary) :
+            RunDirSync(connection, config, query, outSnapshot, outSummary);
+        if (!ok)
+            return false;
+
+        outSnapshot.state.server = config.serverAddress;
+        outSnapshot.state.baseDN = config.baseDN;
+        outSnapshot.state.filter = config.filter;
+        return outSnapshot.Save(snapshotFile);
+    }
+
+    void IncrementalSync::PrintSummary(const SyncSummary& summary, size_t totalEntries)
+    {
+        std::wcout << L"\n🔄 Incremental Sync" << std::endl;
+        if (summary.dirSync)
+            std::wcout << L"  Mode: " << (summary.fullResync ? L"Full resync" : L"Delta") << L" (DirSync)" << std::endl;
+        else if (summary.fullResync)
+            std::wcout << L"  Mode: Full resync (USN 0 → " << summary.toUSN << L")" << std::endl;
+        else
+            std::wcout << L"  Mode: Delta (USN " << summary.fromUSN << L" → " << summary.toUSN << L")" << std::endl;
+        std::wcout << L"  Added: " << summary.added << std::endl;
+        std::wcout << L"  Updated: " << summary.updated << std::endl;
+        std::wcout << L"  Deleted: " << summary.deleted << std::endl;
+        std::wcout << L"  Snapshot entries: " << totalEntries << std::endl;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "LDAPTypes.h"
+#include "LDAPConnection.h"
+#include "LDAPSnapshot.h"
+
+namespace LDAPUtils
+{
+    struct SyncSummary
+    {
+        bool fullResync = false;
+        bool dirSync = false;
+        size_t added = 0;
+        size_t updated = 0;
+        size_t deleted = 0;
+        unsigned long long fromUSN = 0;
+        unsigned long long toUSN = 0;
+    };
+
+    // Brings a snapshot file up to date by asking only for entries whose
+    // uSNChanged is above the stored high-water mark, or with DirSync when
+    // config.dirSyncCookieFile is set. Falls back to a full search when the
+    // snapshot is missing or was taken against another DC, base DN or filter.
+    // USN mode searches config's scope without a size limit. Besides the
+    // filtered delta it lists the GUIDs of everything changed in the base DN's
+    // naming context, tombstones included, and drops snapshot entries among them
+    // that the delta did not return: deleted, no longer matching the filter, or
+    // moved out of the scope. When the rootDSE does not list that naming context,
+    // only the base DN's subtree is listed and deletions and moves out of it are
+    // missed. The scope is not stored; change it only with a new snapshot file.
+    class IncrementalSync
+    {
+    private:
+        static bool RunUsn(LDAPConnection& connection, const SearchConfig& config, SearchConfig& query,
+            Snapshot& snapshot, SyncSummary& summary);
+        static bool RunDirSync(LDAPConnection& connection, const SearchConfig& config, SearchConfig& query,
+            Snapshot& snapshot, SyncSummary& summary);
+
+    public:
+        static bool Run(LDAPConnection& connection, const SearchConfig& config, const std::wstring& snapshotFile,
+            Snapshot& outSnapshot, SyncSummary& outSummary);
+
+        static void PrintSummary(const SyncSummary& summary, size_t totalEntries);
+    };
+}
\ No newline at end of file
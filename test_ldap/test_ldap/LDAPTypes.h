@@ -1,4 +1,5 @@
 #pragma once
+#include "LDAPValue.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -16,6 +17,30 @@ namespace LDAPUtils
         CONSOLE_ONLY
     };
 
+    enum class HtmlLayout
+    {
+        AUTO,               // Virtual rows above Exporter::kVirtualHtmlRows entries
+        TABLE,              // One <tr> per entry
+        VIRTUAL,            // Data embedded once, only visible rows rendered
+        SHARDED             // Report directory: index page plus data shards loaded on demand
+    };
+
+    enum class HtmlShardKey
+    {
+        CONTAINER,          // Entries grouped by parent container (OU)
+        OBJECT_CLASS,       // Entries grouped by most specific objectClass
+        NONE                // Entries in result order
+    };
+
+    // How CSV, JSON and XML exports write typed values (see ValueKind); TXT,
+    // HTML, statistics and the console always describe them
+    enum class ValueStyle
+    {
+        AUTO,               // DISPLAY for CSV, RAW for JSON, XML and NDJSON
+        DISPLAY,            // Described: "0x200 = ( NORMAL_ACCOUNT )", local times, "<Binary 28 bytes>"
+        RAW                 // As stored: "512", generalized time, FILETIME ticks, base64 binary
+    };
+
     enum class SearchMode
     {
         STANDARD,           // Normal LDAP search
@@ -26,7 +51,9 @@ namespace LDAPUtils
     struct Entry
     {
         std::wstring dn;
-        std::map<std::wstring, std::vector<std::wstring>> attrs;
+        // Names and values are interned (see Value); std::less<> lets lookups take
+        // plain strings without interning them
+        std::map<Value, std::vector<Value>, std::less<>> attrs;
     };
 
     struct SearchConfig
@@ -46,6 +73,25 @@ namespace LDAPUtils
         std::wstring searchDN = L"";
         std::wstring searchAttribute = L"";
         std::wstring searchValue = L"";
+        std::wstring statsProfileFile = L"";
+        bool quiet = false;             // Suppress per-entry console output
+        bool showStats = false;         // Print the statistics Search accumulates (--stats)
+        bool collectEntries = false;    // Return entries even when not exporting
+        bool showDeleted = false;       // Include tombstones (show deleted objects control)
+        std::wstring dirSyncCookieFile = L"";   // Non-empty: DirSync change search resuming from this cookie
+        std::wstring sortKeys = L"";    // Server-side sort, e.g. "sn,-whenCreated" ('-' = descending)
+        unsigned long windowOffset = 0; // VLV window: 1-based position of the first row (0 = no window)
+        unsigned long windowSize = 0;   // VLV window: rows to return
+        std::wstring windowValue = L""; // VLV window starting at the first row whose first sort key >= value
+        unsigned long pageSize = 1000;  // Paged-results page size (the first page's size when adaptive)
+        bool adaptivePaging = false;    // Tune the page size from measured throughput, up to MaxPageSize
+        bool columnarSidecar = false;   // CSV: also write <output>.ldapcol for the CSV viewer
+        ValueStyle valueStyle = ValueStyle::AUTO;
+        bool loadSchema = true;         // Decode attributes by their schema syntax (Schema::Activate)
+        std::wstring schemaCacheFile = L"ldap_schema.cache";   // Empty: read the schema on every run
+        HtmlLayout htmlLayout = HtmlLayout::AUTO;
+        HtmlShardKey htmlShardBy = HtmlShardKey::CONTAINER; // SHARDED layout: how entries are grouped into shards
+        size_t htmlShardRows = 25000;   // SHARDED layout: most entries per shard
     };
 
     struct Statistics
@@ -55,5 +101,10 @@ namespace LDAPUtils
         std::map<std::wstring, int> attributeCount;
         std::map<std::wstring, int> objectClassCount;
         std::map<std::wstring, std::set<std::wstring>> uniqueValues;
+        std::map<std::wstring, std::map<std::wstring, int>> valueHistograms;
+        std::map<std::wstring, std::vector<std::pair<std::wstring, int>>> topValues;
+        std::map<std::wstring, unsigned long long> cardinalityEstimates;
+        std::map<std::wstring, std::vector<std::pair<std::wstring, int>>> timeHistograms;
+        std::map<std::wstring, std::vector<std::pair<std::wstring, int>>> flagCounts;
     };
 }
\ No newline at end of file
@@ -0,0 +1,181 @@
+﻿#include "LDAPValue.h"
+#include <mutex>
+#include <unordered_map>
+#include <cwchar>
+
+namespace LDAPUtils
+{
+    namespace
+    {
+        const size_t kShardCount = 64;
+
+        // The pool is split by hash so threads decoding entries in parallel
+        // rarely wait on each other
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_multimap<size_t, Value::Node*> nodes;    // Keyed by hash of the text
+        };
+
+        // Never destroyed: Values in static objects may be released after main
+        Shard* Shards()
+        {
+            static Shard* shards = new Shard[kShardCount];
+            return shards;
+        }
+
+        Shard& ShardOf(size_t hash)
+        {
+            return Shards()[(hash >> 16) % kShardCount];
+        }
+
+        // Generalized time (YYYYMMDDHHMMSS[.f]Z) as FILETIME ticks, matching
+        // SystemTimeToFileTime without a system call per value; 0 when malformed
+        long long TimeTicks(const std::wstring& text)
+        {
+            int field[6];
+            static const int kWidth[6] = { 4, 2, 2, 2, 2, 2 };
+            size_t pos = 0;
+            for (int f = 0; f < 6; ++f)
+            {
+                field[f] = 0;
+                for (int d = 0; d < kWidth[f]; ++d, ++pos)
+                {
+                    if (pos >= text.size() || text[pos] < L'0' || text[pos] > L'9')
+                        return 0;
+                    field[f] = field[f] * 10 + (text[pos] - L'0');
+                }
+            }
+            int year = field[0], month = field[1], day = field[2];
+            if (year < 1601 || month < 1 || month > 12 || day < 1 || day > 31 ||
+                field[3] > 23 || field[4] > 59 || field[5] > 59)
+                return 0;
+
+            // Days since 1601-01-01 (proleptic Gregorian, March-based years)
+            int y = month <= 2 ? year - 1 : year;
+            int era = y / 400;
+            int yearOfEra = y - era * 400;
+            int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            long long days = static_cast<long long>(era) * 146097 + dayOfEra - 584694;     // 1601-01-01 is day 584694 after 0000-03-01
+            long long seconds = days * 86400LL + field[3] * 3600LL + field[4] * 60LL + field[5];
+            return seconds * 10000000LL;
+        }
+
+        long long ParseNumber(const std::wstring& text, ValueKind kind)
+        {
+            switch (kind)
+            {
+            case ValueKind::INTEGER:
+            case ValueKind::FILETIME:
+                return wcstoll(text.c_str(), nullptr, 10);
+            case ValueKind::TIME:
+                return TimeTicks(text);
+            default:
+                return 0;
+            }
+        }
+    }
+
+    Value::Node* Value::Intern(const std::wstring& text, ValueKind kind)
+    {
+        size_t hash = std::hash<std::wstring>()(text);
+        Shard& shard = ShardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto range = shard.nodes.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second->kind == kind && it->second->text == text)
+            {
+                it->second->refs.fetch_add(1, std::memory_order_relaxed);
+                return it->second;
+            }
+        }
+        Node* node = new Node();
+        node->text = text;
+        node->hash = hash;
+        node->kind = kind;
+        node->number = ParseNumber(node->text, kind);
+        node->refs.store(1, std::memory_order_relaxed);
+        shard.nodes.emplace(hash, node);
+        return node;
+    }
+
+    Value::Node* Value::Intern(std::wstring&& text, ValueKind kind)
+    {
+        size_t hash = std::hash<std::wstring>()(text);
+        Shard& shard = ShardOf(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto range = shard.nodes.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second->kind == kind && it->second->text == text)
+            {
+                it->second->refs.fetch_add(1, std::memory_order_relaxed);
+                return it->second;
+            }
+        }
+        Node* node = new Node();
+        node->text = std::move(text);
+        node->text.shrink_to_fit();
+        node->hash = hash;
+        node->kind = kind;
+        node->number = ParseNumber(node->text, kind);
+        node->refs.store(1, std::memory_order_relaxed);
+        shard.nodes.emplace(hash, node);
+        return node;
+    }
+
+    void Value::Release(Node* node)
+    {
+        // Only the last reference takes the lock; Intern can hand out a node
+        // again only while holding it, so the count cannot rise from zero behind
+        // our back
+        unsigned int refs = node->refs.load(std::memory_order_relaxed);
+        while (refs > 1)
+        {
+            if (node->refs.compare_exchange_weak(refs, refs - 1, std::memory_order_acq_rel))
+                return;
+        }
+
+        Shard& shard = ShardOf(node->hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        auto range = shard.nodes.equal_range(node->hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == node)
+            {
+                shard.nodes.erase(it);
+                break;
+            }
+        }
+        delete node;
+    }
+
+    const std::wstring& Value::Empty()
+    {
+        static const std::wstring* empty = new std::wstring();
+        return *empty;
+    }
+
+    Value::PoolStats Value::Stats()
+    {
+        PoolStats stats;
+        for (size_t k = 0; k < kShardCount; ++k)
+        {
+            Shard& shard = Shards()[k];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.values += shard.nodes.size();
+            for (const auto& item : shard.nodes)
+            {
+                const std::wstring& text = item.second->text;
+                stats.bytes += sizeof(Node) + 2 * sizeof(void*) + sizeof(size_t);   // Node and its map entry
+                if (text.capacity() > std::wstring().capacity())
+                    stats.bytes += (text.capacity() + 1) * sizeof(wchar_t);
+            }
+        }
+        return stats;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <ostream>
+
+namespace LDAPUtils
+{
+    // What a value's text holds. Values are kept as the server sent them and
+    // only described for people when a sink asks (Converters::DisplayValue)
+    enum class ValueKind : unsigned char
+    {
+        TEXT,               // String value
+        INTEGER,            // Decimal integer; flags and codes are named per attribute
+        TIME,               // Generalized time, YYYYMMDDHHMMSS.0Z
+        FILETIME,           // Decimal 100 ns intervals since 1601, 0 = never
+        GUID,               // String form of a binary GUID
+        SID,                // S-1-... form of a binary SID
+        BINARY              // Base64 of any other binary value
+    };
+
+    // Attribute name or value interned in a process-wide pool. Equal strings
+    // share one pooled copy, so the objectClass chains, categories, flags and
+    // timestamps repeated across a result cost a pointer per entry instead of a
+    // heap string each. The copy lives as long as any Value refers to it; the
+    // handle is stable for that time and equal values compare by pointer. A
+    // value is its text and kind: "4" as text and as an integer are two values.
+    class Value
+    {
+    public:
+        struct Node
+        {
+            std::wstring text;
+            size_t hash = 0;
+            std::atomic<unsigned int> refs;
+            ValueKind kind = ValueKind::TEXT;
+            long long number = 0;       // See Number(); parsed once when interned
+        };
+
+        // Pool contents, for memory reports
+        struct PoolStats
+        {
+            size_t values = 0;          // Distinct strings alive
+            size_t bytes = 0;           // Their nodes and character buffers
+        };
+
+    private:
+        Node* node = nullptr;           // nullptr is the empty string
+
+        static Node* Intern(std::wstring&& text, ValueKind kind);
+        static Node* Intern(const std::wstring& text, ValueKind kind);
+        static void Release(Node* node);
+        static const std::wstring& Empty();
+
+    public:
+        Value() = default;
+        Value(const std::wstring& text, ValueKind kind = ValueKind::TEXT) : node(text.empty() ? nullptr : Intern(text, kind)) {}
+        Value(std::wstring&& text, ValueKind kind = ValueKind::TEXT) : node(text.empty() ? nullptr : Intern(std::move(text), kind)) {}
+        Value(const wchar_t* text, ValueKind kind = ValueKind::TEXT) : Value(std::wstring(text), kind) {}
+        Value(const Value& other) : node(other.node)
+        {
+            if (node)
+                node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        Value(Value&& other) noexcept : node(other.node) { other.node = nullptr; }
+        ~Value()
+        {
+            if (node)
+                Release(node);
+        }
+
+        Value& operator=(Value other) noexcept
+        {
+            std::swap(node, other.node);
+            return *this;
+        }
+
+        const std::wstring& str() const { return node ? node->text : Empty(); }
+        operator const std::wstring&() const { return str(); }
+        const wchar_t* c_str() const { return str().c_str(); }
+        size_t size() const { return str().size(); }
+        size_t length() const { return str().size(); }
+        bool empty() const { return node == nullptr; }
+        ValueKind kind() const { return node ? node->kind : ValueKind::TEXT; }
+        // INTEGER and FILETIME values as numbers, TIME values as FILETIME ticks
+        // (UTC); 0 for other kinds and text that does not parse
+        long long Number() const { return node ? node->number : 0; }
+        wchar_t operator[](size_t pos) const { return str()[pos]; }
+
+        // Identifies the pooled copy: equal values have equal handles
+        const void* Handle() const { return node; }
+        size_t Hash() const { return node ? node->hash : 0; }
+
+        static PoolStats Stats();
+
+        friend bool operator==(const Value& a, const Value& b) { return a.node == b.node; }
+        friend bool operator!=(const Value& a, const Value& b) { return a.node != b.node; }
+        // By text, then kind: the pool keeps one node per text and kind, so this
+        // orders exactly the values == tells apart
+        friend bool operator<(const Value& a, const Value& b)
+        {
+            if (a.node == b.node)
+                return false;
+            int order = a.str().compare(b.str());
+            return order != 0 ? order < 0 : a.kind() < b.kind();
+        }
+    };
+
+    // Mixed comparisons, so maps keyed by Value can be searched with plain strings
+    inline bool operator==(const Value& a, const std::wstring& b) { return a.str() == b; }
+    inline bool operator==(const std::wstring& a, const Value& b) { return a == b.str(); }
+    inline bool operator==(const Value& a, const wchar_t* b) { return a.str() == b; }
+    inline bool operator==(const wchar_t* a, const Value& b) { return a == b.str(); }
+    inline bool operator!=(const Value& a, const std::wstring& b) { return a.str() != b; }
+    inline bool operator!=(const std::wstring& a, const Value& b) { return a != b.str(); }
+    inline bool operator!=(const Value& a, const wchar_t* b) { return a.str() != b; }
+    inline bool operator!=(const wchar_t* a, const Value& b) { return a != b.str(); }
+    inline bool operator<(const Value& a, const std::wstring& b) { return a.str() < b; }
+    inline bool operator<(const std::wstring& a, const Value& b) { return a < b.str(); }
+    inline bool operator<(const Value& a, const wchar_t* b) { return a.str().compare(b) < 0; }
+    inline bool operator<(const wchar_t* a, const Value& b) { return b.str().compare(a) > 0; }
+
+    inline std::wostream& operator<<(std::wostream& out, const Value& value)
+    {
+        return out << value.str();
+    }
+
+    struct ValueHash
+    {
+        size_t operator()(const Value& value) const { return value.Hash(); }
+    };
+}
\ No newline at end of file
@@ -2,12 +2,734 @@
 #include "LDAPConnection.h"
 #include "LDAPConverters.h"
 #include "LDAPStatistics.h"
+#include "LDAPExporter.h"
+#include "LDAPBatch.h"
+#include "LDAPService.h"
+#include "LDAPSync.h"
+#include "LDAPSnapshot.h"
+#include "LDAPFilter.h"
+#include "LDAPLdif.h"
+#include "LDAPDnTree.h"
+#include "LDAPGroups.h"
+#include "LDAPPaging.h"
+#include "LDAPCompress.h"
+#include "LDAPSchema.h"
 #include <iostream>
 #include <fcntl.h>
 #include <io.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <sstream>
+#include <functional>
+#include <iomanip>
 
 using namespace LDAPUtils;
 
+// Directory-shaped synthetic entries for offline benchmarks
+std::vector<Entry> GenerateSyntheticEntries(size_t count)
+{
+    std::mt19937 rng(42);
+    std::vector<Entry> entries;
+    entries.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Entry e;
+        std::wstring name = L"user" + std::to_wstring(i);
+        std::wstring ou = L"OU=Dept" + std::to_wstring(rng() % 50);
+        e.dn = L"CN=" + name + L"," + ou + L",DC=labrecon,DC=com";
+
+        bool isComputer = (rng() % 10) == 0;
+        e.attrs[L"objectClass"] = isComputer ?
+            std::vector<Value>{ L"top", L"person", L"organizationalPerson", L"user", L"computer" } :
+            std::vector<Value>{ L"top", L"person", L"organizationalPerson", L"user" };
+        e.attrs[L"cn"] = { name };
+        e.attrs[L"sAMAccountName"] = { name };
+        e.attrs[L"instanceType"] = { Value(L"4", ValueKind::INTEGER) };
+        e.attrs[L"objectCategory"] = { L"CN=Person,CN=Schema,CN=Configuration,DC=labrecon,DC=com" };
+        e.attrs[L"sAMAccountType"] = { Value(isComputer ? L"805306369" : L"805306368", ValueKind::INTEGER) };
+        e.attrs[L"userAccountControl"] = { Value((rng() % 8) == 0 ? L"514" : L"512", ValueKind::INTEGER) };
+        e.attrs[L"department"] = { L"Department " + std::to_wstring(rng() % 40) };
+        e.attrs[L"title"] = { L"Title " + std::to_wstring(rng() % 60) };
+        e.attrs[L"mail"] = { name + L"@labrecon.com" };
+
+        wchar_t when[32];
+        unsigned int month = 1 + rng() % 12, day = 1 + rng() % 28, year = 2015 + rng() % 11, minute = rng() % 60;
+        swprintf(when, 32, L"%u%02u%02u10%02u00.0Z", year, month, day, minute);
+        e.attrs[L"whenCreated"] = { Value(when, ValueKind::TIME) };
+        e.attrs[L"whenChanged"] = { Value(when, ValueKind::TIME) };
+        e.attrs[L"lastLogonTimestamp"] = { Value(std::to_wstring((rng() % 5) == 0 ? 0ULL : Converters::ParseTimestampTicks(when)),
+            ValueKind::FILETIME) };
+        e.attrs[L"pwdLastSet"] = { Value(std::to_wstring(133000000000000000ULL + (rng() % 150000) * 10000000000ULL),
+            ValueKind::FILETIME) };
+        e.attrs[L"memberOf"] = { L"CN=Group" + std::to_wstring(rng() % 200) + L",OU=Groups,DC=labrecon,DC=com" };
+        e.attrs[L"dSCorePropagationData"] = (i % 3) == 0 ?
+            std::vector<Value>{ L"20210714091240.0Z", L"16010101000001.0Z" } :
+            std::vector<Value>{ L"16010101000001.0Z" };
+
+        entries.push_back(std::move(e));
+    }
+    return entries;
+}
+
+int RunStatisticsBenchmark(size_t count)
+{
+    std::wcout << L"Generating " << count << L" synthetic entries..." << std::endl;
+    std::vector<Entry> entries = GenerateSyntheticEntries(count);
+
+    auto start = std::chrono::steady_clock::now();
+    Statistics serial = StatisticsCalculator::Calculate(entries);
+    auto mid = std::chrono::steady_clock::now();
+    Statistics parallel = StatisticsCalculator::CalculateParallel(entries);
+    auto end = std::chrono::steady_clock::now();
+
+    double serialMs = std::chrono::duration<double, std::milli>(mid - start).count();
+    double parallelMs = std::chrono::duration<double, std::milli>(end - mid).count();
+
+    bool identical = serial.totalEntries == parallel.totalEntries &&
+        serial.totalAttributes == parallel.totalAttributes &&
+        serial.attributeCount == parallel.attributeCount &&
+        serial.objectClassCount == parallel.objectClassCount &&
+        serial.uniqueValues == parallel.uniqueValues &&
+        serial.valueHistograms == parallel.valueHistograms &&
+        serial.topValues == parallel.topValues &&
+        serial.cardinalityEstimates == parallel.cardinalityEstimates &&
+        serial.timeHistograms == parallel.timeHistograms &&
+        serial.flagCounts == parallel.flagCounts;
+
+    std::wcout << L"  Serial:   " << serialMs << L" ms" << std::endl;
+    std::wcout << L"  Parallel: " << parallelMs << L" ms (" << std::thread::hardware_concurrency() << L" threads, "
+        << (parallelMs > 0 ? serialMs / parallelMs : 0.0) << L"x)" << std::endl;
+    std::wcout << L"  Results identical: " << (identical ? L"yes" : L"NO") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// Attribute storage of synthetic entries as interned Values against the same
+// entries holding a std::wstring per name and value. DNs and map nodes are the
+// same either way and left out; heap strings count requested bytes only, so
+// allocator headers would widen the gap further.
+int RunMemoryBenchmark(size_t count)
+{
+    std::wcout << L"Generating " << count << L" synthetic entries..." << std::endl;
+    std::vector<Entry> entries = GenerateSyntheticEntries(count);
+
+    const size_t inlineCapacity = std::wstring().capacity();
+    auto heapBytes = [&](const std::wstring& text) -> size_t
+    {
+        return text.size() > inlineCapacity ? (std::wstring(text).capacity() + 1) * sizeof(wchar_t) : 0;
+    };
+
+    size_t occurrences = 0;
+    unsigned long long plainBytes = 0;
+    unsigned long long internedBytes = 0;
+    for (const auto& e : entries)
+    {
+        for (const auto& attr : e.attrs)
+        {
+            plainBytes += sizeof(std::wstring) + heapBytes(attr.first) +
+                sizeof(std::vector<std::wstring>) + attr.second.capacity() * sizeof(std::wstring);
+            internedBytes += sizeof(Value) + sizeof(std::vector<Value>) + attr.second.capacity() * sizeof(Value);
+            for (const auto& value : attr.second)
+                plainBytes += heapBytes(value);
+            occurrences += 1 + attr.second.size();
+        }
+    }
+    Value::PoolStats pool = Value::Stats();
+    internedBytes += pool.bytes;
+
+    const double mb = 1024.0 * 1024.0;
+    std::wcout << std::fixed << std::setprecision(1);
+    std::wcout << L"  Names and values: " << occurrences << L" stored, " << pool.values << L" distinct" << std::endl;
+    std::wcout << L"  One string each:  " << plainBytes / mb << L" MB" << std::endl;
+    std::wcout << L"  Interned:         " << internedBytes / mb << L" MB (pool " << pool.bytes / mb << L" MB)" << std::endl;
+    std::wcout << L"  Reduction:        " << (plainBytes > 0 ? 100.0 * (1.0 - double(internedBytes) / plainBytes) : 0.0)
+        << L"%" << std::endl;
+    return 0;
+}
+
+void PrintEntry(const Entry& entry)
+{
+    std::wcout << L"\nDN: " << entry.dn << std::endl;
+    for (const auto& attr : entry.attrs)
+    {
+        std::wcout << L"  " << attr.first << L": ";
+        for (size_t i = 0; i < attr.second.size(); ++i)
+        {
+            if (i > 0) std::wcout << L"; ";
+            std::wcout << Converters::DisplayValue(attr.first, attr.second[i]);
+        }
+        std::wcout << std::endl;
+    }
+}
+
+// Prints or exports results that were answered without the directory
+void OutputResults(const SearchConfig& config, const std::vector<Entry>& results, bool showStats)
+{
+    Statistics stats;
+    if (showStats || config.format == OutputFormat::HTML)
+    {
+        stats = StatisticsCalculator::CalculateParallel(results);
+    }
+    if (showStats)
+    {
+        StatisticsCalculator::PrintStatistics(stats);
+    }
+
+    if (config.format == OutputFormat::CONSOLE_ONLY)
+    {
+        if (!showStats)
+        {
+            for (const auto& e : results)
+                PrintEntry(e);
+        }
+    }
+    else if (!results.empty())
+    {
+        std::vector<std::wstring> exportAttributes = Exporter::AttributeNames(results);
+        Exporter::Export(config, exportAttributes, results, stats);
+    }
+}
+
+// (attr=value) for --search-attr, otherwise -f
+std::wstring OfflineFilterText(const SearchConfig& config)
+{
+    return config.searchMode == SearchMode::BY_ATTRIBUTE ?
+        L"(" + config.searchAttribute + L"=" + config.searchValue + L")" : config.filter;
+}
+
+// Answers --search-dn / --search-attr from the secondary indexes of a snapshot
+// saved less than maxAgeSeconds ago from the same server under a base DN that
+// covers the query. Returns false to fall back to the directory: the snapshot is
+// missing, stale or foreign, the attribute is not indexed, or nothing matched.
+bool LookupInSnapshot(const SearchConfig& config, const std::wstring& snapshotFile, long long maxAgeSeconds,
+    std::vector<Entry>& outResults)
+{
+    SnapshotView view;
+    if (!view.Open(snapshotFile))
+        return false;
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    unsigned long long nowTicks = (static_cast<unsigned long long>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    if (view.SavedAt() == 0 ||
+        (nowTicks > view.SavedAt() && nowTicks - view.SavedAt() > static_cast<unsigned long long>(maxAgeSeconds) * 10000000ULL))
+    {
+        std::wcout << L"  Snapshot " << snapshotFile << L" is older than " << maxAgeSeconds << L" s" << std::endl;
+        return false;
+    }
+    if (_wcsicmp(view.State().server.c_str(), config.serverAddress.c_str()) != 0)
+        return false;
+
+    outResults.clear();
+    if (config.searchMode == SearchMode::BY_DN)
+    {
+        Entry entry;
+        if (view.FindByDN(config.searchDN, entry))
+            outResults.push_back(std::move(entry));
+        return !outResults.empty();
+    }
+
+    if (!Filter::InScope(config.baseDN, view.State().baseDN, 2))
+        return false;
+
+    Filter filter;
+    std::wstring error;
+    if (!Filter::Parse(OfflineFilterText(config), filter, error))
+        return false;
+    filter.Bind(view.AttributeNames());
+    return filter.SelectIndexed(view, config.baseDN, config.scope, outResults) && !outResults.empty();
+}
+
+// Answers the query from a saved snapshot or LDIF file instead of the directory
+int RunOffline(const SearchConfig& config, const std::wstring& sourceFile, bool isLdif, bool showStats, bool showCounts)
+{
+    auto start = std::chrono::steady_clock::now();
+    SnapshotView view;
+    std::vector<Entry> entries;
+    std::vector<std::wstring> attributeNames;
+
+    if (isLdif)
+    {
+        Schema::Activate(nullptr, config, false);
+        if (!LdifReader::Load(sourceFile, entries, attributeNames))
+            return 1;
+        std::wcout << L"📄 LDIF: " << sourceFile << std::endl;
+        std::wcout << L"  Entries: " << entries.size() << L", attributes: " << attributeNames.size() << std::endl;
+    }
+    else
+    {
+        if (!view.Open(sourceFile))
+            return 1;
+        attributeNames = view.AttributeNames();
+        std::wcout << L"📦 Snapshot: " << sourceFile << std::endl;
+        std::wcout << L"  Source: " << view.State().server << L" / " << view.State().baseDN << L" / "
+            << view.State().filter << std::endl;
+        std::wcout << L"  Entries: " << view.Size() << L", attributes: " << attributeNames.size()
+            << L", " << view.FileSize() / 1024 << L" KB" << std::endl;
+    }
+    auto opened = std::chrono::steady_clock::now();
+
+    std::vector<Entry> results;
+    if (config.searchMode == SearchMode::BY_DN)
+    {
+        Entry entry;
+        if (!isLdif && view.FindByDN(config.searchDN, entry))
+        {
+            results.push_back(std::move(entry));
+        }
+        else if (isLdif)
+        {
+            for (auto& e : entries)
+            {
+                if (_wcsicmp(e.dn.c_str(), config.searchDN.c_str()) == 0)
+                {
+                    results.push_back(std::move(e));
+                    break;
+                }
+            }
+        }
+        if (results.empty())
+            std::wcerr << L"✗ DN not found." << std::endl;
+    }
+    else
+    {
+        // --search-attr is the same (attr=value) filter the online path sends
+        std::wstring filterText = OfflineFilterText(config);
+
+        Filter filter;
+        std::wstring error;
+        if (!Filter::Parse(filterText, filter, error))
+        {
+            std::wcerr << L"✗ Invalid filter " << filterText << L": " << error << std::endl;
+            return 1;
+        }
+        filter.Bind(attributeNames);
+
+        // Secondary indexes avoid decoding the whole snapshot when they cover a term
+        auto decoded = std::chrono::steady_clock::now();
+        bool indexed = !isLdif && filter.SelectIndexed(view, config.baseDN, config.scope, results);
+        if (!indexed)
+        {
+            if (!isLdif)
+                entries = view.Materialize();
+            DnTree tree;
+            for (size_t i = 0; i < entries.size(); ++i)
+                tree.Insert(entries[i].dn, i);
+            decoded = std::chrono::steady_clock::now();
+
+            std::vector<size_t> matches = filter.Select(entries, tree, config.baseDN, config.scope);
+            results.reserve(matches.size());
+            for (size_t i : matches)
+                results.push_back(std::move(entries[i]));
+        }
+
+        std::wcout << L"  Filter: " << filterText << L" matched " << results.size() << L" in "
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decoded).count()
+            << L" ms" << (indexed ? L" (indexed)" : L"") << std::endl;
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    std::wcout << L"  Opened in " << std::chrono::duration<double, std::milli>(opened - start).count()
+        << L" ms, answered in " << std::chrono::duration<double, std::milli>(loaded - opened).count()
+        << L" ms" << std::endl;
+
+    OutputResults(config, results, showStats);
+    if (showCounts)
+    {
+        DnTree resultTree;
+        for (size_t i = 0; i < results.size(); ++i)
+            resultTree.Insert(results[i].dn, i);
+        DnTree::PrintCounts(resultTree.Counts(config.baseDN));
+    }
+    return 0;
+}
+
+// Times filter evaluation over synthetic entries, scanning and with an equality index
+int RunFilterBenchmark(size_t count)
+{
+    std::wcout << L"Generating " << count << L" synthetic entries..." << std::endl;
+    std::vector<Entry> entries = GenerateSyntheticEntries(count);
+    std::vector<std::wstring> attributeNames = Exporter::AttributeNames(entries);
+
+    auto indexStart = std::chrono::steady_clock::now();
+    FilterIndex index;
+    index.Build(entries, { L"sAMAccountName", L"department" });
+    double indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - indexStart).count();
+    std::wcout << L"  Index build (sAMAccountName, department): " << indexMs << L" ms" << std::endl;
+
+    const wchar_t* filters[] = {
+        L"(&(objectClass=user)(!(userAccountControl:1.2.840.113556.1.4.803:=2)))",
+        L"(&(objectCategory=person)(objectClass=user)(department=Department 7))",
+        L"(|(sAMAccountName=user12*)(cn=*99))",
+        L"(pwdLastSet>=133500000000000000)",
+        L"(sAMAccountName=user4242)"
+    };
+
+    bool consistent = true;
+    for (const wchar_t* text : filters)
+    {
+        Filter filter;
+        std::wstring error;
+        if (!Filter::Parse(text, filter, error))
+        {
+            std::wcerr << L"✗ " << text << L": " << error << std::endl;
+            return 1;
+        }
+        filter.Bind(attributeNames);
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<size_t> scanned = filter.Select(entries, L"", 2);
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<size_t> indexed = filter.Select(entries, L"", 2, &index);
+        auto t2 = std::chrono::steady_clock::now();
+        consistent = consistent && scanned == indexed;
+
+        std::wcout << L"  " << text << std::endl << L"    " << scanned.size() << L" matches, scan "
+            << std::chrono::duration<double, std::milli>(t1 - t0).count() << L" ms, indexed "
+            << std::chrono::duration<double, std::milli>(t2 - t1).count() << L" ms" << std::endl;
+    }
+    std::wcout << L"  Scan and index results identical: " << (consistent ? L"yes" : L"NO") << std::endl;
+
+    // Scope through the DN tree vs comparing every DN against the base
+    auto treeStart = std::chrono::steady_clock::now();
+    DnTree tree;
+    for (size_t i = 0; i < entries.size(); ++i)
+        tree.Insert(entries[i].dn, i);
+    std::wcout << L"  DN tree build: " << std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - treeStart).count() << L" ms, " << tree.NodeCount() << L" nodes" << std::endl;
+
+    Filter all;
+    std::wstring error;
+    Filter::Parse(L"(objectClass=*)", all, error);
+    const std::pair<std::wstring, unsigned long> scopes[] = {
+        { L"OU=Dept7,DC=labrecon,DC=com", 1 }, { entries[entries.size() / 2].dn, 0 }, { L"DC=labrecon,DC=com", 2 } };
+    for (const auto& scope : scopes)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<size_t> scanned = all.Select(entries, scope.first, scope.second);
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<size_t> walked = all.Select(entries, tree, scope.first, scope.second);
+        auto t2 = std::chrono::steady_clock::now();
+        consistent = consistent && scanned == walked;
+
+        std::wcout << L"  scope " << scope.second << L" " << scope.first << L": " << walked.size() << L" entries, scan "
+            << std::chrono::duration<double, std::milli>(t1 - t0).count() << L" ms, tree "
+            << std::chrono::duration<double, std::milli>(t2 - t1).count() << L" ms" << std::endl;
+    }
+    std::wcout << L"  Scan and tree scopes identical: " << (consistent ? L"yes" : L"NO") << std::endl;
+    return consistent ? 0 : 1;
+}
+
+// Times snapshot secondary index lookups against the linear alternatives
+int RunIndexBenchmark(size_t count)
+{
+    std::wcout << L"Generating " << count << L" synthetic entries..." << std::endl;
+    std::vector<Entry> entries = GenerateSyntheticEntries(count);
+    std::wstring file = L"bench_index.snap";
+
+    SyncState source;
+    source.server = L"benchmark";
+    auto saveStart = std::chrono::steady_clock::now();
+    if (!Snapshot::Save(file, source, entries))
+        return 1;
+    std::wcout << L"  Save with indexes: " << std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - saveStart).count() << L" ms" << std::endl;
+
+    SnapshotView view;
+    if (!view.Open(file))
+        return 1;
+
+    const int lookups = 1000;
+    std::mt19937 rng(7);
+    bool consistent = true;
+    auto timeLookups = [&](const wchar_t* label, const std::function<std::wstring(size_t)>& filterFor)
+    {
+        double totalUs = 0;
+        for (int n = 0; n < lookups; ++n)
+        {
+            size_t target = rng() % count;
+            auto t0 = std::chrono::steady_clock::now();
+            Filter filter;
+            std::wstring error;
+            Filter::Parse(filterFor(target), filter, error);
+            filter.Bind(view.AttributeNames());
+            std::vector<Entry> results;
+            bool indexed = filter.SelectIndexed(view, L"", 2, results);
+            totalUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            consistent = consistent && indexed && results.size() == 1 && results[0].dn == entries[target].dn;
+        }
+        std::wcout << L"  " << label << L": " << totalUs / lookups << L" us per lookup" << std::endl;
+    };
+
+    timeLookups(L"sAMAccountName", [&](size_t i) { return L"(sAMAccountName=USER" + std::to_wstring(i) + L")"; });
+    timeLookups(L"mail", [&](size_t i) { return L"(mail=" + entries[i].attrs[L"mail"][0].str() + L")"; });
+
+    double dnUs = 0;
+    for (int n = 0; n < lookups; ++n)
+    {
+        size_t target = rng() % count;
+        Entry entry;
+        auto t0 = std::chrono::steady_clock::now();
+        bool found = view.FindByDN(entries[target].dn, entry);
+        dnUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        consistent = consistent && found && entry.dn == entries[target].dn;
+    }
+    std::wcout << L"  DN: " << dnUs / lookups << L" us per lookup" << std::endl;
+
+    // Range query through the index vs decoding and scanning everything
+    const wchar_t* rangeText = L"(&(whenCreated>=20250101000000.0Z)(whenCreated<=20250201000000.0Z))";
+    Filter range;
+    std::wstring error;
+    Filter::Parse(rangeText, range, error);
+    range.Bind(view.AttributeNames());
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Entry> rangeResults;
+    bool rangeIndexed = range.SelectIndexed(view, L"", 2, rangeResults);
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<Entry> all = view.Materialize();
+    std::vector<size_t> scanned = range.Select(all, L"", 2);
+    auto t2 = std::chrono::steady_clock::now();
+    consistent = consistent && rangeIndexed && scanned.size() == rangeResults.size();
+
+    std::wcout << L"  " << rangeText << std::endl << L"    " << rangeResults.size() << L" matches, indexed "
+        << std::chrono::duration<double, std::milli>(t1 - t0).count() << L" ms, decode and scan "
+        << std::chrono::duration<double, std::milli>(t2 - t1).count() << L" ms" << std::endl;
+    std::wcout << L"  Index and scan results identical: " << (consistent ? L"yes" : L"NO") << std::endl;
+
+    view.Close();
+    DeleteFileW(file.c_str());
+    return consistent ? 0 : 1;
+}
+
+// Entries for membership analysis: the whole snapshot or LDIF file, otherwise a
+// live search that makes sure the membership attributes are requested
+bool LoadGroupSource(const SearchConfig& config, const std::wstring& snapshotFile, const std::wstring& ldifFile,
+    std::vector<Entry>& outEntries)
+{
+    if (!ldifFile.empty())
+    {
+        std::vector<std::wstring> attributeNames;
+        Schema::Activate(nullptr, config, false);
+        return LdifReader::Load(ldifFile, outEntries, attributeNames);
+    }
+    if (!snapshotFile.empty())
+    {
+        SnapshotView view;
+        if (!view.Open(snapshotFile))
+            return false;
+        outEntries = view.Materialize();
+        return outEntries.size() == view.Size();
+    }
+
+    // Nesting crosses containers; a one-level search would leave most groups out
+    SearchConfig query = config;
+    query.scope = 2;
+    query.quiet = true;
+    query.collectEntries = true;
+    query.format = OutputFormat::CONSOLE_ONLY;
+    if (query.attributesStr != L"*")
+        query.attributesStr += L",member,memberOf,primaryGroupID,objectSid,objectClass,sAMAccountName";
+
+    LDAPConnection ldap(config.serverAddress);
+    if (!ldap.Connect(config.username, config.password, config.serverAddress))
+    {
+        std::wcerr << L"✗ Failed to connect to LDAP server." << std::endl;
+        return false;
+    }
+    Schema::Activate(&ldap, config, false);
+    Statistics stats;
+    return ldap.Search(query, outEntries, stats);
+}
+
+// Effective members of a group, effective groups of an account, or the closure report
+int RunGroupAnalysis(const SearchConfig& config, const std::vector<Entry>& entries, const std::wstring& groupName,
+    const std::wstring& accountName)
+{
+    auto start = std::chrono::steady_clock::now();
+    MembershipGraph graph;
+    graph.Build(entries);
+    std::wcout << L"  Membership graph: " << graph.VertexCount() << L" vertices, " << graph.EdgeCount()
+        << L" edges from " << entries.size() << L" entries in "
+        << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << L" ms" << std::endl;
+
+    std::vector<Entry> rows;
+    if (!groupName.empty() || !accountName.empty())
+    {
+        const std::wstring& name = groupName.empty() ? accountName : groupName;
+        unsigned int vertex = graph.Find(name);
+        if (vertex == MembershipGraph::npos)
+        {
+            std::wcerr << L"✗ " << name << L" is not in the result set." << std::endl;
+            return 1;
+        }
+
+        std::vector<MembershipGraph::Reach> reached = groupName.empty() ?
+            graph.EffectiveGroups(vertex) : graph.EffectiveMembers(vertex);
+        graph.PrintReach((groupName.empty() ? L"Effective groups of " : L"Effective members of ") + graph.Dn(vertex), reached);
+        rows = graph.ReachReport(reached);
+    }
+    else
+    {
+        auto closureStart = std::chrono::steady_clock::now();
+        std::vector<MembershipGraph::GroupSummary> summaries = graph.Summarize();
+        std::vector<std::vector<unsigned int>> cycles = graph.Cycles();
+        std::wcout << L"  Closure of " << summaries.size() << L" groups in "
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - closureStart).count()
+            << L" ms" << std::endl;
+        graph.PrintSummary(summaries, cycles);
+        rows = graph.SummaryReport(summaries);
+    }
+
+    if (config.format != OutputFormat::CONSOLE_ONLY && !rows.empty())
+    {
+        Statistics stats;
+        if (config.format == OutputFormat::HTML)
+            stats = StatisticsCalculator::CalculateParallel(rows);
+        if (!Exporter::Export(config, Exporter::AttributeNames(rows), rows, stats))
+            return 1;
+    }
+    return 0;
+}
+
+// Times the membership closure on a synthetic directory with nested groups and loops
+int RunGroupBenchmark(size_t count)
+{
+    std::mt19937 rng(11);
+    size_t groupCount = std::max<size_t>(10, count / 20);
+    std::wstring domainSid = L"S-1-5-21-1004336348-1177238915-682003330";
+    auto groupDn = [](size_t g) { return L"CN=Group" + std::to_wstring(g) + L",OU=Groups,DC=labrecon,DC=com"; };
+
+    std::vector<Entry> entries;
+    entries.reserve(count + groupCount);
+    for (size_t g = 0; g < groupCount; ++g)
+    {
+        Entry e;
+        e.dn = groupDn(g);
+        e.attrs[L"objectClass"] = { L"top", L"group" };
+        e.attrs[L"objectSid"] = { domainSid + L"-" + std::to_wstring(g == 0 ? 513 : 10000 + g) };
+        // A tree of nested groups, with a loop every thousand groups
+        if (g > 0)
+        {
+            size_t parent = rng() % g;
+            e.attrs[L"memberOf"] = { groupDn(parent) };
+            if (g % 1000 == 0)
+                e.attrs[L"member"] = { groupDn(parent) };
+        }
+        entries.push_back(std::move(e));
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        Entry e;
+        e.dn = L"CN=user" + std::to_wstring(i) + L",OU=Users,DC=labrecon,DC=com";
+        e.attrs[L"objectClass"] = { L"top", L"person", L"organizationalPerson", L"user" };
+        e.attrs[L"sAMAccountName"] = { L"user" + std::to_wstring(i) };
+        e.attrs[L"objectSid"] = { domainSid + L"-" + std::to_wstring(100000 + i) };
+        e.attrs[L"primaryGroupID"] = { L"513" };
+        std::vector<Value>& memberOf = e.attrs[L"memberOf"];
+        for (size_t n = 1 + rng() % 3; n > 0; --n)
+            memberOf.push_back(groupDn(1 + rng() % (groupCount - 1)));
+        entries.push_back(std::move(e));
+    }
+    std::wcout << L"Synthetic directory: " << count << L" accounts, " << groupCount << L" groups" << std::endl;
+
+    auto t0 = std::chrono::steady_clock::now();
+    MembershipGraph graph;
+    graph.Build(entries);
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<MembershipGraph::GroupSummary> serial = graph.Summarize(1);
+    auto t2 = std::chrono::steady_clock::now();
+    std::vector<MembershipGraph::GroupSummary> parallel = graph.Summarize();
+    auto t3 = std::chrono::steady_clock::now();
+    std::vector<std::vector<unsigned int>> cycles = graph.Cycles();
+    auto t4 = std::chrono::steady_clock::now();
+
+    bool identical = serial.size() == parallel.size();
+    for (size_t i = 0; identical && i < serial.size(); ++i)
+    {
+        identical = serial[i].effectiveMembers == parallel[i].effectiveMembers &&
+            serial[i].effectiveAccounts == parallel[i].effectiveAccounts &&
+            serial[i].nestingDepth == parallel[i].nestingDepth && serial[i].inCycle == parallel[i].inCycle;
+    }
+
+    std::wcout << L"  Build (CSR): " << std::chrono::duration<double, std::milli>(t1 - t0).count() << L" ms, "
+        << graph.EdgeCount() << L" edges (" << graph.PrimaryGroupEdges() << L" primary group)" << std::endl;
+    std::wcout << L"  Closure serial:   " << std::chrono::duration<double, std::milli>(t2 - t1).count() << L" ms" << std::endl;
+    std::wcout << L"  Closure parallel: " << std::chrono::duration<double, std::milli>(t3 - t2).count() << L" ms ("
+        << std::thread::hardware_concurrency() << L" threads)" << std::endl;
+    std::wcout << L"  Cycles: " << cycles.size() << L" in " << std::chrono::duration<double, std::milli>(t4 - t3).count()
+        << L" ms" << std::endl;
+    std::wcout << L"  Domain Users effective members: " << graph.EffectiveMembers(graph.Find(groupDn(0))).size() << std::endl;
+    std::wcout << L"  Results identical: " << (identical ? L"yes" : L"NO") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// Paged search against a modelled DC: each page costs a round trip plus per-entry
+// server and decode time, optionally growing with page size (large responses
+// buffered on the server), with some jitter
+struct SimulatedServer
+{
+    const wchar_t* name;
+    unsigned long maxPageSize;
+    double roundTripMs;
+    double serverPerEntryMs;
+    double decodePerEntryMs;
+    double knee;                // 0 = per-entry cost independent of page size
+};
+
+double SimulatePagedSearch(const SimulatedServer& server, size_t count, PageSizeTuner& tuner, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> jitter(0.92, 1.08);
+    double totalMs = 0;
+    size_t remaining = count;
+    while (remaining > 0)
+    {
+        PageSizeTuner::Page page;
+        page.requested = tuner.Next();
+        page.returned = static_cast<unsigned long>(std::min<size_t>(remaining, std::min(page.requested, server.maxPageSize)));
+        double n = page.returned;
+        page.serverMs = (server.roundTripMs + server.serverPerEntryMs * n * (server.knee > 0 ? 1 + n / server.knee : 1)) * jitter(rng);
+        page.decodeMs = server.decodePerEntryMs * n * jitter(rng);
+        remaining -= page.returned;
+        tuner.Record(page, remaining > 0);
+        totalMs += page.serverMs + page.decodeMs;
+    }
+    return totalMs;
+}
+
+// Compares the fixed 1000-entry page with adaptive paging on modelled servers
+int RunPagingBenchmark(size_t count)
+{
+    const SimulatedServer servers[] = {
+        { L"Narrow attributes, MaxPageSize 1000", 1000, 30, 0.01, 0.02, 0 },
+        { L"Narrow attributes, MaxPageSize 5000", 5000, 30, 0.01, 0.02, 0 },
+        { L"* on fat user objects", 1000, 30, 0.25, 0.35, 400 },
+        { L"WAN link (150 ms), MaxPageSize 5000", 5000, 150, 0.02, 0.03, 0 },
+    };
+
+    std::wcout << L"Paged search of " << count << L" entries against modelled servers" << std::endl;
+    std::wcout << std::left << std::setw(40) << L"Server" << std::right << std::setw(16) << L"Fixed 1000"
+        << std::setw(22) << L"Adaptive" << std::setw(10) << L"Gain" << std::endl;
+    for (const auto& server : servers)
+    {
+        std::mt19937 rng(7);
+        PageSizeTuner fixed(1000, server.maxPageSize, false);
+        double fixedMs = SimulatePagedSearch(server, count, fixed, rng);
+        PageSizeTuner adaptive(1000, server.maxPageSize, true);     // As read from the query policy
+        double adaptiveMs = SimulatePagedSearch(server, count, adaptive, rng);
+
+        std::wostringstream fixedCell, adaptiveCell;
+        fixedCell << std::fixed << std::setprecision(0) << fixedMs << L" ms/" << fixed.Pages().size() << L"p";
+        adaptiveCell << std::fixed << std::setprecision(0) << adaptiveMs << L" ms/" << adaptive.Pages().size()
+            << L"p @" << adaptive.Pages().back().requested;
+        std::wcout << std::left << std::setw(40) << server.name << std::right << std::setw(16) << fixedCell.str()
+            << std::setw(22) << adaptiveCell.str() << std::setw(9) << std::fixed << std::setprecision(1)
+            << (fixedMs / adaptiveMs) << L"x" << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
+
 void PrintUsage()
 {
     std::wcout << LR"(
@@ -29,16 +751,116 @@ SEARCH OPTIONS:
     -a, --attributes <attrs>   Comma-separated attributes or * for all (default: *)
     --scope <scope>            Search scope: base, one, sub (default: sub)
     --limit <number>           Size limit (default: 10000)
+    --sort <keys>              Server-side sort, e.g. sn,-whenCreated ('-' = descending)
+    --window <first>-<last>    Only rows first..last (1-based) of the sorted result,
+                               fetched in one round trip with a VLV control
+    --window-at <value>        VLV window starting at the first row whose first sort
+                               key is >= value
+    --window-size <n>          Rows for --window-at (default: 100)
+    --page-size <n>            Paged-results page size (default: 1000)
+    --adaptive-paging          Tune the page size from each page's server and decode
+                               time, up to the DC's MaxPageSize (each page's size
+                               and timing is logged unless output is quiet)
+    --bench-paging <count>     Compare fixed and adaptive paging on modelled servers
+    --schema-cache <file>      Attribute types read from the schema naming context,
+                               reused while no attributeSchema object changes and
+                               by --from-ldif (default: ldap_schema.cache). Each
+                               attribute is decoded by its syntax: integers,
+                               timestamps, SIDs, GUIDs and binary values
+    --no-schema                Decode values by attribute name only
 
 ADVANCED SEARCH:
     --search-dn <dn>           Search specific DN only
     --search-attr <attr>       Search by attribute name
     --search-value <value>     Search by attribute value (use with --search-attr)
 
+BATCH MODE:
+    --batch <file>             Run every query in <file> over pooled connections
+                               (one "-f ... -b ... -a ... -o ... -t ..." per line,
+                               or a JSON array of {filter, base, attributes, scope,
+                               limit, sort, window, output, format} objects)
+    --batch-parallel <n>       Concurrent queries / pooled connections (default: 4)
+
+SERVICE MODE:
+    --serve <port>             Keep bound connections open and answer
+                               GET http://127.0.0.1:<port>/search?base=&scope=&filter=
+                               &attrs=&limit=&sort=&window=&format=ndjson|csv
+                               &values=display|raw
+    --serve-pool <n>           Bound connections kept open (default: 4)
+    --cache-ttl <seconds>      Reuse identical query results for this long (default: 60)
+
+SNAPSHOTS AND SYNC:
+    --incremental <file>       Keep a local snapshot in <file> and fetch only entries
+                               changed since its stored uSNChanged high-water mark.
+                               The first run, or a change of DC, base DN or filter,
+                               does a full search. Searches with --scope like a
+                               normal search. Objects deleted, no longer matching
+                               the filter or moved out of the scope are dropped,
+                               found among the changes in the whole naming
+                               context. Use a new file when changing --scope.
+    --save-snapshot <file>     Also save the search result as a binary snapshot
+    --from-snapshot <file>     Answer from a saved snapshot instead of the directory
+                               (memory-mapped; works with --search-dn, --search-attr,
+                               --stats and every output format)
+    --from-ldif <file>         Same, reading an LDIF export (ldifde, ldapsearch)
+                               Offline queries evaluate -f/-b/--scope locally with AD
+                               semantics, including :1.2.840.113556.1.4.803:= and
+                               :1.2.840.113556.1.4.804:= bitwise rules
+    --bench-filter <count>     Benchmark offline filter evaluation on synthetic entries
+    --local-snapshot <file>    Answer --search-dn/--search-attr from this snapshot when
+                               it is fresh, covers the base DN and indexes the
+                               attribute; otherwise (or on no match) ask the directory
+    --max-age <seconds>        Freshness limit for --local-snapshot (default: 3600)
+    --index-attrs <attrs>      Equality-indexed attributes of saved snapshots (default:
+                               sAMAccountName,userPrincipalName,objectSid,objectGUID,mail)
+    --range-attrs <attrs>      Timestamp-indexed attributes of saved snapshots (default:
+                               whenCreated,whenChanged,lastLogonTimestamp,pwdLastSet)
+    --bench-index <count>      Benchmark snapshot index lookups on synthetic entries
+    --ou-counts                Print how many returned objects sit in each container
+                               (OU, CN or DC), from a DN tree built as pages arrive
+    --dirsync <cookie-file>    Use the DirSync control (requires the Replicating
+                               Directory Changes right and a partition root base DN).
+                               Alone: print/export only objects changed since the
+                               cookie, then save the new cookie. With --incremental:
+                               merge the changed attributes into the snapshot.
+
+GROUP MEMBERSHIP:
+    --group-members <group>    Effective (nested) members of a group, by DN or
+                               sAMAccountName, with the depth and group each is
+                               reached through
+    --member-of <account>      Every group an account is effectively in
+    --group-report             Direct/effective member counts, nesting depth and
+                               nesting loops for every group
+                               Built from member, memberOf and primaryGroupID of
+                               everything below the base DN (always a subtree
+                               search), or of the whole --from-snapshot /
+                               --from-ldif file. -o/-t export the
+                               rows in any output format.
+    --bench-groups <count>     Benchmark the membership closure on synthetic data
+
 OUTPUT OPTIONS:
     -o, --output <file>        Output file path
     -t, --type <format>        Output format: csv, txt, json, xml, html, console
                                (default: console)
+    --compress <codec>         gzip or none (default: none; gzip when -o ends in .gz).
+                               Compresses csv, txt, json and xml exports while they
+                               are written, on all cores
+    --values <style>           display or raw (default: display for csv, raw for json
+                               and xml). raw writes values as the directory holds
+                               them: 512 rather than 0x200 = ( NORMAL_ACCOUNT ),
+                               generalized time and FILETIME ticks, base64 binary.
+                               txt, html and the console always use display
+    --csv-sidecar              CSV: also write <file>.ldapcol, a binary columnar copy
+                               with dictionaries and sort orders that the CSV viewer
+                               (index.html) opens without parsing
+    --html-layout <layout>     auto, table, virtual or sharded (default: auto). virtual
+                               embeds the rows once as columnar JSON and renders only
+                               the visible ones; auto uses it above 2000 entries.
+                               sharded writes a directory named after -o with
+                               index.html and data shards loaded on demand
+    --shard-by <key>           Sharded reports: container, class or none (default:
+                               container)
+    --shard-rows <n>           Sharded reports: most entries per shard (default: 25000)
 
 OUTPUT FORMATS:
     csv      - CSV with UTF-8 BOM (Excel-compatible)
@@ -50,6 +872,14 @@ OUTPUT FORMATS:
 
 STATISTICS:
     --stats                    Show detailed statistics after search
+    --bench-stats <count>      Benchmark serial vs parallel statistics on synthetic entries
+    --bench-memory <count>     Attribute memory of synthetic entries, interned values
+                               against a string per value
+    --stats-profile <file>     Load statistics profile, one rule per line:
+                                 attribute = unique, histogram, cardinality, topk[:N],
+                                             flags, timehist[:day/week/month/90d/...]
+                               (default tracks lastLogonTimestamp, pwdLastSet,
+                               whenCreated, whenChanged ages and userAccountControl flags)
 
 EXAMPLES:
     # Export all entries to interactive HTML
@@ -79,6 +909,29 @@ int main(int argc, char* argv[])
 
     SearchConfig config;
     bool showStats = false;
+    size_t benchStatsCount = 0;
+    size_t benchMemoryCount = 0;
+    std::wstring batchFile;
+    unsigned int batchParallel = 4;
+    unsigned short servePort = 0;
+    size_t servePool = 4;
+    std::wstring incrementalFile;
+    std::wstring fromSnapshotFile;
+    std::wstring fromLdifFile;
+    size_t benchFilterCount = 0;
+    std::wstring saveSnapshotFile;
+    std::wstring localSnapshotFile;
+    long long snapshotMaxAge = 3600;
+    SnapshotIndexOptions indexOptions;
+    size_t benchIndexCount = 0;
+    bool showCounts = false;
+    std::wstring groupMembersOf;
+    std::wstring memberOfAccount;
+    bool groupReport = false;
+    size_t benchGroupsCount = 0;
+    size_t benchPagingCount = 0;
+    long long cacheTtlSeconds = 60;
+    bool compressOutput = false;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++)
@@ -120,19 +973,78 @@ int main(int argc, char* argv[])
         }
         else if ((arg == "-t" || arg == "--type") && i + 1 < argc)
         {
-            std::string typeStr = argv[++i];
-            if (typeStr == "csv") config.format = OutputFormat::CSV;
-            else if (typeStr == "txt") config.format = OutputFormat::TXT;
-            else if (typeStr == "json") config.format = OutputFormat::JSON;
-            else if (typeStr == "xml") config.format = OutputFormat::XML;
-            else if (typeStr == "html") config.format = OutputFormat::HTML;
-            else if (typeStr == "console") config.format = OutputFormat::CONSOLE_ONLY;
+            std::wstring typeStr = Converters::StringToWString(argv[++i]);
+            if (!Exporter::ParseFormat(typeStr, config.format))
+            {
+                std::wcerr << L"Unknown format: " << typeStr << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--compress" && i + 1 < argc)
+        {
+            std::string codecStr = argv[++i];
+            if (codecStr == "gzip") compressOutput = true;
+            else if (codecStr == "none") compressOutput = false;
+            else
+            {
+                std::wcerr << L"Unknown compression: " << Converters::StringToWString(codecStr)
+                    << L" (supported: gzip, none)" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--values" && i + 1 < argc)
+        {
+            std::string styleStr = argv[++i];
+            if (styleStr == "display") config.valueStyle = ValueStyle::DISPLAY;
+            else if (styleStr == "raw") config.valueStyle = ValueStyle::RAW;
             else
             {
-                std::wcerr << L"Unknown format: " << Converters::StringToWString(typeStr) << std::endl;
+                std::wcerr << L"Unknown value style: " << Converters::StringToWString(styleStr)
+                    << L" (supported: display, raw)" << std::endl;
                 return 1;
             }
         }
+        else if (arg == "--schema-cache" && i + 1 < argc)
+        {
+            config.schemaCacheFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--no-schema")
+        {
+            config.loadSchema = false;
+        }
+        else if (arg == "--csv-sidecar")
+        {
+            config.columnarSidecar = true;
+        }
+        else if (arg == "--html-layout" && i + 1 < argc)
+        {
+            std::string layoutStr = argv[++i];
+            if (layoutStr == "auto") config.htmlLayout = HtmlLayout::AUTO;
+            else if (layoutStr == "table") config.htmlLayout = HtmlLayout::TABLE;
+            else if (layoutStr == "virtual") config.htmlLayout = HtmlLayout::VIRTUAL;
+            else if (layoutStr == "sharded") config.htmlLayout = HtmlLayout::SHARDED;
+            else
+            {
+                std::wcerr << L"Unknown HTML layout: " << Converters::StringToWString(layoutStr) << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--shard-by" && i + 1 < argc)
+        {
+            std::string keyStr = argv[++i];
+            if (keyStr == "container") config.htmlShardBy = HtmlShardKey::CONTAINER;
+            else if (keyStr == "class") config.htmlShardBy = HtmlShardKey::OBJECT_CLASS;
+            else if (keyStr == "none") config.htmlShardBy = HtmlShardKey::NONE;
+            else
+            {
+                std::wcerr << L"Unknown shard key: " << Converters::StringToWString(keyStr) << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--shard-rows" && i + 1 < argc)
+        {
+            config.htmlShardRows = std::stoul(argv[++i]);
+        }
         else if (arg == "--scope" && i + 1 < argc)
         {
             std::string scopeStr = argv[++i];
@@ -144,6 +1056,41 @@ int main(int argc, char* argv[])
         {
             config.sizeLimit = std::stoi(argv[++i]);
         }
+        else if (arg == "--page-size" && i + 1 < argc)
+        {
+            config.pageSize = std::stoul(argv[++i]);
+        }
+        else if (arg == "--adaptive-paging")
+        {
+            config.adaptivePaging = true;
+        }
+        else if (arg == "--bench-paging" && i + 1 < argc)
+        {
+            benchPagingCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--sort" && i + 1 < argc)
+        {
+            config.sortKeys = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--window" && i + 1 < argc)
+        {
+            if (!LDAPConnection::ParseWindow(Converters::StringToWString(argv[++i]), config))
+            {
+                std::wcerr << L"✗ --window expects <first>-<last>, e.g. 10000-10100" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--window-at" && i + 1 < argc)
+        {
+            config.windowValue = Converters::StringToWString(argv[++i]);
+            config.windowOffset = 0;
+            if (config.windowSize == 0)
+                config.windowSize = 100;
+        }
+        else if (arg == "--window-size" && i + 1 < argc)
+        {
+            config.windowSize = std::stoul(argv[++i]);
+        }
         else if (arg == "--search-dn" && i + 1 < argc)
         {
             config.searchMode = SearchMode::BY_DN;
@@ -161,21 +1108,210 @@ int main(int argc, char* argv[])
         else if (arg == "--stats")
         {
             showStats = true;
+            config.showStats = true;
         }
+        else if (arg == "--batch" && i + 1 < argc)
+        {
+            batchFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--batch-parallel" && i + 1 < argc)
+        {
+            batchParallel = static_cast<unsigned int>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--serve" && i + 1 < argc)
+        {
+            servePort = static_cast<unsigned short>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--serve-pool" && i + 1 < argc)
+        {
+            servePool = std::stoul(argv[++i]);
+        }
+        else if (arg == "--cache-ttl" && i + 1 < argc)
+        {
+            cacheTtlSeconds = std::stoll(argv[++i]);
+        }
+        else if (arg == "--bench-stats" && i + 1 < argc)
+        {
+            benchStatsCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--bench-memory" && i + 1 < argc)
+        {
+            benchMemoryCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--incremental" && i + 1 < argc)
+        {
+            incrementalFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--from-snapshot" && i + 1 < argc)
+        {
+            fromSnapshotFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--from-ldif" && i + 1 < argc)
+        {
+            fromLdifFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--bench-filter" && i + 1 < argc)
+        {
+            benchFilterCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--save-snapshot" && i + 1 < argc)
+        {
+            saveSnapshotFile = Converters::StringToWString(argv[++i]);
+            config.collectEntries = true;
+        }
+        else if (arg == "--local-snapshot" && i + 1 < argc)
+        {
+            localSnapshotFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--max-age" && i + 1 < argc)
+        {
+            snapshotMaxAge = std::stoll(argv[++i]);
+        }
+        else if ((arg == "--index-attrs" || arg == "--range-attrs") && i + 1 < argc)
+        {
+            std::vector<std::wstring>& list = arg == "--index-attrs" ? indexOptions.equality : indexOptions.range;
+            list.clear();
+            std::wstringstream ss(Converters::StringToWString(argv[++i]));
+            std::wstring attr;
+            while (std::getline(ss, attr, L','))
+            {
+                attr.erase(0, attr.find_first_not_of(L" \t"));
+                attr.erase(attr.find_last_not_of(L" \t") + 1);
+                if (!attr.empty()) list.push_back(attr);
+            }
+        }
+        else if (arg == "--group-members" && i + 1 < argc)
+        {
+            groupMembersOf = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--member-of" && i + 1 < argc)
+        {
+            memberOfAccount = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--group-report")
+        {
+            groupReport = true;
+        }
+        else if (arg == "--bench-groups" && i + 1 < argc)
+        {
+            benchGroupsCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--ou-counts")
+        {
+            showCounts = true;
+        }
+        else if (arg == "--bench-index" && i + 1 < argc)
+        {
+            benchIndexCount = std::stoul(argv[++i]);
+        }
+        else if (arg == "--dirsync" && i + 1 < argc)
+        {
+            config.dirSyncCookieFile = Converters::StringToWString(argv[++i]);
+        }
+        else if (arg == "--stats-profile" && i + 1 < argc)
+        {
+            config.statsProfileFile = Converters::StringToWString(argv[++i]);
+        }
+    }
+
+    if (!config.statsProfileFile.empty())
+    {
+        StatisticsProfile profile;
+        if (!StatisticsProfile::LoadFromFile(config.statsProfileFile, profile))
+        {
+            return 1;
+        }
+        StatisticsProfile::SetActive(profile);
+    }
+
+    if (benchStatsCount > 0)
+    {
+        return RunStatisticsBenchmark(benchStatsCount);
+    }
+
+    if (benchMemoryCount > 0)
+    {
+        return RunMemoryBenchmark(benchMemoryCount);
+    }
+
+    if (benchFilterCount > 0)
+    {
+        return RunFilterBenchmark(benchFilterCount);
+    }
+
+    if (benchPagingCount > 0)
+    {
+        return RunPagingBenchmark(benchPagingCount);
+    }
+
+    if (benchGroupsCount > 0)
+    {
+        return RunGroupBenchmark(benchGroupsCount);
+    }
+
+    if (benchIndexCount > 0)
+    {
+        return RunIndexBenchmark(benchIndexCount);
+    }
+
+    if (!batchFile.empty())
+    {
+        std::vector<SearchConfig> queries;
+        if (!BatchRunner::LoadQueries(batchFile, config, queries))
+        {
+            return 1;
+        }
+        std::wcout << L"Running " << queries.size() << L" batch queries against " << config.serverAddress
+            << L" (up to " << batchParallel << L" concurrently)" << std::endl;
+        return BatchRunner::Run(config, queries, batchParallel) == 0 ? 0 : 1;
+    }
+
+    if (servePort != 0)
+    {
+        QueryService service(config, std::chrono::seconds(cacheTtlSeconds));
+        return service.Run(servePort, servePool) ? 0 : 1;
     }
 
     // Auto-generate output filename
     if (config.format != OutputFormat::CONSOLE_ONLY && config.outputFile.empty())
     {
-        switch (config.format)
+        config.outputFile = Exporter::DefaultFileName(config.format);
+    }
+    if (compressOutput && !OutputFile::IsCompressed(config.outputFile))
+        config.outputFile += L".gz";
+    if (config.format == OutputFormat::HTML && OutputFile::IsCompressed(config.outputFile))
+    {
+        std::wcerr << L"HTML reports are not compressed; use csv, txt, json or xml" << std::endl;
+        return 1;
+    }
+
+    if (!groupMembersOf.empty() || !memberOfAccount.empty() || groupReport)
+    {
+        std::vector<Entry> entries;
+        if (!LoadGroupSource(config, fromSnapshotFile, fromLdifFile, entries))
+            return 1;
+        return RunGroupAnalysis(config, entries, groupMembersOf, memberOfAccount);
+    }
+
+    if (!fromSnapshotFile.empty() || !fromLdifFile.empty())
+    {
+        bool isLdif = fromSnapshotFile.empty();
+        return RunOffline(config, isLdif ? fromLdifFile : fromSnapshotFile, isLdif, showStats, showCounts);
+    }
+
+    if (!localSnapshotFile.empty() && config.searchMode != SearchMode::STANDARD && incrementalFile.empty())
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Entry> results;
+        if (LookupInSnapshot(config, localSnapshotFile, snapshotMaxAge, results))
         {
-        case OutputFormat::CSV: config.outputFile = L"ldap_results.csv"; break;
-        case OutputFormat::TXT: config.outputFile = L"ldap_results.txt"; break;
-        case OutputFormat::JSON: config.outputFile = L"ldap_results.json"; break;
-        case OutputFormat::XML: config.outputFile = L"ldap_results.xml"; break;
-        case OutputFormat::HTML: config.outputFile = L"ldap_results.html"; break;
-        default: break;
+            std::wcout << L"✓ Answered from snapshot " << localSnapshotFile << L" in "
+                << std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count()
+                << L" us (" << results.size() << L" entries)" << std::endl;
+            OutputResults(config, results, showStats);
+            return 0;
         }
+        std::wcout << L"  Snapshot cannot answer this lookup; asking the directory." << std::endl;
     }
 
     std::wcout << L"╔═══════════════════════════════════════════════════════════════╗" << std::endl;
@@ -199,6 +1335,8 @@ int main(int argc, char* argv[])
     {
         std::wcout << L"  Filter: " << config.filter << std::endl;
         std::wcout << L"  Attributes: " << (config.attributesStr == L"*" ? L"All (*)" : config.attributesStr) << std::endl;
+        if (!config.dirSyncCookieFile.empty())
+            std::wcout << L"  DirSync cookie: " << config.dirSyncCookieFile << std::endl;
     }
 
     if (config.format != OutputFormat::CONSOLE_ONLY)
@@ -211,33 +1349,57 @@ int main(int argc, char* argv[])
 
     if (ldap.Connect(config.username, config.password, config.serverAddress))
     {
-        std::wcout << L"✓ Successfully connected to LDAP server." << std::endl << std::endl;
+        std::wcout << L"✓ Successfully connected to LDAP server." << std::endl;
+        Schema::Activate(&ldap, config, true);
+        std::wcout << std::endl;
 
         std::vector<Entry> entries;
         Statistics stats;
+        bool succeeded = true;
 
-        if (config.searchMode == SearchMode::BY_DN)
+        if (!incrementalFile.empty())
+        {
+            Snapshot snapshot;
+            snapshot.indexOptions = indexOptions;
+            SyncSummary summary;
+            if (!IncrementalSync::Run(ldap, config, incrementalFile, snapshot, summary))
+            {
+                std::wcerr << L"✗ Incremental sync failed." << std::endl;
+                return 1;
+            }
+            IncrementalSync::PrintSummary(summary, snapshot.Size());
+
+            stats = StatisticsCalculator::CalculateParallel(snapshot.Entries());
+            if (showStats)
+            {
+                StatisticsCalculator::PrintStatistics(stats);
+            }
+            if (config.format != OutputFormat::CONSOLE_ONLY)
+            {
+                std::vector<std::wstring> exportAttributes = Exporter::AttributeNames(snapshot.Entries());
+                succeeded = Exporter::Export(config, exportAttributes, snapshot.Entries(), stats);
+            }
+            if (showCounts)
+            {
+                DnTree tree;
+                for (size_t i = 0; i < snapshot.Size(); ++i)
+                    tree.Insert(snapshot.Entries()[i].dn, i);
+                DnTree::PrintCounts(tree.Counts(config.baseDN));
+            }
+        }
+        else if (config.searchMode == SearchMode::BY_DN)
         {
             Entry entry;
             if (ldap.SearchByDN(config.searchDN, entry))
             {
                 std::wcout << L"\n✓ Found entry for DN: " << config.searchDN << std::endl;
-                std::wcout << L"\nAttributes:" << std::endl;
-                for (const auto& attr : entry.attrs)
-                {
-                    std::wcout << L"  " << attr.first << L": ";
-                    for (size_t i = 0; i < attr.second.size(); ++i)
-                    {
-                        if (i > 0) std::wcout << L"; ";
-                        std::wcout << attr.second[i];
-                    }
-                    std::wcout << std::endl;
-                }
+                PrintEntry(entry);
                 entries.push_back(entry);
             }
             else
             {
                 std::wcerr << L"✗ DN not found or error occurred." << std::endl;
+                succeeded = false;
             }
         }
         else if (config.searchMode == SearchMode::BY_ATTRIBUTE)
@@ -246,14 +1408,35 @@ int main(int argc, char* argv[])
         }
         else
         {
-            ldap.Search(config, entries, stats);
+            DnTree tree;
+            succeeded = ldap.Search(config, entries, stats, showCounts ? &tree : nullptr);
+            if (showCounts)
+                DnTree::PrintCounts(tree.Counts(config.baseDN));
         }
 
-        if (showStats && !entries.empty())
+        // A failed search leaves no or partial results; keep the last good snapshot
+        if (!succeeded)
         {
-            stats = StatisticsCalculator::Calculate(entries);
+            std::wcerr << L"✗ Search or export failed." << std::endl;
+            return 1;
+        }
+
+        // Search printed the statistics it accumulated; DN and attribute lookups did not
+        if (showStats && !entries.empty() && incrementalFile.empty() && config.searchMode != SearchMode::STANDARD)
+        {
+            stats = StatisticsCalculator::CalculateParallel(entries);
             StatisticsCalculator::PrintStatistics(stats);
         }
+
+        if (!saveSnapshotFile.empty() && incrementalFile.empty())
+        {
+            SyncState source;
+            source.server = config.serverAddress;
+            source.baseDN = config.baseDN;
+            source.filter = config.filter;
+            if (Snapshot::Save(saveSnapshotFile, source, entries, indexOptions))
+                std::wcout << L"✓ Saved " << entries.size() << L" entries to snapshot " << saveSnapshotFile << std::endl;
+        }
     }
     else
     {